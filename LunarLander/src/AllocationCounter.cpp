@@ -0,0 +1,63 @@
+#include "AllocationCounter.h"
+
+#ifdef LUNAR_TRACK_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> allocationCount(0);
+
+void* operator new(size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	void* block = malloc(size ? size : 1);
+	if (!block)
+		throw std::bad_alloc();
+	return block;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* block) noexcept
+{
+	free(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+	free(block);
+}
+
+void operator delete(void* block, size_t) noexcept
+{
+	free(block);
+}
+
+void operator delete[](void* block, size_t) noexcept
+{
+	free(block);
+}
+
+bool AllocationCounter::IsEnabled()
+{
+	return true;
+}
+
+uint64_t AllocationCounter::GetCount()
+{
+	return allocationCount.load(std::memory_order_relaxed);
+}
+#else
+bool AllocationCounter::IsEnabled()
+{
+	return false;
+}
+
+uint64_t AllocationCounter::GetCount()
+{
+	return 0;
+}
+#endif
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+//Counts the heap allocations of the whole process by replacing the global operator new, for proving a
+//code path allocates nothing. Only compiled in with LUNAR_TRACK_ALLOCATIONS (make HeadlessAllocations),
+//otherwise the count stays 0.
+class AllocationCounter
+{
+public:
+
+	static bool IsEnabled();
+	static uint64_t GetCount();
+};
@@ -0,0 +1,348 @@
+#include "BatchLanderSim.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const int Width = 4;	//Landers per SIMD group
+
+#ifdef LUNAR_SSE2
+//sin and cos of four angles at once, Cephes' single precision range reduction and polynomials
+static inline void SinCos(__m128 x, __m128& s, __m128& c)
+{
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+	__m128 signSin = _mm_and_ps(x, signMask);
+	x = _mm_andnot_ps(signMask, x);
+
+	//Octant of |x|, rounded up to even so x lands in [-pi/4, pi/4]
+	__m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+	octant = _mm_and_si128(_mm_add_epi32(octant, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+	__m128 y = _mm_cvtepi32_ps(octant);
+	__m128 swapSignSin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29));
+	__m128 direct = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+	__m128 signCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+	signSin = _mm_xor_ps(signSin, swapSignSin);
+
+	//x - y * pi/4 in three parts, so the reduction stays exact
+	x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+	x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+	x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
+	__m128 z = _mm_mul_ps(x, x);
+
+	__m128 cosPoly = _mm_set1_ps(2.443315711809948e-5f);
+	cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(-1.388731625493765e-3f));
+	cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+	cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+	cosPoly = _mm_add_ps(_mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(.5f))), _mm_set1_ps(1.f));
+
+	__m128 sinPoly = _mm_set1_ps(-1.9515295891e-4f);
+	sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(8.3321608736e-3f));
+	sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+	sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), x), x);
+
+	//Every other quadrant swaps the two
+	s = _mm_or_ps(_mm_and_ps(direct, sinPoly), _mm_andnot_ps(direct, cosPoly));
+	c = _mm_or_ps(_mm_and_ps(direct, cosPoly), _mm_andnot_ps(direct, sinPoly));
+	s = _mm_xor_ps(s, signSin);
+	c = _mm_xor_ps(c, signCos);
+}
+
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
+BatchLanderModel BatchLanderModel::FromSimulation(Simulation& simulation)
+{
+	BatchLanderModel model;
+	b2Body* body = simulation.GetLander(0)->GetBody();
+	model.mass = body->GetMass();
+	model.invMass = model.mass > 0.f ? 1.f / model.mass : 0.f;
+	model.localCenter = body->GetLocalCenter();
+	//Box2D reports the inertia about the body origin
+	float inertia = body->GetInertia() - model.mass * model.localCenter.LengthSquared();
+	model.invInertia = inertia > 0.f ? 1.f / inertia : 0.f;
+	model.gravity = simulation.GetWorld()->getWorld()->GetGravity();
+	model.linearDamping = body->GetLinearDamping();
+	model.angularDamping = body->GetAngularDamping();
+	model.timeStep = simulation.GetTimeStep();
+	for (b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext())
+	{
+		if (fixture->GetShape()->GetType() != b2Shape::e_polygon)
+			continue;
+		const b2PolygonShape* shape = (const b2PolygonShape*)fixture->GetShape();
+		std::vector<b2Vec2>& points = fixture->GetFilterData().categoryBits == ContactTag::TagLanderLegs ? model.legPoints : model.hullPoints;
+		for (int i = 0; i < shape->m_count; i++)
+		{
+			b2Vec2 point = shape->m_vertices[i] - model.localCenter;
+			points.push_back(point);
+			model.radius = std::max(model.radius, point.Length());
+		}
+	}
+	return model;
+}
+
+void BatchLanderSim::Setup(const BatchLanderModel& model, const TerrainHeightField* terrain, int count, const BatchLanderParams& params)
+{
+	this->model = model;
+	this->terrain = terrain;
+	this->params = params;
+	this->count = count;
+	paddedCount = (count + Width - 1) / Width * Width;
+	for (std::vector<float>* lane : { &x, &y, &angle, &vx, &vy, &w, &thrust, &torque, &fuel, &flying })
+	{
+		lane->assign(paddedCount, 0.f);
+	}
+	outcomes.assign(paddedCount, BatchLanderOutcome::Flying);
+	endSteps.assign(paddedCount, 0);
+	stepCount = 0;
+	flyingCount = 0;
+}
+
+void BatchLanderSim::Reset(const LanderParams& landerParams)
+{
+	for (int i = 0; i < count; i++)
+	{
+		Reset(i, screenPtToWorldPt(landerParams.startingPos), 0.f, b2Vec2(landerParams.startVelocity, 0.f));
+	}
+	stepCount = 0;
+}
+
+void BatchLanderSim::Reset(int idx, b2Vec2 position, float angle, b2Vec2 velocity)
+{
+	float s = sin(angle), c = cos(angle);
+	x[idx] = position.x + c * model.localCenter.x - s * model.localCenter.y;
+	y[idx] = position.y + s * model.localCenter.x + c * model.localCenter.y;
+	this->angle[idx] = angle;
+	vx[idx] = velocity.x;
+	vy[idx] = velocity.y;
+	w[idx] = 0.f;
+	thrust[idx] = 0.f;
+	torque[idx] = 0.f;
+	fuel[idx] = 0.f;
+	if (flying[idx] == 0.f)
+		flyingCount++;
+	flying[idx] = 1.f;
+	outcomes[idx] = BatchLanderOutcome::Flying;
+	endSteps[idx] = 0;
+}
+
+void BatchLanderSim::Step(const LanderControls* controls)
+{
+	stepCount++;
+	for (int first = 0; first < paddedCount; first += Width)
+	{
+		Integrate(first, controls);
+	}
+}
+
+void BatchLanderSim::Integrate(int first, const LanderControls* controls)
+{
+	//The controls are per lander, like Simulation::Step applies them
+	int last = std::min(first + Width, count);
+	for (int i = first; i < last; i++)
+	{
+		if (flying[i] == 0.f)
+			continue;
+		thrust[i] = std::max(thrust[i] + controls[i].thrustDelta, 0.f);
+		torque[i] = controls[i].rotationRate;
+	}
+
+	float h = model.timeStep;
+	float linearDampingFactor = 1.f / (1.f + h * model.linearDamping);
+	float angularDampingFactor = 1.f / (1.f + h * model.angularDamping);
+	float reach = model.radius + params.contactSkin;
+	float groundTop = terrain->GetTop() - reach;
+	float wallLeft = reach;
+	float wallRight = terrain->GetWidth() - reach;
+#ifdef LUNAR_SSE2
+	__m128 live = _mm_cmpgt_ps(_mm_loadu_ps(&flying[first]), _mm_setzero_ps());
+	__m128 px = _mm_loadu_ps(&x[first]);
+	__m128 py = _mm_loadu_ps(&y[first]);
+	__m128 pa = _mm_loadu_ps(&angle[first]);
+	__m128 lvx = _mm_loadu_ps(&vx[first]);
+	__m128 lvy = _mm_loadu_ps(&vy[first]);
+	__m128 av = _mm_loadu_ps(&w[first]);
+	__m128 strength = _mm_loadu_ps(&thrust[first]);
+	__m128 hv = _mm_set1_ps(h);
+
+	//Lander::Update: the thrust pushes along the lander's up axis, the rotation rate is a torque
+	__m128 s, c;
+	SinCos(pa, s, c);
+	__m128 fx = _mm_mul_ps(s, strength);
+	__m128 fy = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(c, strength));
+
+	//b2Island::Solve, in the same order of operations
+	__m128 invMass = _mm_set1_ps(model.invMass);
+	__m128 nvx = _mm_add_ps(lvx, _mm_mul_ps(hv, _mm_add_ps(_mm_set1_ps(model.gravity.x), _mm_mul_ps(invMass, fx))));
+	__m128 nvy = _mm_add_ps(lvy, _mm_mul_ps(hv, _mm_add_ps(_mm_set1_ps(model.gravity.y), _mm_mul_ps(invMass, fy))));
+	__m128 nw = _mm_add_ps(av, _mm_mul_ps(_mm_mul_ps(hv, _mm_set1_ps(model.invInertia)), _mm_loadu_ps(&torque[first])));
+	nvx = _mm_mul_ps(nvx, _mm_set1_ps(linearDampingFactor));
+	nvy = _mm_mul_ps(nvy, _mm_set1_ps(linearDampingFactor));
+	nw = _mm_mul_ps(nw, _mm_set1_ps(angularDampingFactor));
+
+	//Box2D caps the motion of one step
+	__m128 tx = _mm_mul_ps(hv, nvx);
+	__m128 ty = _mm_mul_ps(hv, nvy);
+	__m128 translation2 = _mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty));
+	__m128 tooFar = _mm_cmpgt_ps(translation2, _mm_set1_ps(b2_maxTranslation * b2_maxTranslation));
+	__m128 ratio = _mm_div_ps(_mm_set1_ps(b2_maxTranslation), _mm_sqrt_ps(translation2));
+	nvx = Select(tooFar, _mm_mul_ps(nvx, ratio), nvx);
+	nvy = Select(tooFar, _mm_mul_ps(nvy, ratio), nvy);
+	__m128 rotation = _mm_mul_ps(hv, nw);
+	__m128 tooFast = _mm_cmpgt_ps(_mm_mul_ps(rotation, rotation), _mm_set1_ps(b2_maxRotation * b2_maxRotation));
+	__m128 absRotation = _mm_andnot_ps(_mm_castsi128_ps(_mm_set1_epi32((int)0x80000000)), rotation);
+	nw = Select(tooFast, _mm_mul_ps(nw, _mm_div_ps(_mm_set1_ps(b2_maxRotation), absRotation)), nw);
+
+	px = Select(live, _mm_add_ps(px, _mm_mul_ps(hv, nvx)), px);
+	py = Select(live, _mm_add_ps(py, _mm_mul_ps(hv, nvy)), py);
+	pa = Select(live, _mm_add_ps(pa, _mm_mul_ps(hv, nw)), pa);
+	_mm_storeu_ps(&x[first], px);
+	_mm_storeu_ps(&y[first], py);
+	_mm_storeu_ps(&angle[first], pa);
+	_mm_storeu_ps(&vx[first], Select(live, nvx, lvx));
+	_mm_storeu_ps(&vy[first], Select(live, nvy, lvy));
+	_mm_storeu_ps(&w[first], Select(live, nw, av));
+	__m128 used = _mm_loadu_ps(&fuel[first]);
+	_mm_storeu_ps(&fuel[first], Select(live, _mm_add_ps(used, _mm_mul_ps(strength, hv)), used));
+
+	//Only landers that could reach the ground or a wall get their corners tested
+	__m128 nearby = _mm_cmpge_ps(py, _mm_set1_ps(groundTop));
+	if (params.bounded)
+	{
+		nearby = _mm_or_ps(nearby, _mm_cmple_ps(px, _mm_set1_ps(wallLeft)));
+		nearby = _mm_or_ps(nearby, _mm_cmpge_ps(px, _mm_set1_ps(wallRight)));
+		nearby = _mm_or_ps(nearby, _mm_cmple_ps(py, _mm_set1_ps(reach)));
+	}
+	int nearMask = _mm_movemask_ps(_mm_and_ps(nearby, live));
+	for (int lane = 0; nearMask; lane++, nearMask >>= 1)
+	{
+		if (nearMask & 1)
+			TestContacts(first + lane);
+	}
+#else
+	for (int i = first; i < first + Width; i++)
+	{
+		if (flying[i] == 0.f)
+			continue;
+		float fx = sin(angle[i]) * thrust[i];
+		float fy = -cos(angle[i]) * thrust[i];
+		vx[i] = (vx[i] + h * (model.gravity.x + model.invMass * fx)) * linearDampingFactor;
+		vy[i] = (vy[i] + h * (model.gravity.y + model.invMass * fy)) * linearDampingFactor;
+		w[i] = (w[i] + h * model.invInertia * torque[i]) * angularDampingFactor;
+		float translation2 = h * h * (vx[i] * vx[i] + vy[i] * vy[i]);
+		if (translation2 > b2_maxTranslation * b2_maxTranslation)
+		{
+			float ratio = b2_maxTranslation / sqrt(translation2);
+			vx[i] *= ratio;
+			vy[i] *= ratio;
+		}
+		float rotation = h * w[i];
+		if (rotation * rotation > b2_maxRotation * b2_maxRotation)
+			w[i] *= b2_maxRotation / fabs(rotation);
+		x[i] += h * vx[i];
+		y[i] += h * vy[i];
+		angle[i] += h * w[i];
+		fuel[i] += thrust[i] * h;
+		if (y[i] >= groundTop || (params.bounded && (x[i] <= wallLeft || x[i] >= wallRight || y[i] <= reach)))
+			TestContacts(i);
+	}
+#endif
+}
+
+void BatchLanderSim::TestContacts(int idx)
+{
+	float s = sin(angle[idx]), c = cos(angle[idx]);
+	float skin = params.contactSkin;
+	float width = terrain->GetWidth();
+	bool hull = false, legs = false, offPad = false, outside = false;
+	for (const b2Vec2& point : model.hullPoints)
+	{
+		float px = x[idx] + c * point.x - s * point.y;
+		float py = y[idx] + s * point.x + c * point.y;
+		hull |= py + skin >= terrain->GetHeight(px);
+		outside |= px <= skin || px >= width - skin || py <= skin;
+	}
+	for (const b2Vec2& point : model.legPoints)
+	{
+		float px = x[idx] + c * point.x - s * point.y;
+		float py = y[idx] + s * point.x + c * point.y;
+		if (py + skin >= terrain->GetHeight(px))
+		{
+			legs = true;
+			offPad |= !terrain->IsPad(px);
+		}
+		outside |= px <= skin || px >= width - skin || py <= skin;
+	}
+	outside &= params.bounded;
+	if (!hull && !legs && !outside)
+		return;
+
+	BatchLanderOutcome outcome;
+	if (hull)
+		outcome = BatchLanderOutcome::Crashed;
+	else if (legs)
+	{
+		float speed = sqrt(vx[idx] * vx[idx] + vy[idx] * vy[idx]);
+		float tilt = fabs(remainder(angle[idx], TWO_PI));
+		outcome = !offPad && speed <= params.landingSpeed && tilt <= params.landingAngle ? BatchLanderOutcome::Landed : BatchLanderOutcome::TouchedDown;
+	}
+	else
+		outcome = BatchLanderOutcome::OutOfBounds;
+	outcomes[idx] = outcome;
+	endSteps[idx] = stepCount;
+	flying[idx] = 0.f;
+	flyingCount--;
+}
+
+int BatchLanderSim::GetCount()
+{
+	return count;
+}
+
+int BatchLanderSim::GetFlyingCount()
+{
+	return flyingCount;
+}
+
+uint64_t BatchLanderSim::GetStepCount()
+{
+	return stepCount;
+}
+
+b2Vec2 BatchLanderSim::GetPosition(int idx)
+{
+	float s = sin(angle[idx]), c = cos(angle[idx]);
+	return b2Vec2(x[idx] - (c * model.localCenter.x - s * model.localCenter.y), y[idx] - (s * model.localCenter.x + c * model.localCenter.y));
+}
+
+float BatchLanderSim::GetAngle(int idx)
+{
+	return angle[idx];
+}
+
+b2Vec2 BatchLanderSim::GetLinearVelocity(int idx)
+{
+	return b2Vec2(vx[idx], vy[idx]);
+}
+
+float BatchLanderSim::GetThrusterStrength(int idx)
+{
+	return thrust[idx];
+}
+
+float BatchLanderSim::GetFuelUsed(int idx)
+{
+	return fuel[idx];
+}
+
+BatchLanderOutcome BatchLanderSim::GetOutcome(int idx)
+{
+	return outcomes[idx];
+}
+
+uint32_t BatchLanderSim::GetEndStep(int idx)
+{
+	return endSteps[idx];
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Simulation.h"
+#include "TerrainHeightField.h"
+
+//How a lander of the batch ended
+enum class BatchLanderOutcome : uint8_t {
+	Flying,
+	Landed,	//Legs down on a landing plateau, slow and upright
+	TouchedDown,	//Legs down anywhere else, or too fast or tilted
+	Crashed,	//The hull touched the ground
+	OutOfBounds,	//Reached a wall or the ceiling of the arena
+};
+
+//Rigid body data of the lander as Box2D has it, shared by the whole batch
+struct BatchLanderModel {
+	float mass = 1.f;
+	float invMass = 1.f;
+	float invInertia = 1.f;	//About the center of mass
+	b2Vec2 localCenter = b2Vec2(0.f, 0.f);	//Center of mass relative to the body origin
+	b2Vec2 gravity = b2Vec2(0.f, 0.f);
+	float linearDamping = 0.f;
+	float angularDamping = 0.f;
+	float timeStep = 1.f / 60.f;
+	std::vector<b2Vec2> hullPoints;	//Corners of the fixtures relative to the center of mass
+	std::vector<b2Vec2> legPoints;
+	float radius = 0.f;	//Of everything around the center of mass
+
+	//Reads it off the first lander of a simulation that has been set up
+	static BatchLanderModel FromSimulation(Simulation& simulation);
+};
+
+struct BatchLanderParams {
+	float landingSpeed = 1.f;	//World units per second
+	float landingAngle = .25f;	//Radians off upright
+	float contactSkin = 2.f * b2_polygonRadius;	//Box2D starts solving contacts this far from the ground
+	bool bounded = true;	//The arena has walls and a ceiling, as without streaming terrain
+};
+
+//Thousands of landers in structure-of-arrays form, stepped with the force, torque and damping model of
+//Lander::Update and Box2D's island integrator, four at a time with SSE2. Nothing collides with anything
+//but the height field of the level, and the first touch ends a lander's rollout; that is all policy search
+//needs, at a fraction of the cost of a b2World per rollout. Free flight follows Box2D to float rounding.
+class BatchLanderSim
+{
+	BatchLanderModel model;
+	BatchLanderParams params;
+	const TerrainHeightField* terrain = nullptr;
+	int count = 0;
+	int paddedCount = 0;	//count rounded up to the SIMD width, the extra lanes never fly
+	uint64_t stepCount = 0;
+	int flyingCount = 0;
+
+	//Center of mass in world units, so integrating needs no rotation
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> angle;
+	std::vector<float> vx;
+	std::vector<float> vy;
+	std::vector<float> w;
+	std::vector<float> thrust;
+	std::vector<float> torque;
+	std::vector<float> fuel;
+	std::vector<float> flying;	//1 while flying, 0 once the lane has an outcome
+	std::vector<BatchLanderOutcome> outcomes;
+	std::vector<uint32_t> endSteps;
+
+	void Integrate(int first, const LanderControls* controls);
+	void TestContacts(int idx);
+
+public:
+
+	void Setup(const BatchLanderModel& model, const TerrainHeightField* terrain, int count, const BatchLanderParams& params = BatchLanderParams());
+	//Puts every lander where Lander::Start puts it
+	void Reset(const LanderParams& landerParams);
+	//Body origin and velocity in world units, like b2Body::SetTransform and SetLinearVelocity
+	void Reset(int idx, b2Vec2 position, float angle, b2Vec2 velocity);
+	//One set of controls per lander
+	void Step(const LanderControls* controls);
+
+	int GetCount();
+	int GetFlyingCount();
+	uint64_t GetStepCount();
+	//Body origin in world units, like b2Body::GetPosition
+	b2Vec2 GetPosition(int idx);
+	float GetAngle(int idx);
+	b2Vec2 GetLinearVelocity(int idx);
+	float GetThrusterStrength(int idx);
+	float GetFuelUsed(int idx);
+	BatchLanderOutcome GetOutcome(int idx);
+	//Step the outcome came at
+	uint32_t GetEndStep(int idx);
+};
@@ -0,0 +1,118 @@
+#include "BatchRunner.h"
+
+#include <thread>
+
+BatchRunner::BatchRunner(BatchRunParams params)
+{
+	this->params = params;
+	if (this->params.threadCount <= 0)
+		this->params.threadCount = std::max(1u, std::thread::hardware_concurrency());
+}
+
+std::vector<RolloutResult> BatchRunner::Run(const std::vector<RolloutJob>& jobs, const LanderPolicy& policy)
+{
+	std::vector<RolloutResult> results(jobs.size());
+	int threadCount = std::min<int>(params.threadCount, std::max<size_t>(jobs.size(), 1));
+
+	//Deal the jobs out round robin, stealing evens out rollouts of different length
+	std::vector<WorkQueue> queues(threadCount);
+	for (int i = 0; i < (int)jobs.size(); i++)
+	{
+		queues[i % threadCount].jobs.push_back(i);
+	}
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < threadCount; i++)
+	{
+		threads.emplace_back(&BatchRunner::Worker, this, i, std::ref(queues), std::cref(jobs), std::cref(policy), std::ref(results));
+	}
+	Worker(0, queues, jobs, policy, results);
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+	return results;
+}
+
+int BatchRunner::GetThreadCount()
+{
+	return params.threadCount;
+}
+
+void BatchRunner::Worker(int threadIdx, std::vector<WorkQueue>& queues, const std::vector<RolloutJob>& jobs, const LanderPolicy& policy, std::vector<RolloutResult>& results)
+{
+	//Every thread owns a whole world, nothing in the simulation is shared
+	Simulation simulation;
+	simulation.SetStreamingTerrain(params.streamingTerrain);
+	simulation.Setup(params.arenaWidth, params.arenaHeight);
+
+	int jobIdx;
+	while (true)
+	{
+		bool found = PopJob(queues[threadIdx], jobIdx);
+		//No jobs are added after the start, so once every queue is empty we are done
+		for (int i = 1; !found && i < (int)queues.size(); i++)
+		{
+			found = StealJob(queues[(threadIdx + i) % queues.size()], jobIdx);
+		}
+		if (!found)
+			return;
+		results[jobIdx] = RunRollout(simulation, jobs[jobIdx], policy);
+	}
+}
+
+bool BatchRunner::PopJob(WorkQueue& queue, int& jobIdx)
+{
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty())
+		return false;
+	jobIdx = queue.jobs.front();
+	queue.jobs.pop_front();
+	return true;
+}
+
+bool BatchRunner::StealJob(WorkQueue& queue, int& jobIdx)
+{
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty())
+		return false;
+	jobIdx = queue.jobs.back();
+	queue.jobs.pop_back();
+	return true;
+}
+
+RolloutResult BatchRunner::RunRollout(Simulation& simulation, const RolloutJob& job, const LanderPolicy& policy)
+{
+	RolloutResult result;
+	LanderControls idle;
+	int settledFor = 0;
+
+	simulation.AbortRound();
+	simulation.SetTerrainSeed(job.terrainSeed);
+	simulation.StartRound();
+	while (result.steps < job.maxSteps)
+	{
+		simulation.Step(policy ? policy(simulation) : idle);
+		result.steps++;
+		result.contactEvents += simulation.GetContactManager()->GetEventsLastFlush();
+
+		Simulation::GameState state = simulation.GetGameState();
+		if (state == Simulation::GameState::Landed || state == Simulation::GameState::Crashed)
+		{
+			result.landed = state == Simulation::GameState::Landed;
+			result.crashed = state == Simulation::GameState::Crashed;
+			break;
+		}
+		//Resting anywhere but a landing spot can never win
+		if (state == Simulation::GameState::Flying && simulation.GetLander()->IsStationary())
+			settledFor++;
+		else
+			settledFor = 0;
+		if (settledFor >= job.settleSteps)
+			break;
+	}
+	result.fuelUsed = simulation.GetFuelUsed();
+	result.time = simulation.GetRoundTime();
+	simulation.AbortRound();
+	return result;
+}
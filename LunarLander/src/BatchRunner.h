@@ -0,0 +1,55 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include "Simulation.h"
+
+//Chooses the controls for the next tick of a rollout
+typedef std::function<LanderControls(Simulation& simulation)> LanderPolicy;
+
+struct RolloutJob {
+	uint32_t terrainSeed;
+	int maxSteps = 60 * 60;	//A minute of simulated time
+	int settleSteps = 60;	//Resting this long outside a landing spot ends the round
+};
+
+struct RolloutResult {
+	bool landed = false;
+	bool crashed = false;
+	float fuelUsed = 0.f;
+	float time = 0.f;	//Simulated seconds until the round ended
+	int steps = 0;
+	uint64_t contactEvents = 0;	//Contact events dispatched over the round
+};
+
+struct BatchRunParams {
+	int threadCount = 0;	//0 uses every hardware thread
+	int arenaWidth = 1024;
+	int arenaHeight = 768;
+	bool streamingTerrain = false;
+};
+
+//Runs rollouts on a pool of threads, each owning one Simulation; idle threads steal queued jobs from busy ones
+class BatchRunner
+{
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<int> jobs;
+	};
+
+	BatchRunParams params;
+
+	void Worker(int threadIdx, std::vector<WorkQueue>& queues, const std::vector<RolloutJob>& jobs, const LanderPolicy& policy, std::vector<RolloutResult>& results);
+	bool PopJob(WorkQueue& queue, int& jobIdx);
+	bool StealJob(WorkQueue& queue, int& jobIdx);
+
+public:
+
+	BatchRunner(BatchRunParams params);
+
+	std::vector<RolloutResult> Run(const std::vector<RolloutJob>& jobs, const LanderPolicy& policy);
+	int GetThreadCount();
+
+	static RolloutResult RunRollout(Simulation& simulation, const RolloutJob& job, const LanderPolicy& policy);
+};
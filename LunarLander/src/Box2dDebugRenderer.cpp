@@ -0,0 +1,118 @@
+#include "Box2dDebugRenderer.h"
+
+Box2dDebugRenderer::Box2dDebugRenderer() {
+	SetFlags(e_shapeBit);
+	lines.setMode(OF_PRIMITIVE_LINES);
+	fills.setMode(OF_PRIMITIVE_TRIANGLES);
+	//Rewritten every frame
+	lines.setUsage(GL_STREAM_DRAW);
+	fills.setUsage(GL_STREAM_DRAW);
+	for (int i = 0; i < CircleSegments; i++) {
+		float theta = i * 2.0f * b2_pi / CircleSegments;
+		circle[i] = ofVec2f(cosf(theta), sinf(theta));
+	}
+}
+
+void Box2dDebugRenderer::setScale(float f) {
+	scaleFactor = f;
+}
+
+void Box2dDebugRenderer::Begin() {
+	lines.clear();
+	fills.clear();
+	lines.setMode(OF_PRIMITIVE_LINES);
+	fills.setMode(OF_PRIMITIVE_TRIANGLES);
+}
+
+void Box2dDebugRenderer::End(DrawList& list) {
+	//Translucent fills first, outlines on top
+	if (fills.getNumVertices() > 0)
+		list.AddMesh(fills);
+	if (lines.getNumVertices() > 0)
+		list.AddMesh(lines);
+}
+
+ofIndexType Box2dDebugRenderer::AddVertex(const b2Vec2& vertex, const ofFloatColor& color, ofVboMesh& mesh) {
+	mesh.addVertex(ofDefaultVertexType(vertex.x*scaleFactor, vertex.y*scaleFactor, 0.f));
+	mesh.addColor(color);
+	return mesh.getNumVertices() - 1;
+}
+
+void Box2dDebugRenderer::AddOutline(ofIndexType first, int count) {
+	for (int i = 0; i < count; ++i) {
+		lines.addIndex(first + i);
+		lines.addIndex(first + (i + 1) % count);
+	}
+}
+
+void Box2dDebugRenderer::AddFan(ofIndexType first, int count) {
+	//The shapes Box2D draws solid are convex
+	for (int i = 2; i < count; ++i) {
+		fills.addIndex(first);
+		fills.addIndex(first + i - 1);
+		fills.addIndex(first + i);
+	}
+}
+
+void Box2dDebugRenderer::AddCircle(const b2Vec2& center, float32 radius, const ofFloatColor& color, bool solid) {
+	ofVboMesh& mesh = solid ? fills : lines;
+	ofIndexType first = mesh.getNumVertices();
+	for (int i = 0; i < CircleSegments; i++) {
+		AddVertex(center + radius * b2Vec2(circle[i].x, circle[i].y), color, mesh);
+	}
+	if (solid)
+		AddFan(first, CircleSegments);
+	else
+		AddOutline(first, CircleSegments);
+}
+
+void Box2dDebugRenderer::DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) {
+	ofFloatColor lineColor(color.r, color.g, color.b);
+	ofIndexType first = lines.getNumVertices();
+	for (int i = 0; i < vertexCount; ++i) {
+		AddVertex(vertices[i], lineColor, lines);
+	}
+	AddOutline(first, vertexCount);
+}
+
+void Box2dDebugRenderer::DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color) {
+	ofFloatColor fillColor(1.f, 1.f, 1.f, 200.f / 255.f);
+	ofIndexType first = fills.getNumVertices();
+	for (int i = 0; i < vertexCount; ++i) {
+		AddVertex(vertices[i], fillColor, fills);
+	}
+	AddFan(first, vertexCount);
+}
+
+void Box2dDebugRenderer::DrawCircle(const b2Vec2& center, float32 radius, const b2Color& color) {
+	AddCircle(center, radius, ofFloatColor(color.r, color.g, color.b), false);
+}
+
+void Box2dDebugRenderer::DrawSolidCircle(const b2Vec2& center, float32 radius, const b2Vec2& axis, const b2Color& color) {
+	AddCircle(center, radius, ofFloatColor(1.f, 1.f, 1.f, 200.f / 255.f), true);
+}
+
+void Box2dDebugRenderer::DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color) {
+	ofFloatColor lineColor(1.f, 1.f, 1.f, 200.f / 255.f);
+	lines.addIndex(AddVertex(p1, lineColor, lines));
+	lines.addIndex(AddVertex(p2, lineColor, lines));
+}
+
+void Box2dDebugRenderer::DrawTransform(const b2Transform& xf) {
+}
+
+void Box2dDebugRenderer::DrawPoint(const b2Vec2& p, float32 size, const b2Color& color) {
+}
+
+void Box2dDebugRenderer::DrawString(int x, int y, const char* string, ...) {
+}
+
+void Box2dDebugRenderer::DrawAABB(b2AABB* aabb, const b2Color& color) {
+	ofFloatColor lineColor(color.r, color.g, color.b);
+	ofIndexType first = lines.getNumVertices();
+	AddVertex(aabb->lowerBound, lineColor, lines);
+	AddVertex(b2Vec2(aabb->upperBound.x, aabb->lowerBound.y), lineColor, lines);
+	AddVertex(aabb->upperBound, lineColor, lines);
+	AddVertex(b2Vec2(aabb->lowerBound.x, aabb->upperBound.y), lineColor, lines);
+	AddOutline(first, 4);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "ofxBox2d.h"
+#include "DrawList.h"
+
+//Collects Box2D's debug draw of a frame into two indexed vertex buffers, outlines and fills, which go
+//into the draw list as one mesh each: the whole debug overlay costs two draw calls however many bodies
+//there are. Everything is scaled to screen units by scaleFactor. Debug geometry stays off vector outputs.
+class Box2dDebugRenderer : public b2Draw {
+
+	static const int CircleSegments = 16;
+
+	ofVboMesh lines;
+	ofVboMesh fills;
+	ofVec2f circle[CircleSegments];	//Unit circle, scaled and moved per circle
+
+	ofIndexType AddVertex(const b2Vec2& vertex, const ofFloatColor& color, ofVboMesh& mesh);
+	void AddOutline(ofIndexType first, int count);
+	void AddFan(ofIndexType first, int count);
+	void AddCircle(const b2Vec2& center, float32 radius, const ofFloatColor& color, bool solid);
+
+public:
+
+	float scaleFactor = OFX_BOX2D_SCALE;
+
+	Box2dDebugRenderer();
+
+	void setScale(float f);
+
+	//Starts a new frame, the buffers keep their capacity
+	void Begin();
+	//Adds the collected buffers to the list, they stay valid until the next Begin
+	void End(DrawList& list);
+
+	void DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color);
+	void DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color);
+	void DrawCircle(const b2Vec2& center, float32 radius, const b2Color& color);
+	void DrawSolidCircle(const b2Vec2& center, float32 radius, const b2Vec2& axis, const b2Color& color);
+	void DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color);
+	void DrawTransform(const b2Transform& xf);
+	void DrawPoint(const b2Vec2& p, float32 size, const b2Color& color);
+	void DrawString(int x, int y, const char* string, ...);
+	void DrawAABB(b2AABB* aabb, const b2Color& color);
+};
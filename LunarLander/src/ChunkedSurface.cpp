@@ -0,0 +1,259 @@
+#include "ChunkedSurface.h"
+
+#include "ContactListeners.h"
+
+ChunkedSurface::ChunkedSurface(ofxBox2d* world)
+{
+	this->world = world;
+}
+
+void ChunkedSurface::SetParams(const ChunkedSurfaceParams& params)
+{
+	ReleaseChunks();
+	this->params = params;
+
+	//Every slot the window and the cache can ever need is created up front
+	chunks.resize(params.chunksBehind + params.chunksAhead + 1 + params.cacheSize);
+	b2BodyDef bodyDef;
+	bodyDef.type = b2BodyType::b2_staticBody;
+	bodyDef.active = false;
+	for (Chunk& chunk : chunks)
+	{
+		chunk.body = world->getWorld()->CreateBody(&bodyDef);
+	}
+}
+
+void ChunkedSurface::GenerateSurface(uint32_t seed)
+{
+	this->seed = seed;
+	for (Chunk& chunk : chunks)
+	{
+		chunk.generated = false;
+		chunk.loaded = false;
+		chunk.body->SetActive(false);
+	}
+	Update(focusX);
+}
+
+void ChunkedSurface::Update(float focusX)
+{
+	this->focusX = focusX;
+	updateCount++;
+
+	int focusChunk = GetChunkIndex(focusX);
+	int first = focusChunk - params.chunksBehind;
+	int last = focusChunk + params.chunksAhead;
+	//Park the chunks that left the window, their bodies leave the broadphase but keep their shapes
+	for (Chunk& chunk : chunks)
+	{
+		if (chunk.loaded && (chunk.index < first || chunk.index > last))
+		{
+			chunk.loaded = false;
+			chunk.body->SetActive(false);
+		}
+	}
+	for (int i = first; i <= last; i++)
+	{
+		LoadChunk(i);
+	}
+}
+
+void ChunkedSurface::SetScreenSize(int /*screenWidth*/, int screenHeight)
+{
+	//Chunks have a fixed width, only the heights follow the screen
+	float yRatio = screenHeight / (float)ScreenHeight;
+	for (Chunk& chunk : chunks)
+	{
+		for (ofDefaultVertexType& vert : chunk.graphics)
+		{
+			vert.y *= yRatio;
+		}
+		chunk.laserTolerance = -1.f;
+	}
+	ScreenHeight = screenHeight;
+}
+
+void ChunkedSurface::SetPhysicalParams(float friction, float bounce)
+{
+	this->friction = friction;
+	this->bounce = bounce;
+}
+
+uint32_t ChunkedSurface::GetSeed()
+{
+	return seed;
+}
+
+void ChunkedSurface::Record(DrawList& list, float tolerance)
+{
+	for (Chunk& chunk : chunks)
+	{
+		if (!chunk.loaded)
+			continue;
+		if (tolerance != chunk.laserTolerance)
+		{
+			padVertices.clear();
+			for (const TerrainPlateau& plateau : chunk.terrain.plateaus)
+			{
+				padVertices.push_back(plateau.startIdx);
+				padVertices.push_back(plateau.startIdx + plateau.length);
+			}
+			simplifier.Simplify(chunk.graphics, tolerance, padVertices, chunk.laserGraphics);
+			chunk.laserTolerance = tolerance;
+		}
+		list.AddPolyline(chunk.graphics, chunk.laserGraphics, ofColor::white, 0, DrawStatic);
+	}
+}
+
+ChunkedSurface::~ChunkedSurface()
+{
+	ReleaseChunks();
+}
+
+uint32_t ChunkedSurface::GetChunkSeed(uint32_t seed, int chunkIdx)
+{
+	return FastRandom(((uint64_t)seed << 32) | (uint32_t)chunkIdx).Next();
+}
+
+float ChunkedSurface::GetEdgeHeight(const SurfaceGenerationParams& params, uint32_t seed, int edgeIdx)
+{
+	//Edges get their own stream, so both chunks sharing an edge agree on it without generating each other
+	FastRandom random(((uint64_t)~seed << 32) | (uint32_t)edgeIdx);
+	return random.Range(params.minHeight, params.maxHeight);
+}
+
+int ChunkedSurface::GetChunkIndex(float x)
+{
+	return (int)std::floor(x / params.chunkWidth);
+}
+
+ChunkedSurface::Chunk* ChunkedSurface::FindChunk(int chunkIdx)
+{
+	for (Chunk& chunk : chunks)
+	{
+		if (chunk.generated && chunk.index == chunkIdx)
+			return &chunk;
+	}
+	return nullptr;
+}
+
+void ChunkedSurface::LoadChunk(int chunkIdx)
+{
+	Chunk* chunk = FindChunk(chunkIdx);
+	if (!chunk)
+	{
+		//Cache miss: take an empty slot, or evict the least recently used parked chunk
+		for (Chunk& candidate : chunks)
+		{
+			if (candidate.loaded)
+				continue;
+			if (!chunk || !candidate.generated || (chunk->generated && candidate.lastUsed < chunk->lastUsed))
+				chunk = &candidate;
+			if (!chunk->generated)
+				break;
+		}
+		BuildChunk(*chunk, chunkIdx);
+	}
+	if (!chunk->loaded)
+	{
+		chunk->loaded = true;
+		chunk->body->SetActive(true);
+	}
+	chunk->lastUsed = updateCount;
+}
+
+void ChunkedSurface::BuildChunk(Chunk& chunk, int chunkIdx)
+{
+	chunk.index = chunkIdx;
+	chunk.generated = true;
+	chunk.laserTolerance = -1.f;
+
+	TerrainEdges edges = { GetEdgeHeight(params.chunk, seed, chunkIdx), GetEdgeHeight(params.chunk, seed, chunkIdx + 1) };
+	Surface::GenerateTerrain(params.chunk, GetChunkSeed(seed, chunkIdx), chunk.terrain, &edges);
+
+	int numPoints = chunk.terrain.heights.size();
+	float left = chunkIdx * params.chunkWidth;
+	float pointSeparation = params.chunkWidth / (numPoints - 1);	//The last vertex sits on the next chunk's first one
+
+	chunk.graphics.clear();
+	chunk.graphics.setClosed(false);
+	chunk.physVerts.resize(numPoints);
+	for (int i = 0; i < numPoints; i++)
+	{
+		ofVec2f point(left + pointSeparation * i, chunk.terrain.heights[i] * ScreenHeight);
+		chunk.graphics.addVertex(point.x, point.y, 0.f);
+		chunk.physVerts[i] = screenPtToWorldPt(point);
+	}
+	ApplyChain(chunk);
+
+	float padHeight = params.chunk.maxHeightDiff * 200.f;
+	for (int i = 0; i < (int)chunk.terrain.plateaus.size(); i++)
+	{
+		const TerrainPlateau& plateau = chunk.terrain.plateaus[i];
+		ApplyTriggerBox(chunk, i,
+			ofVec2f(pointSeparation * plateau.length, padHeight),
+			ofVec2f(left + pointSeparation * (plateau.length / 2.f + plateau.startIdx), plateau.height * ScreenHeight - padHeight / 2.f)
+		);
+	}
+	while (chunk.goalTriggerFixtures.size() > chunk.terrain.plateaus.size())
+	{
+		chunk.body->DestroyFixture(chunk.goalTriggerFixtures.back());
+		chunk.goalTriggerFixtures.pop_back();
+	}
+	//The body is inactive here, its proxies are rebuilt from the new shapes once it is loaded
+}
+
+void ChunkedSurface::ApplyChain(Chunk& chunk)
+{
+	int count = chunk.physVerts.size();
+	if (chunk.fixture)
+	{
+		b2ChainShape* chain = (b2ChainShape*)chunk.fixture->GetShape();
+		if (chain->m_count == count)
+		{
+			//Chunks share their vertex count, so a reused slot rewrites its chain in place
+			std::copy(chunk.physVerts.begin(), chunk.physVerts.end(), chain->m_vertices);
+			chunk.fixture->SetFriction(friction);
+			chunk.fixture->SetRestitution(bounce);
+			return;
+		}
+		chunk.body->DestroyFixture(chunk.fixture);
+	}
+
+	b2ChainShape chain;
+	chain.CreateChain(chunk.physVerts.data(), count);
+	b2FixtureDef fixtureDef;
+	fixtureDef.filter.categoryBits = ContactTag::TagTerrain;
+	fixtureDef.shape = &chain;
+	fixtureDef.friction = friction;
+	fixtureDef.restitution = bounce;
+	chunk.fixture = chunk.body->CreateFixture(&fixtureDef);
+}
+
+void ChunkedSurface::ApplyTriggerBox(Chunk& chunk, int idx, ofVec2f size, ofVec2f center)
+{
+	b2Vec2 b2size = screenPtToWorldPt(size / 2.f);
+	b2Vec2 b2center = screenPtToWorldPt(center);
+	if (idx < (int)chunk.goalTriggerFixtures.size())
+	{
+		((b2PolygonShape*)chunk.goalTriggerFixtures[idx]->GetShape())->SetAsBox(b2size.x, b2size.y, b2center, 0.f);
+		return;
+	}
+
+	b2PolygonShape triggerBox;
+	triggerBox.SetAsBox(b2size.x, b2size.y, b2center, 0.f);
+	b2FixtureDef def;
+	def.isSensor = true;
+	def.filter.categoryBits = ContactTag::TagLandingPad;
+	def.shape = &triggerBox;
+	chunk.goalTriggerFixtures.push_back(chunk.body->CreateFixture(&def));
+}
+
+void ChunkedSurface::ReleaseChunks()
+{
+	for (Chunk& chunk : chunks)
+	{
+		world->getWorld()->DestroyBody(chunk.body);
+	}
+	chunks.clear();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ofPolyline.h"
+#include "ofxBox2d.h"
+#include "Surface.h"
+
+struct ChunkedSurfaceParams {
+	SurfaceGenerationParams chunk;	//Generation params of a single chunk, numPoints and plateauCount are per chunk
+	float chunkWidth = 1024.f;	//Width of a chunk in screen units
+	int chunksBehind = 1;	//Chunks kept loaded behind the focus chunk
+	int chunksAhead = 1;	//Chunks kept loaded ahead of the focus chunk
+	int cacheSize = 4;	//Unloaded chunks kept around (inactive) in case the lander turns back
+};
+
+//Terrain of unlimited width, generated lazily in fixed width chunks around a focus point.
+//Every chunk slot owns its body and fixtures for its whole life; a slot is only reshaped when it is
+//reused for a different chunk, so memory and step cost stay the same however far the lander flies.
+class ChunkedSurface
+{
+private:
+
+	struct Chunk {
+		int index = 0;
+		bool generated = false;	//False for a slot that never held a chunk of the current seed
+		bool loaded = false;	//Active in the world, otherwise parked in the cache
+		uint64_t lastUsed = 0;	//Update count when the chunk was last loaded, for LRU eviction
+
+		TerrainData terrain;
+		std::vector<b2Vec2> physVerts;
+		ofPolyline graphics;
+		ofPolyline laserGraphics;	//Simplified graphics, rebuilt when the tolerance or the chunk changes
+		float laserTolerance = -1.f;
+
+		b2Body* body = nullptr;
+		b2Fixture* fixture = nullptr;
+		std::vector<b2Fixture*> goalTriggerFixtures;
+	};
+
+	ofxBox2d* world;
+	ChunkedSurfaceParams params;
+	uint32_t seed = 0;
+	std::vector<Chunk> chunks;	//Loaded and cached chunks, sized once by SetParams
+	PolylineSimplifier simplifier;
+	std::vector<int> padVertices;
+
+	int ScreenHeight = 768;
+	float friction = .5f;
+	float bounce = .5f;
+
+	float focusX = 0.f;	//Where the loaded window of chunks is centered
+	uint64_t updateCount = 0;
+
+public:
+
+	ChunkedSurface(ofxBox2d* world);
+	void SetParams(const ChunkedSurfaceParams& params);
+	void GenerateSurface(uint32_t seed);
+	void Update(float focusX);
+	void SetScreenSize(int screenWidth, int screenHeight);
+	void SetPhysicalParams(float friction, float bounce);
+	uint32_t GetSeed();
+	void Record(DrawList& list, float tolerance = 0.f);
+	~ChunkedSurface();
+
+	static uint32_t GetChunkSeed(uint32_t seed, int chunkIdx);
+	static float GetEdgeHeight(const SurfaceGenerationParams& params, uint32_t seed, int edgeIdx);
+
+private:
+
+	int GetChunkIndex(float x);
+	Chunk* FindChunk(int chunkIdx);
+	void LoadChunk(int chunkIdx);
+	void BuildChunk(Chunk& chunk, int chunkIdx);
+	void ApplyChain(Chunk& chunk);
+	void ApplyTriggerBox(Chunk& chunk, int idx, ofVec2f size, ofVec2f center);
+	void ReleaseChunks();
+};
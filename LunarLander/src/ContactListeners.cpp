@@ -1,98 +1,163 @@
 #include "ContactListeners.h"
+#include "Simulation.h"
+#include "Lander.h"
 
-LunarLanderConatactManager* LunarLanderConatactManager::instance = nullptr;
-
-LunarLanderConatactManager* LunarLanderConatactManager::Get()
+LunarLanderConatactManager::LunarLanderConatactManager(uint32 eventCapacity)
 {
-	if (!instance)
-	{
-		instance = new LunarLanderConatactManager();
-	}
-	return instance;
+	//Round up to a power of two so the ring index is a mask
+	uint32 capacity = 1;
+	while (capacity < eventCapacity)
+		capacity <<= 1;
+	events.resize(capacity);
+	eventMask = capacity - 1;
 }
 
 void LunarLanderConatactManager::SetCallback(LunarLanderContactListener * listener, int callbackFlags)
 {
 	callbacks[listener] = callbackFlags;
+	RebuildDispatch();
 }
 
 void LunarLanderConatactManager::AddCallback(LunarLanderContactListener * listener, int callbackFlags)
 {
 	callbacks[listener] |= callbackFlags;
+	RebuildDispatch();
 }
 
 void LunarLanderConatactManager::RemoveCallback(LunarLanderContactListener * listener)
 {
-	callbacks[listener] = 0;
+	callbacks.erase(listener);
+	RebuildDispatch();
 }
 
 void LunarLanderConatactManager::ShrinkCallback(LunarLanderContactListener * listener, int callbackFlagsToRemove)
 {
-	callbacks[listener] &= ~callbackFlagsToRemove;
+	auto callback = callbacks.find(listener);
+	if (callback == callbacks.end())
+		return;
+	callback->second &= ~callbackFlagsToRemove;
+	if (!callback->second)
+		callbacks.erase(callback);
+	RebuildDispatch();
 }
 
-void LunarLanderConatactManager::BeginContact(b2Contact * contact)
+void LunarLanderConatactManager::RebuildDispatch()
 {
-	for (auto listener : callbacks)
+	DispatchList* lists[] = { &beginContactListeners, &endContactListeners, &preSolveListeners, &postSolveListeners };
+	int flags[] = { ContactCallbackFlag::BeginContact, ContactCallbackFlag::EndContact, ContactCallbackFlag::PreSolve, ContactCallbackFlag::PostSolve };
+	for (int i = 0; i < 4; i++)
 	{
-		if (listener.second & ContactCallbackFlag::BeginContact && isFiltered(listener.first, contact))
+		DispatchList& list = *lists[i];
+		list.listeners.clear();
+		list.tagsA = 0;
+		list.tagsB = 0;
+		for (auto& callback : callbacks)
 		{
-			listener.first->BeginContact(contact);
+			if (!(callback.second & flags[i]))
+				continue;
+			list.listeners.push_back(callback.first);
+			list.tagsA |= callback.first->filterTagsA;
+			list.tagsB |= callback.first->filterTagsB;
 		}
 	}
 }
 
+void LunarLanderConatactManager::BeginContact(b2Contact * contact)
+{
+	Record(beginContactListeners, ContactCallbackFlag::BeginContact, contact, 0.f);
+}
+
 void LunarLanderConatactManager::EndContact(b2Contact * contact)
 {
-	for (auto listener : callbacks)
-	{
-		if (listener.second & ContactCallbackFlag::EndContact && isFiltered(listener.first, contact))
-		{
-			listener.first->EndContact(contact);
-		}
-	}
+	Record(endContactListeners, ContactCallbackFlag::EndContact, contact, 0.f);
 }
 
 void LunarLanderConatactManager::PreSolve(b2Contact * contact, const b2Manifold * oldManifold)
 {
-	for (auto listener : callbacks)
+	if (preSolveListeners.listeners.empty())
+		return;
+	uint16 tagsA = contact->GetFixtureA()->GetFilterData().categoryBits;
+	uint16 tagsB = contact->GetFixtureB()->GetFilterData().categoryBits;
+	for (LunarLanderContactListener* listener : preSolveListeners.listeners)
 	{
-		if (listener.second & ContactCallbackFlag::PreSolve && isFiltered(listener.first, contact))
-		{
-			listener.first->PreSolve(contact, oldManifold);
-		}
+		if (isFiltered(listener->filterTagsA, listener->filterTagsB, tagsA, tagsB))
+			listener->PreSolve(contact, oldManifold);
 	}
 }
 
 void LunarLanderConatactManager::PostSolve(b2Contact * contact, const b2ContactImpulse * impulse)
 {
-	for (auto listener : callbacks)
+	if (postSolveListeners.listeners.empty())
+		return;
+	float maxImpulse = 0.f;
+	for (int i = 0; i < impulse->count; i++)
+	{
+		maxImpulse = std::max(maxImpulse, impulse->normalImpulses[i]);
+	}
+	Record(postSolveListeners, ContactCallbackFlag::PostSolve, contact, maxImpulse);
+}
+
+void LunarLanderConatactManager::Flush()
+{
+	eventsLastFlush = eventWrite - eventRead;
+	//Handlers may create or destroy fixtures, any events that raises are appended and dispatched here too
+	while (eventRead != eventWrite)
 	{
-		if (listener.second & ContactCallbackFlag::PostSolve && isFiltered(listener.first, contact))
+		ContactEvent event = events[eventRead++ & eventMask];
+		Dispatch(event);
+	}
+	droppedLastFlush = droppedEvents;
+	droppedEvents = 0;
+	if (droppedLastFlush)
+		ofLogWarning("ContactListener") << "Dropped " << droppedLastFlush << " contact events, the queue holds " << events.size();
+}
+
+void LunarLanderConatactManager::Dispatch(const ContactEvent& event)
+{
+	switch (event.type)
+	{
+	case ContactCallbackFlag::BeginContact:
+		for (LunarLanderContactListener* listener : beginContactListeners.listeners)
 		{
-			listener.first->PostSolve(contact, impulse);
+			if (isFiltered(listener->filterTagsA, listener->filterTagsB, event.tagsA, event.tagsB))
+				listener->BeginContact(event);
 		}
+		break;
+	case ContactCallbackFlag::EndContact:
+		for (LunarLanderContactListener* listener : endContactListeners.listeners)
+		{
+			if (isFiltered(listener->filterTagsA, listener->filterTagsB, event.tagsA, event.tagsB))
+				listener->EndContact(event);
+		}
+		break;
+	case ContactCallbackFlag::PostSolve:
+		for (LunarLanderContactListener* listener : postSolveListeners.listeners)
+		{
+			if (isFiltered(listener->filterTagsA, listener->filterTagsB, event.tagsA, event.tagsB))
+				listener->PostSolve(event);
+		}
+		break;
+	default:
+		break;
 	}
 }
 
-bool LunarLanderConatactManager::isFiltered(LunarLanderContactListener * listener, b2Contact * contact)
+uint32 LunarLanderConatactManager::GetEventsLastFlush()
+{
+	return eventsLastFlush;
+}
+
+uint32 LunarLanderConatactManager::GetDroppedLastFlush()
 {
-	uint32 filterFlag = listener->ContactFilterFlag;
-	b2Fixture* fixtureA = contact->GetFixtureA();
-	b2Fixture* fixtureB = contact->GetFixtureB();
-	if (filterFlag & ContactFilterFlags::FilterBody)
-		return fixtureA->GetBody() == listener->filterBody || fixtureB->GetBody() == listener->filterBody;
-	if (filterFlag & ContactFilterFlags::FilterFixture)
-		return fixtureA == listener->filterFixture || fixtureB == listener->filterFixture;
-	return true;
+	return droppedLastFlush;
 }
 
-void DebugContactListener::BeginContact(b2Contact * contact)
+void DebugContactListener::BeginContact(const ContactEvent& event)
 {
 	ofLogNotice("ContactListener") << "BeginContact";
 }
 
-void DebugContactListener::EndContact(b2Contact * contact)
+void DebugContactListener::EndContact(const ContactEvent& event)
 {
 	ofLogNotice("ContactListener") << "EndContact";
 }
@@ -102,69 +167,78 @@ void DebugContactListener::PreSolve(b2Contact * contact, const b2Manifold * oldM
 	ofLogNotice("ContactListener") << "PreSolve";
 }
 
-void DebugContactListener::PostSolve(b2Contact * contact, const b2ContactImpulse * impulse)
+void DebugContactListener::PostSolve(const ContactEvent& event)
 {
 	ofLogNotice("ContactListener") << "PostSolve";
 }
 
-LandingSpotContactListener::LandingSpotContactListener(ofApp* _app, b2Body* _lander)
+LandingSpotContactListener::LandingSpotContactListener(Simulation* _simulation)
 {
-	app = _app;
-	lander = _lander;
+	simulation = _simulation;
+	SetTagFilter(ContactTag::TagLander, ContactTag::TagLandingPad);
 }
 
-void LandingSpotContactListener::BeginContact(b2Contact* contact)
+void LandingSpotContactListener::ResetContacts()
 {
-	if(contact->GetFixtureA()->GetBody() == lander || contact->GetFixtureB()->GetBody() == lander)
-		app->StartLanding();
+	landingSpotContacts = 0;
+	ShipOnLandingSpot = false;
 }
 
-void LandingSpotContactListener::EndContact(b2Contact* contact)
+void LandingSpotContactListener::BeginContact(const ContactEvent& event)
 {
-	if(contact->GetFixtureA()->GetBody() == lander || contact->GetFixtureB()->GetBody() == lander)
-		app->EndLanding();
+	if (landingSpotContacts++ == 0)
+	{
+		ShipOnLandingSpot = true;
+		simulation->StartLanding();
+	}
+}
+
+void LandingSpotContactListener::EndContact(const ContactEvent& event)
+{
+	//The Begin of this contact may have been dropped by a full queue, so the count can't go below zero
+	if (landingSpotContacts == 0)
+		return;
+	if (--landingSpotContacts == 0)
+	{
+		ShipOnLandingSpot = false;
+		simulation->EndLanding();
+	}
 }
 
 void LandingSpotContactListener::PreSolve(b2Contact* contact, const b2Manifold* oldManifold){}
-void LandingSpotContactListener::PostSolve(b2Contact* contact, const b2ContactImpulse* impulse){}
+void LandingSpotContactListener::PostSolve(const ContactEvent& event){}
 
 LanderCrashContactListener::LanderCrashContactListener(Lander* lander)
 {
 	this->lander = lander;
+	SetTagFilter(ContactTag::TagLanderHull);
 }
 
-void LanderCrashContactListener::BeginContact(b2Contact* contact){}
-void LanderCrashContactListener::EndContact(b2Contact* contact){}
+void LanderCrashContactListener::BeginContact(const ContactEvent& event){}
+void LanderCrashContactListener::EndContact(const ContactEvent& event){}
 void LanderCrashContactListener::PreSolve(b2Contact* contact, const b2Manifold* oldManifold){}
 
-void LanderCrashContactListener::PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
-{
-	ofLogNotice("Crash") << impulse->normalImpulses;
-}
-
-void LunarLanderContactListener::SetBodyFilter(b2Body * body)
-{
-	filterBody = body;
-	ContactFilterFlag |= ContactFilterFlags::FilterBody;
-}
-
-void LunarLanderContactListener::ResetBodyFilter()
-{
-	ContactFilterFlag &= ~ContactFilterFlags::FilterBody;
-}
-
-void LunarLanderContactListener::SetFixtureFilter(b2Fixture* fixture)
+void LanderCrashContactListener::PostSolve(const ContactEvent& event)
 {
-	filterFixture = fixture;
-	ContactFilterFlag |= ContactFilterFlags::FilterFixture;
+	//Every lander has its own listener, the tags alone also pass the hull of every other one
+	b2Fixture* hull = lander->GetHullFixture();
+	if (event.fixtureA != hull && event.fixtureB != hull)
+		return;
+	if (event.normalImpulse > lander->GetCrashImpulse())
+	{
+		ofLogNotice("Crash") << event.normalImpulse;
+		lander->Crash();
+	}
 }
 
-void LunarLanderContactListener::ResetFixtureFilter()
+void LunarLanderContactListener::SetTagFilter(uint16 tagsA, uint16 tagsB)
 {
-	ContactFilterFlag &= ~ContactFilterFlags::FilterFixture;
+	filterTagsA = tagsA;
+	filterTagsB = tagsB;
 }
 
 void LunarLanderContactListener::ResetFilters()
 {
-	ContactFilterFlag = 0;
+	filterTagsA = ContactTag::TagAny;
+	filterTagsB = ContactTag::TagAny;
 }
@@ -1,45 +1,85 @@
 #pragma once
 #include "ofxBox2d.h"
-#include "ofApp.h"
-#include "Lander.h"
 
-enum ContactFilterFlags { FilterBody = 0x01, FilterFixture = 0x02 };//TODO: want a two body filter
+class Simulation;
+class Lander;
+
+//Category bits stored in each fixture's b2Filter, listeners select contacts by them
+enum ContactTag : uint16 {
+	TagDefault = 0x0001,	//Box2D's default category: world bounds and debris
+	TagTerrain = 0x0002,
+	TagLandingPad = 0x0004,
+	TagLanderHull = 0x0008,
+	TagLanderLegs = 0x0010,
+	TagLander = TagLanderHull | TagLanderLegs,
+	TagAny = 0xFFFF
+};
 enum ContactCallbackFlag { BeginContact = 0x01, EndContact = 0x02, PreSolve = 0x04, PostSolve = 0x08 };
 
+//Compact record of a contact callback, queued during the step and dispatched after it
+//The fixture pointers are identities only, a handler may have destroyed them before later events run
+struct ContactEvent {
+	uint8 type;	//The ContactCallbackFlag that produced the event
+	uint16 tagsA;
+	uint16 tagsB;
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	float normalImpulse;	//Largest normal impulse of the manifold, PostSolve only
+};
+
 class LunarLanderContactListener {
 
 public:
 
-	uint32 ContactFilterFlag;
+	//A contact passes when one fixture has a tag from filterTagsA and the other one from filterTagsB
+	uint16 filterTagsA = TagAny;
+	uint16 filterTagsB = TagAny;
 
-	b2Body* filterBody;	//TODO: Allow lists of filter bodies
-	b2Fixture* filterFixture;
-
-	void SetBodyFilter(b2Body* body);
-	void ResetBodyFilter();
-	void SetFixtureFilter(b2Fixture* fixture);
-	void ResetFixtureFilter();
+	void SetTagFilter(uint16 tagsA, uint16 tagsB = TagAny);
 
 	void ResetFilters();
 
-	virtual void BeginContact(b2Contact* contact) = 0;
+	virtual ~LunarLanderContactListener() {}
+
+	virtual void BeginContact(const ContactEvent& event) = 0;
 
-	virtual void EndContact(b2Contact* contact) = 0;
+	virtual void EndContact(const ContactEvent& event) = 0;
 
+	//Runs inside the step, it has to act on the contact before it is solved
 	virtual void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) = 0;
 
-	virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) = 0;
+	virtual void PostSolve(const ContactEvent& event) = 0;
 };
 
+//One per world, so independent worlds can run on separate threads
 class LunarLanderConatactManager : public b2ContactListener
 {
 
-	static LunarLanderConatactManager* instance;
 	std::map<LunarLanderContactListener*,int> callbacks;
 
+	//Dense per callback type list, rebuilt from callbacks whenever a registration changes
+	struct DispatchList {
+		std::vector<LunarLanderContactListener*> listeners;
+		uint16 tagsA = 0;	//Union of the listener filters, contacts outside it are never queued
+		uint16 tagsB = 0;
+	};
+	DispatchList beginContactListeners;
+	DispatchList endContactListeners;
+	DispatchList preSolveListeners;
+	DispatchList postSolveListeners;
+
+	//Ring buffer of events recorded during the step
+	std::vector<ContactEvent> events;
+	uint32 eventMask;
+	uint32 eventWrite = 0;
+	uint32 eventRead = 0;
+	uint32 droppedEvents = 0;
+	uint32 eventsLastFlush = 0;
+	uint32 droppedLastFlush = 0;
+
 public:
 
-	static LunarLanderConatactManager* Get();
+	LunarLanderConatactManager(uint32 eventCapacity = 4096);
 
 	void SetCallback(LunarLanderContactListener* listener, int callbackFlags);
 
@@ -57,35 +97,72 @@ public:
 
 	virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override;
 
+	//Dispatches the queued events, call it after the step when the world is unlocked
+	void Flush();
+
+	uint32 GetEventsLastFlush();
+	uint32 GetDroppedLastFlush();
+
 private:
 
-	bool isFiltered(LunarLanderContactListener* listener, b2Contact* contact);
+	void RebuildDispatch();
+	void Dispatch(const ContactEvent& event);
+
+	static inline bool isFiltered(uint16 filterTagsA, uint16 filterTagsB, uint16 tagsA, uint16 tagsB)
+	{
+		return (tagsA & filterTagsA && tagsB & filterTagsB)
+			|| (tagsA & filterTagsB && tagsB & filterTagsA);
+	}
+
+	inline void Record(const DispatchList& list, uint8 type, b2Contact* contact, float normalImpulse)
+	{
+		b2Fixture* fixtureA = contact->GetFixtureA();
+		b2Fixture* fixtureB = contact->GetFixtureB();
+		uint16 tagsA = fixtureA->GetFilterData().categoryBits;
+		uint16 tagsB = fixtureB->GetFilterData().categoryBits;
+		if (!isFiltered(list.tagsA, list.tagsB, tagsA, tagsB))
+			return;
+		if (eventWrite - eventRead > eventMask)
+		{
+			droppedEvents++;
+			return;
+		}
+		ContactEvent& event = events[eventWrite++ & eventMask];
+		event.type = type;
+		event.tagsA = tagsA;
+		event.tagsB = tagsB;
+		event.fixtureA = fixtureA;
+		event.fixtureB = fixtureB;
+		event.normalImpulse = normalImpulse;
+	}
 };
 
 class DebugContactListener : public LunarLanderContactListener
 {
 	// Inherited via LunarLanderContactListener
-	virtual void BeginContact(b2Contact * contact) override;
-	virtual void EndContact(b2Contact * contact) override;
+	virtual void BeginContact(const ContactEvent& event) override;
+	virtual void EndContact(const ContactEvent& event) override;
 	virtual void PreSolve(b2Contact * contact, const b2Manifold * oldManifold) override;
-	virtual void PostSolve(b2Contact * contact, const b2ContactImpulse * impulse) override;
+	virtual void PostSolve(const ContactEvent& event) override;
 };
 
 class LandingSpotContactListener : public LunarLanderContactListener
 {
 public:
 	bool ShipOnLandingSpot = false;
+	int landingSpotContacts = 0;	//Both lander fixtures can touch a landing spot at once
 
-	ofApp* app;
-	b2Body* lander;
+	Simulation* simulation;
 
-	LandingSpotContactListener(ofApp* app, b2Body* lander);
+	LandingSpotContactListener(Simulation* simulation);
+	//Forgets the contacts counted so far, after the world dropped them without telling
+	void ResetContacts();
 
-	virtual void BeginContact(b2Contact * contact) override;
-	virtual void EndContact(b2Contact * contact) override;
+	virtual void BeginContact(const ContactEvent& event) override;
+	virtual void EndContact(const ContactEvent& event) override;
 
 	virtual void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override;
-	virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override;
+	virtual void PostSolve(const ContactEvent& event) override;
 };
 
 class LanderCrashContactListener : public LunarLanderContactListener
@@ -96,9 +173,9 @@ public:
 
 	LanderCrashContactListener(Lander* lander);
 
-	virtual void BeginContact(b2Contact * contact) override;
-	virtual void EndContact(b2Contact * contact) override;
+	virtual void BeginContact(const ContactEvent& event) override;
+	virtual void EndContact(const ContactEvent& event) override;
 
 	virtual void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override;
-	virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override;
+	virtual void PostSolve(const ContactEvent& event) override;
 };
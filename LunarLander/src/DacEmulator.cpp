@@ -0,0 +1,133 @@
+#include "DacEmulator.h"
+
+#include <thread>
+
+int DacEmulator::Run(const DacEmulatorParams& params)
+{
+	this->params = params;
+	if (!server.setup(params.port, false))
+	{
+		ofLogError("DacEmulator") << "Couldn't listen on port " << params.port;
+		return 1;
+	}
+	ofLogNotice("DacEmulator") << "Listening on port " << params.port << ", buffer of " << params.bufferCapacity << " points";
+	received.resize(LaserDacProtocol::HeaderSize + LaserDacProtocol::MaxPointsPerPacket * LaserDacProtocol::PointSize);
+
+	uint64_t start = LaserDacProtocol::NowMicros();
+	uint64_t lastReport = start;
+	while (params.seconds <= 0.f || LaserDacProtocol::NowMicros() - start < params.seconds * 1e6)
+	{
+		uint64_t now = LaserDacProtocol::NowMicros();
+		Play(now);
+		Receive(now);
+		if (now - lastReport >= 1000000)
+		{
+			Report((now - lastReport) / 1e6);
+			lastReport = now;
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+	server.close();
+	return 0;
+}
+
+void DacEmulator::Play(uint64_t now)
+{
+	double played = (now - lastPlayTime) * (double)pointsPerSecond / 1e6;
+	lastPlayTime = now;
+	if (!playing)
+		return;
+	fullness -= played;
+	if (fullness <= 0.0)
+	{
+		//Ran dry, the projector would stop moving until more points arrive
+		fullness = 0.0;
+		playing = false;
+		underruns++;
+	}
+}
+
+void DacEmulator::Receive(uint64_t now)
+{
+	//A real DAC takes one client, the newest connection wins
+	int lastId = server.getLastID() - 1;
+	if (lastId >= 0 && lastId != clientId && server.isClientConnected(lastId))
+	{
+		ofLogNotice("DacEmulator") << "Client connected from " << server.getClientIP(lastId);
+		clientId = lastId;
+		receivedCount = 0;
+		fullness = 0.0;
+		playing = false;
+		underruns = 0;
+	}
+	if (clientId < 0 || !server.isClientConnected(clientId))
+		return;
+
+	while (true)
+	{
+		//Read the header first, then exactly the points it announces
+		int wanted = LaserDacProtocol::HeaderSize;
+		LaserDacHeader header;
+		if (receivedCount >= LaserDacProtocol::HeaderSize)
+		{
+			if (!LaserDacProtocol::DecodeHeader(received.data(), header) || header.pointCount > LaserDacProtocol::MaxPointsPerPacket)
+			{
+				ofLogError("DacEmulator") << "Bad packet, dropping the client";
+				server.disconnectClient(clientId);
+				clientId = -1;
+				return;
+			}
+			wanted += header.pointCount * LaserDacProtocol::PointSize;
+		}
+		if (receivedCount < wanted)
+		{
+			int bytes = server.receiveRawBytes(clientId, (char*)received.data() + receivedCount, wanted - receivedCount);
+			if (bytes <= 0)
+				return;
+			receivedCount += bytes;
+			continue;
+		}
+		HandlePacket(header, now);
+		receivedCount = 0;
+	}
+}
+
+void DacEmulator::HandlePacket(const LaserDacHeader& header, uint64_t now)
+{
+	//The first point of the packet is shown once everything queued before it has played
+	pointsPerSecond = std::max<uint32_t>(header.pointsPerSecond, 1);
+	double latency = (now - header.sendTimeMicros) / 1e3 + fullness / pointsPerSecond * 1e3;
+	latencySum += latency;
+	latencyMax = std::max(latencyMax, latency);
+	packets++;
+
+	double space = params.bufferCapacity - fullness;
+	double accepted = std::min<double>(header.pointCount, space);
+	fullness += accepted;
+	pointsReceived += header.pointCount;
+	pointsOverflowed += header.pointCount - (uint64_t)accepted;
+	if (fullness > 0.0)
+		playing = true;
+
+	LaserDacStatus status;
+	status.bufferFullness = (uint32_t)fullness;
+	status.bufferCapacity = params.bufferCapacity;
+	status.underruns = underruns;
+	status.echoSendTimeMicros = header.sendTimeMicros;
+	uint8_t reply[LaserDacProtocol::StatusSize];
+	LaserDacProtocol::EncodeStatus(reply, status);
+	server.sendRawBytes(clientId, (const char*)reply, LaserDacProtocol::StatusSize);
+}
+
+void DacEmulator::Report(double seconds)
+{
+	ofLogNotice("DacEmulator") << pointsReceived / seconds << " points/s of " << pointsPerSecond
+		<< ", buffer " << (int)fullness << "/" << params.bufferCapacity
+		<< ", " << underruns << " underruns, " << pointsOverflowed << " overflowed"
+		<< ", latency avg " << (packets > 0 ? latencySum / packets : 0.0) << "ms max " << latencyMax << "ms";
+	pointsReceived = 0;
+	pointsOverflowed = 0;
+	packets = 0;
+	latencySum = 0.0;
+	latencyMax = 0.0;
+}
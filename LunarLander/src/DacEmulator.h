@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ofxNetwork.h"
+#include "LaserDacProtocol.h"
+
+struct DacEmulatorParams {
+	int port = LaserDacProtocol::DefaultPort;
+	int bufferCapacity = 4096;	//Points the emulated DAC can queue
+	float seconds = 0.f;	//Run time, 0 runs until the process is killed
+};
+
+//Stands in for a network laser DAC: accepts the protocol of NetworkLaserOutput, plays the points back
+//at the requested rate against the wall clock and reports throughput, underruns and latency every second.
+class DacEmulator
+{
+	DacEmulatorParams params;
+	ofxTCPServer server;
+
+	std::vector<uint8_t> received;
+	int receivedCount = 0;
+	int clientId = -1;
+
+	double fullness = 0.0;	//Points queued, fractional as playback runs on the clock
+	uint32_t pointsPerSecond = 30000;
+	uint64_t lastPlayTime = 0;
+	bool playing = false;
+	uint32_t underruns = 0;
+
+	//Per report interval
+	uint64_t pointsReceived = 0;
+	uint64_t pointsOverflowed = 0;
+	uint64_t packets = 0;
+	double latencySum = 0.0;
+	double latencyMax = 0.0;
+
+	void Play(uint64_t now);
+	void Receive(uint64_t now);
+	void HandlePacket(const LaserDacHeader& header, uint64_t now);
+	void Report(double seconds);
+
+public:
+
+	int Run(const DacEmulatorParams& params);
+};
@@ -0,0 +1,201 @@
+#include "DrawList.h"
+#include "Simd.h"
+
+DrawList::DrawList()
+{
+	Clear();
+}
+
+void DrawList::Clear()
+{
+	commands.clear();
+	vertices.clear();
+	transforms.clear();
+	meshes.clear();
+	text.clear();
+	//Transform 0 is always the identity
+	transforms.push_back(DrawTransform());
+	view = DrawTransform();
+}
+
+void DrawList::SetView(const DrawTransform& view)
+{
+	this->view = view;
+}
+
+int DrawList::AddTransform(const DrawTransform& transform)
+{
+	if (transforms.size() > 0xFFFF)
+	{
+		ofLogWarning("DrawList") << "Out of transforms";
+		return 0;
+	}
+	transforms.push_back(transform);
+	return transforms.size() - 1;
+}
+
+void DrawList::AddPolyline(const ofPolyline& line, const ofColor& color, int transform, uint8_t flags)
+{
+	uint32_t first = vertices.size();
+	for (const ofDefaultVertexType& v : line)
+	{
+		vertices.push_back(ofVec2f(v.x, v.y));
+	}
+	if (line.isClosed())
+		flags |= DrawClosed;
+	uint32_t count = vertices.size() - first;
+	AddCommand(DrawCommandType::Polyline, color, transform, flags, first, count, first, count);
+}
+
+void DrawList::AddPolyline(const ofPolyline& line, const ofPolyline& outline, const ofColor& color, int transform, uint8_t flags)
+{
+	uint32_t first = vertices.size();
+	for (const ofDefaultVertexType& v : line)
+	{
+		vertices.push_back(ofVec2f(v.x, v.y));
+	}
+	uint32_t outlineFirst = vertices.size();
+	for (const ofDefaultVertexType& v : outline)
+	{
+		vertices.push_back(ofVec2f(v.x, v.y));
+	}
+	if (line.isClosed())
+		flags |= DrawClosed;
+	AddCommand(DrawCommandType::Polyline, color, transform, flags, first, outlineFirst - first, outlineFirst, vertices.size() - outlineFirst);
+}
+
+void DrawList::AddPolygon(const ofVec2f* vertices, int count, const ofColor& color, int transform, uint8_t flags, const ofVec2f* outline, int outlineCount)
+{
+	uint32_t first = this->vertices.size();
+	this->vertices.insert(this->vertices.end(), vertices, vertices + count);
+	uint32_t outlineFirst = first;
+	if (outlineCount < 0)
+		outlineCount = count;
+	else if (outline)
+	{
+		outlineFirst = this->vertices.size();
+		this->vertices.insert(this->vertices.end(), outline, outline + outlineCount);
+	}
+	AddCommand(DrawCommandType::Polyline, color, transform, flags, first, count, outlineFirst, outlineCount);
+}
+
+void DrawList::AddLine(ofVec2f from, ofVec2f to, const ofColor& color, uint8_t flags)
+{
+	uint32_t first = vertices.size();
+	vertices.push_back(from);
+	vertices.push_back(to);
+	AddCommand(DrawCommandType::Polyline, color, 0, flags, first, 2, first, 2);
+}
+
+void DrawList::AddMesh(const ofMesh& mesh, int transform, uint8_t flags)
+{
+	meshes.push_back(&mesh);
+	AddCommand(DrawCommandType::Mesh, ofColor::white, transform, flags | DrawRasterOnly, meshes.size() - 1, 0, 0, 0);
+}
+
+void DrawList::AddText(const std::string& text, ofVec2f position, const ofColor& color, uint8_t flags)
+{
+	uint32_t first = this->text.size();
+	this->text += text;
+	DrawTransform placement;
+	placement.translation = position;
+	AddCommand(DrawCommandType::Text, color, AddTransform(placement), flags, first, text.size(), 0, 0);
+}
+
+const std::vector<DrawCommand>& DrawList::GetCommands() const
+{
+	return commands;
+}
+
+const ofVec2f* DrawList::GetVertices() const
+{
+	return vertices.data();
+}
+
+const DrawTransform& DrawList::GetTransform(int idx) const
+{
+	return transforms[idx];
+}
+
+const ofMesh& DrawList::GetMesh(int idx) const
+{
+	return *meshes[idx];
+}
+
+const char* DrawList::GetText() const
+{
+	return text.data();
+}
+
+const DrawTransform& DrawList::GetView() const
+{
+	return view;
+}
+
+DrawTransform DrawList::GetFullTransform(const DrawCommand& command) const
+{
+	const DrawTransform& transform = transforms[command.transform];
+	if (command.flags & DrawScreenSpace)
+		return transform;
+	return Combine(view, transform);
+}
+
+int DrawList::GetVertexCount() const
+{
+	return vertices.size();
+}
+
+DrawTransform DrawList::Combine(const DrawTransform& outer, const DrawTransform& inner)
+{
+	DrawTransform combined;
+	combined.translation = Apply(outer, inner.translation);
+	combined.rotationRad = outer.rotationRad + inner.rotationRad;
+	combined.scale = outer.scale * inner.scale;
+	return combined;
+}
+
+ofVec2f DrawList::Apply(const DrawTransform& transform, ofVec2f point)
+{
+	float cosR = cos(transform.rotationRad) * transform.scale, sinR = sin(transform.rotationRad) * transform.scale;
+	return ofVec2f(cosR * point.x - sinR * point.y, sinR * point.x + cosR * point.y) + transform.translation;
+}
+
+void DrawList::Apply(const DrawTransform& transform, const ofVec2f* in, int count, ofVec2f* out)
+{
+	float cosR = cos(transform.rotationRad) * transform.scale, sinR = sin(transform.rotationRad) * transform.scale;
+	int i = 0;
+#ifdef LUNAR_SSE2
+	//Two interleaved points per register: x' = c*x - s*y + tx, y' = c*y + s*x + ty
+	__m128 c = _mm_set1_ps(cosR);
+	__m128 s = _mm_setr_ps(-sinR, sinR, -sinR, sinR);
+	__m128 t = _mm_setr_ps(transform.translation.x, transform.translation.y, transform.translation.x, transform.translation.y);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 a = _mm_loadu_ps(&in[i].x);
+		__m128 b = _mm_loadu_ps(&in[i + 2].x);
+		__m128 aSwapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 bSwapped = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+		_mm_storeu_ps(&out[i].x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, c), _mm_mul_ps(aSwapped, s)), t));
+		_mm_storeu_ps(&out[i + 2].x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(b, c), _mm_mul_ps(bSwapped, s)), t));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		ofVec2f p = in[i];
+		out[i] = ofVec2f(cosR * p.x - sinR * p.y + transform.translation.x, sinR * p.x + cosR * p.y + transform.translation.y);
+	}
+}
+
+void DrawList::AddCommand(DrawCommandType type, const ofColor& color, int transform, uint8_t flags, uint32_t first, uint32_t count, uint32_t outlineFirst, uint32_t outlineCount)
+{
+	DrawCommand command;
+	command.type = type;
+	command.flags = flags;
+	command.color = color;
+	command.transform = (uint16_t)transform;
+	command.first = first;
+	command.count = count;
+	command.outlineFirst = outlineFirst;
+	command.outlineCount = outlineCount;
+	commands.push_back(command);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ofMain.h"
+
+//Scale, then rotate, then translate
+struct DrawTransform {
+	ofVec2f translation = ofVec2f(0.f, 0.f);
+	float rotationRad = 0.f;
+	float scale = 1.f;
+};
+
+enum DrawFlags : uint8_t {
+	DrawClosed = 1,	//The polyline ends on its first vertex again
+	DrawFilled = 2,	//Raster outputs fill the polygon, it has to be convex
+	DrawStatic = 4,	//Doesn't move between frames, outputs may cache work on it
+	DrawScreenSpace = 8,	//Not moved by the view, for the HUD
+	DrawRasterOnly = 16,	//Skipped by vector outputs (laser, SVG)
+	DrawVectorOnly = 32,	//Skipped by raster outputs, e.g. a simplified outline of something they draw in full
+};
+
+enum class DrawCommandType : uint8_t {
+	Polyline,	//Vertices in the list's vertex pool
+	Mesh,	//An ofMesh owned by the recorder with its own vertex colors, raster outputs only
+	Text,	//Characters in the list's text pool, the transform places it
+};
+
+struct DrawCommand {
+	DrawCommandType type;
+	uint8_t flags;
+	ofColor color;
+	uint16_t transform;	//Index into the transforms of the list, 0 is the identity
+	uint32_t first;	//First vertex, first character or the mesh index
+	uint32_t count;
+	uint32_t outlineFirst;	//Coarser outline for the laser, the same span as first and count when the recorder has none
+	uint32_t outlineCount;	//0 keeps the command off the laser
+};
+
+//What was recorded in a frame, backend-neutral. Everything lives in a few pools that keep their capacity
+//between frames, so recording allocates nothing once the scene has been seen.
+class DrawList
+{
+	std::vector<DrawCommand> commands;
+	std::vector<ofVec2f> vertices;
+	std::vector<DrawTransform> transforms;
+	std::vector<const ofMesh*> meshes;
+	std::string text;
+	DrawTransform view;
+
+	void AddCommand(DrawCommandType type, const ofColor& color, int transform, uint8_t flags, uint32_t first, uint32_t count, uint32_t outlineFirst, uint32_t outlineCount);
+
+public:
+
+	DrawList();
+
+	void Clear();
+	//Applied after the transform of every command that isn't in screen space, e.g. the camera
+	void SetView(const DrawTransform& view);
+	int AddTransform(const DrawTransform& transform);
+
+	void AddPolyline(const ofPolyline& line, const ofColor& color, int transform = 0, uint8_t flags = 0);
+	void AddPolyline(const ofPolyline& line, const ofPolyline& outline, const ofColor& color, int transform = 0, uint8_t flags = 0);
+	//outlineCount -1 uses the vertices as outline too
+	void AddPolygon(const ofVec2f* vertices, int count, const ofColor& color, int transform = 0, uint8_t flags = 0, const ofVec2f* outline = nullptr, int outlineCount = -1);
+	void AddLine(ofVec2f from, ofVec2f to, const ofColor& color, uint8_t flags = 0);
+	//The mesh has to outlive the frame
+	void AddMesh(const ofMesh& mesh, int transform = 0, uint8_t flags = 0);
+	void AddText(const std::string& text, ofVec2f position, const ofColor& color, uint8_t flags = 0);
+
+	const std::vector<DrawCommand>& GetCommands() const;
+	const ofVec2f* GetVertices() const;
+	const DrawTransform& GetTransform(int idx) const;
+	const ofMesh& GetMesh(int idx) const;
+	const char* GetText() const;
+	const DrawTransform& GetView() const;
+	//Transform of a command including the view
+	DrawTransform GetFullTransform(const DrawCommand& command) const;
+	int GetVertexCount() const;
+
+	//outer after inner
+	static DrawTransform Combine(const DrawTransform& outer, const DrawTransform& inner);
+	static ofVec2f Apply(const DrawTransform& transform, ofVec2f point);
+	//Transforms count points from in to out, vectorized; in and out may be the same array
+	static void Apply(const DrawTransform& transform, const ofVec2f* in, int count, ofVec2f* out);
+};
+
+//Turns a recorded frame into output
+class DrawBackend
+{
+public:
+
+	virtual ~DrawBackend() {}
+
+	virtual void Draw(const DrawList& list) = 0;
+};
+
+//Walks the list without producing anything, for measuring the recording side
+class NullDrawBackend : public DrawBackend
+{
+public:
+
+	uint64_t commands = 0;
+	uint64_t vertices = 0;
+	uint64_t characters = 0;
+
+	void Draw(const DrawList& list) override
+	{
+		for (const DrawCommand& command : list.GetCommands())
+		{
+			commands++;
+			if (command.type == DrawCommandType::Polyline)
+				vertices += command.count;
+			else if (command.type == DrawCommandType::Mesh)
+				vertices += list.GetMesh(command.first).getNumVertices();
+			else if (command.type == DrawCommandType::Text)
+				characters += command.count;
+		}
+	}
+};
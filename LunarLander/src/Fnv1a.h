@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//FNV-1a over raw bytes, for hashes that only have to tell equal input from different input:
+//world states compared between runs and peers, snapshots and baked asset sources
+const uint32_t Fnv1aOffset32 = 2166136261u;
+const uint64_t Fnv1aOffset64 = 0xCBF29CE484222325ull;
+
+inline void Fnv1a(uint32_t& hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+}
+
+inline void Fnv1a(uint64_t& hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+	}
+}
@@ -0,0 +1,100 @@
+#include "GlDrawBackend.h"
+
+GlDrawBackend::GlDrawBackend()
+{
+	lines.setMode(OF_PRIMITIVE_LINES);
+	fills.setMode(OF_PRIMITIVE_TRIANGLES);
+}
+
+void GlDrawBackend::Draw(const DrawList& list)
+{
+	ofPushStyle();
+	//Once for the whole list, translucent batches carry their alpha per vertex
+	ofEnableAlphaBlending();
+	for (const DrawCommand& command : list.GetCommands())
+	{
+		if (command.flags & DrawVectorOnly)
+			continue;
+		if (command.type == DrawCommandType::Polyline)
+		{
+			AddPolyline(list, command);
+			continue;
+		}
+
+		Flush();
+		DrawTransform transform = list.GetFullTransform(command);
+		if (command.type == DrawCommandType::Mesh)
+		{
+			ofPushMatrix();
+			ofTranslate(transform.translation);
+			ofRotateRad(transform.rotationRad);
+			ofScale(transform.scale);
+			list.GetMesh(command.first).draw();
+			ofPopMatrix();
+		}
+		else if (command.type == DrawCommandType::Text)
+		{
+			ofSetColor(command.color);
+			ofDrawBitmapString(std::string(list.GetText() + command.first, command.count), transform.translation);
+		}
+	}
+	Flush();
+	ofPopStyle();
+}
+
+void GlDrawBackend::AddPolyline(const DrawList& list, const DrawCommand& command)
+{
+	if (command.count < 2)
+		return;
+	transformed.resize(command.count);
+	DrawList::Apply(list.GetFullTransform(command), list.GetVertices() + command.first, command.count, transformed.data());
+	auto vertex = [&](uint32_t i) {
+		return ofDefaultVertexType(transformed[i].x, transformed[i].y, 0.f);
+	};
+	ofFloatColor color(command.color);
+
+	if (command.flags & DrawFilled)
+	{
+		//A fan around the first vertex, fine for the convex shapes we fill
+		ofDefaultVertexType first = vertex(0);
+		ofDefaultVertexType previous = vertex(1);
+		for (uint32_t i = 2; i < command.count; i++)
+		{
+			ofDefaultVertexType current = vertex(i);
+			fills.addVertex(first);
+			fills.addVertex(previous);
+			fills.addVertex(current);
+			for (int c = 0; c < 3; c++)
+			{
+				fills.addColor(color);
+			}
+			previous = current;
+		}
+		return;
+	}
+
+	int segments = command.flags & DrawClosed ? command.count : command.count - 1;
+	ofDefaultVertexType previous = vertex(0);
+	for (int i = 1; i <= segments; i++)
+	{
+		ofDefaultVertexType current = vertex(i % command.count);
+		lines.addVertex(previous);
+		lines.addVertex(current);
+		lines.addColor(color);
+		lines.addColor(color);
+		previous = current;
+	}
+}
+
+void GlDrawBackend::Flush()
+{
+	//The meshes keep their capacity between frames
+	if (fills.getNumVertices() > 0)
+		fills.draw();
+	if (lines.getNumVertices() > 0)
+		lines.draw();
+	fills.clear();
+	lines.clear();
+	fills.setMode(OF_PRIMITIVE_TRIANGLES);
+	lines.setMode(OF_PRIMITIVE_LINES);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "DrawList.h"
+
+//Draws a list with OpenGL. Lines and fills are transformed on the CPU and batched into one mesh each,
+//so a run of polylines costs two draw calls; meshes and text flush the batches to keep the order.
+class GlDrawBackend : public DrawBackend
+{
+	ofMesh lines;
+	ofMesh fills;
+	std::vector<ofVec2f> transformed;	//Vertices of the command being batched
+
+	void AddPolyline(const DrawList& list, const DrawCommand& command);
+	void Flush();
+
+public:
+
+	GlDrawBackend();
+
+	void Draw(const DrawList& list) override;
+};
@@ -0,0 +1,909 @@
+#include "HeadlessRunner.h"
+#include "NetworkLaserOutput.h"
+#include "IldaRecorder.h"
+#include "LaserDrawBackend.h"
+#include "AllocationCounter.h"
+#include "RollbackSession.h"
+#include "UdpInputTransport.h"
+#include "StateServer.h"
+#include "StateClient.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+
+int HeadlessRunner::Run(int argc, char** argv)
+{
+	ofInit();
+	ParseArguments(argc, argv);
+
+	if (params.runDacEmulator)
+	{
+		DacEmulator emulator;
+		return emulator.Run(params.dacEmulatorParams);
+	}
+	if (params.bakeAssets)
+		return LanderAssets::BakeFolder(LanderAssets::GetResourceFolder(), params.bakeParams) > 0 ? 1 : 0;
+	if (!params.replayPath.empty())
+		return Replay();
+	if (!params.ildaPlayPath.empty())
+		return PlayIlda();
+	if (params.renderFrames > 0)
+		return BenchRender();
+	if (params.snapshotRestores > 0)
+		return BenchSnapshots();
+	if (params.netClients > 0)
+		return NetLoopback();
+	if (params.spectators > 0)
+		return BroadcastLoopback();
+	if (params.batchLanders > 0 || params.batchValidate > 0)
+		return BatchLanders();
+	if (params.crashCheck)
+		return CheckCrashes();
+
+	//Per-round logging would dominate the step cost
+	ofLogLevel previousLogLevel = ofGetLogLevel();
+	if (!params.verbose)
+		ofSetLogLevel(OF_LOG_WARNING);
+
+	std::vector<RolloutJob> jobs(params.rounds);
+	for (int i = 0; i < params.rounds; i++)
+	{
+		jobs[i].terrainSeed = params.seed + i;
+		jobs[i].maxSteps = params.maxStepsPerRound;
+		jobs[i].settleSteps = params.settleSteps;
+	}
+
+	BatchRunParams batchParams;
+	batchParams.threadCount = params.threads;
+	batchParams.arenaWidth = params.arenaWidth;
+	batchParams.arenaHeight = params.arenaHeight;
+	batchParams.streamingTerrain = params.streamingTerrain;
+	BatchRunner runner(batchParams);
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<RolloutResult> results = runner.Run(jobs, LanderPolicy());
+	auto end = std::chrono::steady_clock::now();
+
+	uint64_t totalSteps = 0, totalEvents = 0;
+	int landedRounds = 0, crashedRounds = 0;
+	for (auto& result : results)
+	{
+		totalSteps += result.steps;
+		totalEvents += result.contactEvents;
+		landedRounds += result.landed;
+		crashedRounds += result.crashed;
+	}
+
+	ofSetLogLevel(previousLogLevel);
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	ofLogNotice("Headless") << params.rounds << " rounds on " << runner.GetThreadCount() << " threads, " << landedRounds << " landed, " << crashedRounds << " crashed, " << totalSteps << " steps in " << seconds << "s";
+	ofLogNotice("Headless") << (seconds > 0.0 ? totalSteps / seconds : 0.0) << " steps/s, " << (seconds > 0.0 ? params.rounds / seconds * 60.0 : 0.0) << " rounds/min";
+	ofLogNotice("Headless") << (totalSteps > 0 ? totalEvents / (double)totalSteps : 0.0) << " contact events/step";
+	return 0;
+}
+
+void HeadlessRunner::ParseArguments(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--rounds") && hasValue)
+			params.rounds = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--max-steps") && hasValue)
+			params.maxStepsPerRound = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--settle-steps") && hasValue)
+			params.settleSteps = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--seed") && hasValue)
+			params.seed = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--threads") && hasValue)
+			params.threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--streaming"))
+			params.streamingTerrain = true;
+		else if (!strcmp(argv[i], "--dac-emulator"))
+			params.runDacEmulator = true;
+		else if (!strcmp(argv[i], "--dac-port") && hasValue)
+			params.dacEmulatorParams.port = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--dac-buffer") && hasValue)
+			params.dacEmulatorParams.bufferCapacity = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--dac-seconds") && hasValue)
+			params.dacEmulatorParams.seconds = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--ilda-play") && hasValue)
+			params.ildaPlayPath = argv[++i];
+		else if (!strcmp(argv[i], "--ilda-speed") && hasValue)
+			params.ildaPlayerParams.speed = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--ilda-loop"))
+			params.ildaPlayerParams.loop = true;
+		else if (!strcmp(argv[i], "--ilda-seconds") && hasValue)
+			params.ildaPlayerParams.seconds = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--ilda-record") && hasValue)
+			params.ildaRecordPath = argv[++i];
+		else if (!strcmp(argv[i], "--dac") && hasValue)
+			params.dacAddress = argv[++i];
+		else if (!strcmp(argv[i], "--render-frames") && hasValue)
+			params.renderFrames = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--replay") && hasValue)
+			params.replayPath = argv[++i];
+		else if (!strcmp(argv[i], "--snapshot-restores") && hasValue)
+			params.snapshotRestores = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--net-clients") && hasValue)
+			params.netClients = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--net-port") && hasValue)
+			params.netPort = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--net-rollback") && hasValue)
+			params.netRollbackTicks = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--net-seconds") && hasValue)
+			params.netSeconds = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--net-latency") && hasValue)
+			params.netShimParams.latencyMillis = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--net-jitter") && hasValue)
+			params.netShimParams.jitterMillis = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--net-loss") && hasValue)
+			params.netShimParams.loss = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--net-desync") && hasValue)
+			params.netDesyncTick = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--spectators") && hasValue)
+			params.spectators = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--state-port") && hasValue)
+			params.statePort = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--batch-landers") && hasValue)
+			params.batchLanders = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--batch-steps") && hasValue)
+			params.batchSteps = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--batch-validate") && hasValue)
+			params.batchValidate = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--batch-tolerance") && hasValue)
+			params.batchTolerance = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--crash-check"))
+			params.crashCheck = true;
+		else if (!strcmp(argv[i], "--replay-stop"))
+			params.replayParams.stopOnMismatch = true;
+		else if (!strcmp(argv[i], "--bake-assets"))
+			params.bakeAssets = true;
+		else if (!strcmp(argv[i], "--force-bake"))
+			params.bakeParams.force = true;
+		else if (!strcmp(argv[i], "--verbose"))
+			params.verbose = true;
+		else
+			ofLogWarning("Headless") << "Unknown argument " << argv[i];
+	}
+}
+
+int HeadlessRunner::PlayIlda()
+{
+	params.ildaPlayerParams.screenWidth = params.arenaWidth;
+	params.ildaPlayerParams.screenHeight = params.arenaHeight;
+	IldaPlayer player;
+	if (!player.Open(params.ildaPlayPath, params.ildaPlayerParams))
+		return 1;
+
+	LaserOutput* output;
+	if (!params.dacAddress.empty())
+	{
+		NetworkLaserOutputParams outputParams;
+		NetworkLaserOutput::ParseAddress(params.dacAddress, outputParams);
+		outputParams.screenWidth = params.arenaWidth;
+		outputParams.screenHeight = params.arenaHeight;
+		NetworkLaserOutput* network = new NetworkLaserOutput();
+		network->Setup(outputParams);
+		output = network;
+	}
+	else if (!params.ildaRecordPath.empty())
+	{
+		IldaRecorderParams recorderParams;
+		recorderParams.path = params.ildaRecordPath;
+		recorderParams.screenWidth = params.arenaWidth;
+		recorderParams.screenHeight = params.arenaHeight;
+		IldaRecorder* recorder = new IldaRecorder();
+		if (!recorder->Open(recorderParams))
+		{
+			delete recorder;
+			return 1;
+		}
+		output = recorder;
+	}
+	else
+		output = new NullLaserOutput();
+
+	IldaPlayerStats stats = player.Play(*output);
+	//Deleting the output drains and closes it
+	delete output;
+
+	ofLogNotice("Headless") << stats.frames << " frames, " << stats.points << " points in " << stats.seconds << "s, " << stats.framesDropped << " dropped";
+	ofLogNotice("Headless") << (stats.seconds > 0.0 ? stats.frames / stats.seconds : 0.0) << " frames/s, " << (stats.seconds > 0.0 ? stats.points / stats.seconds : 0.0) << " points/s";
+	return 0;
+}
+
+int HeadlessRunner::BenchRender()
+{
+	ofLogLevel previousLogLevel = ofGetLogLevel();
+	if (!params.verbose)
+		ofSetLogLevel(OF_LOG_WARNING);
+	Simulation simulation;
+	simulation.SetStreamingTerrain(params.streamingTerrain);
+	simulation.Setup(params.arenaWidth, params.arenaHeight);
+	simulation.SetTerrainSeed(params.seed);
+	simulation.StartRound();
+
+	DrawList list;
+	SceneRecorder recorder;
+	LaserFrameBuilder laserFrame;
+	laserFrame.Setup(LaserFrameParams());
+	LaserLodController laserLod;
+	laserLod.Setup(LaserLodParams());
+	LaserDrawBackend laserBackend;
+	laserBackend.SetFrame(&laserFrame);
+	NullDrawBackend nullBackend;
+
+	//Same work per frame as the app, minus the GL submission
+	typedef std::chrono::steady_clock Clock;
+	Clock::duration recordTime(0), nullTime(0), laserTime(0);
+	//The pools of the simulation, the list and the laser frame grow over the first frames, allocations only
+	//count after that; a steady frame allocates nothing from the step to the laser points
+	int warmupFrames = std::min(60, params.renderFrames / 2);
+	uint64_t stepAllocations = 0, recordAllocations = 0, laserAllocations = 0;
+	float maxLitStep = 0.f, maxBlankStep = 0.f;
+	for (int i = 0; i < params.renderFrames; i++)
+	{
+		uint64_t allocationsBefore = AllocationCounter::GetCount();
+		simulation.Step(LanderControls());
+		uint64_t allocationsStepped = AllocationCounter::GetCount();
+		Clock::time_point start = Clock::now();
+		float cameraX = params.streamingTerrain ? simulation.GetLander()->GetPosition().x - params.arenaWidth / 2.f : 0.f;
+		recorder.Record(simulation, laserLod, cameraX, false, list);
+		Clock::time_point recorded = Clock::now();
+		uint64_t allocationsRecorded = AllocationCounter::GetCount();
+		nullBackend.Draw(list);
+		Clock::time_point walked = Clock::now();
+		laserBackend.Draw(list);
+		laserLod.Update(laserFrame.GetStats(), laserFrame.GetBudget());
+		Clock::time_point lasered = Clock::now();
+		maxLitStep = std::max(maxLitStep, laserFrame.GetStats().maxLitStep);
+		maxBlankStep = std::max(maxBlankStep, laserFrame.GetStats().maxBlankStep);
+		if (i >= warmupFrames)
+		{
+			stepAllocations += allocationsStepped - allocationsBefore;
+			recordAllocations += allocationsRecorded - allocationsStepped;
+			laserAllocations += AllocationCounter::GetCount() - allocationsRecorded;
+		}
+		recordTime += recorded - start;
+		nullTime += walked - recorded;
+		laserTime += lasered - walked;
+	}
+
+	auto perFrame = [&](Clock::duration time) { return std::chrono::duration<double, std::micro>(time).count() / params.renderFrames; };
+	ofSetLogLevel(previousLogLevel);
+	ofLogNotice("Headless") << params.renderFrames << " frames, " << nullBackend.commands / (double)params.renderFrames << " commands and " << nullBackend.vertices / (double)params.renderFrames << " vertices per frame";
+	ofLogNotice("Headless") << perFrame(recordTime) << "us record, " << perFrame(nullTime) << "us walk, " << perFrame(laserTime) << "us laser per frame";
+	ofLogNotice("Headless") << recorder.GetHud().GetFormatCount() << " HUD lines formatted";
+	int result = 0;
+	//The galvos follow no step longer than the resampler was asked for, lit or blanked
+	const LaserFrameParams& laserParams = laserFrame.GetParams();
+	ofLogNotice("Headless") << maxLitStep << " longest lit step of " << laserParams.maxStep << ", " << maxBlankStep << " longest blank step of " << laserParams.maxBlankStep;
+	if (maxLitStep > laserParams.maxStep + .01f || maxBlankStep > laserParams.maxBlankStep + .01f)
+	{
+		ofLogError("Headless") << "Laser steps longer than the resampler allows";
+		result = 1;
+	}
+	if (AllocationCounter::IsEnabled())
+	{
+		ofLogNotice("Headless") << stepAllocations << " allocations stepping, " << recordAllocations << " recording and " << laserAllocations << " drawing the laser after " << warmupFrames << " warmup frames";
+		if (stepAllocations + recordAllocations + laserAllocations > 0)
+			result = 1;
+	}
+	return result;
+}
+
+int HeadlessRunner::Replay()
+{
+	InputReplayer replayer;
+	if (!replayer.Open(params.replayPath))
+		return 1;
+	ofLogLevel previousLogLevel = ofGetLogLevel();
+	if (!params.verbose)
+		ofSetLogLevel(OF_LOG_WARNING);
+	InputReplayStats stats = replayer.Run(params.replayParams);
+	ofSetLogLevel(previousLogLevel);
+
+	const InputLogHeader& header = replayer.GetHeader();
+	double played = stats.ticks * header.timeStep;
+	ofLogNotice("Headless") << stats.ticks << " ticks and " << stats.events << " events replayed in " << stats.seconds << "s, " << (stats.seconds > 0.0 ? stats.ticks / stats.seconds : 0.0) << " ticks/s, " << (stats.seconds > 0.0 ? played / stats.seconds : 0.0) << "x real time";
+	ofLogNotice("Headless") << "Final hash " << ofToHex(stats.finalHash);
+	if (stats.mismatches > 0)
+	{
+		ofLogError("Headless") << stats.mismatches << " ticks differ from the recording, the first is tick " << stats.firstMismatch;
+		return 1;
+	}
+	return 0;
+}
+
+//Just above the ground, so it rests on it after a second or two and its contacts with the terrain are part
+//of the state from then on
+static void DropDebris(Simulation& simulation)
+{
+	TerrainHeightField ground;
+	if (simulation.GetSurface())
+		ground.Setup(simulation.GetSurface()->GetTerrain(), simulation.GetArenaWidth(), simulation.GetArenaHeight());
+	auto groundY = [&](float x) {
+		return simulation.GetSurface() ? ground.GetHeight(x / OFX_BOX2D_SCALE) * OFX_BOX2D_SCALE : simulation.GetArenaHeight() * .5f;
+	};
+	for (int i = 0; i < 10; i++)
+	{
+		float x = 100.f + i * 40.f;
+		simulation.SpawnCircle(x, groundY(x) - 12.f, 8.f);
+		simulation.SpawnBox(x + 20.f, groundY(x + 20.f) - 10.f, 10.f, 6.f);
+	}
+}
+
+int HeadlessRunner::BenchSnapshots()
+{
+	ofLogLevel previousLogLevel = ofGetLogLevel();
+	if (!params.verbose)
+		ofSetLogLevel(OF_LOG_WARNING);
+	Simulation simulation;
+	simulation.SetStreamingTerrain(params.streamingTerrain);
+	simulation.Setup(params.arenaWidth, params.arenaHeight);
+	simulation.SetTerrainSeed(params.seed);
+	simulation.StartRound();
+	//The debris is resting on the ground by the time of the capture, so the contacts a restore drops and
+	//finds again are part of every branch
+	DropDebris(simulation);
+
+	SnapshotArena arena;
+	arena.Setup(1, 64);
+	SimulationSnapshot& snapshot = arena.Get(0);
+	LanderControls controls;
+	controls.thrustDelta = .002f;
+
+	//Branch off the same tick over and over: the ticks after a restore should hash like the first branch
+	const int branchTicks = 30;
+	uint32_t hashes[branchTicks];
+	for (int i = 0; i < 120; i++)
+	{
+		simulation.Step(controls);
+	}
+	int touching = 0;
+	for (b2Contact* contact = simulation.GetWorld()->getWorld()->GetContactList(); contact; contact = contact->GetNext())
+	{
+		touching += contact->IsTouching() && !contact->GetFixtureA()->IsSensor() && !contact->GetFixtureB()->IsSensor();
+	}
+	//The first branch goes on from a checkpoint, as every later one goes on from a restore
+	typedef std::chrono::steady_clock Clock;
+	Clock::duration captureTime(0), restoreTime(0);
+	Clock::time_point start = Clock::now();
+	simulation.Checkpoint(snapshot);
+	captureTime += Clock::now() - start;
+	for (int t = 0; t < branchTicks; t++)
+	{
+		simulation.Step(controls);
+		hashes[t] = simulation.HashState();
+	}
+
+	int divergedBranches = 0;
+	for (int i = 0; i < params.snapshotRestores; i++)
+	{
+		start = Clock::now();
+		simulation.Restore(snapshot);
+		restoreTime += Clock::now() - start;
+		bool diverged = false;
+		for (int t = 0; t < branchTicks; t++)
+		{
+			simulation.Step(controls);
+			diverged |= simulation.HashState() != hashes[t];
+		}
+		divergedBranches += diverged;
+	}
+
+	ofSetLogLevel(previousLogLevel);
+	ofLogNotice("Headless") << std::chrono::duration<double, std::micro>(captureTime).count() << "us checkpoint, " << std::chrono::duration<double, std::micro>(restoreTime).count() / params.snapshotRestores << "us restore on average";
+	ofLogNotice("Headless") << touching << " touching contacts at the checkpoint";
+	if (divergedBranches > 0)
+	{
+		ofLogError("Headless") << divergedBranches << " of " << params.snapshotRestores << " branches of " << branchTicks << " ticks differ from the first";
+		return 1;
+	}
+	ofLogNotice("Headless") << "All " << params.snapshotRestores << " branches of " << branchTicks << " ticks match the first";
+	return 0;
+}
+
+int HeadlessRunner::NetLoopback()
+{
+	ofLogLevel previousLogLevel = ofGetLogLevel();
+	if (!params.verbose)
+		ofSetLogLevel(OF_LOG_WARNING);
+
+	//Every client is a whole peer with its own world, socket and bad network, all ticked from this thread
+	struct Client {
+		Simulation simulation;
+		UdpInputTransport transport;
+		LatencyShim* shim = nullptr;
+		RollbackSession session;
+		FastRandom random;
+		NetInput input;
+	};
+	int count = params.netClients;
+	std::vector<Client*> clients;
+	for (int i = 0; i < count; i++)
+	{
+		Client* client = new Client();
+		client->simulation.SetPlayerCount(count);
+		client->simulation.SetStreamingTerrain(params.streamingTerrain);
+		client->simulation.Setup(params.arenaWidth, params.arenaHeight);
+		client->simulation.SetTerrainSeed(params.seed);
+		UdpInputTransportParams transportParams;
+		transportParams.port = params.netPort + i;
+		for (int j = 0; j < count; j++)
+		{
+			if (j != i)
+				transportParams.peers.push_back("127.0.0.1:" + ofToString(params.netPort + j));
+		}
+		if (!client->transport.Setup(transportParams))
+		{
+			delete client;
+			for (Client* c : clients)
+			{
+				delete c->shim;
+				delete c;
+			}
+			ofSetLogLevel(previousLogLevel);
+			return 1;
+		}
+		LatencyShimParams shimParams = params.netShimParams;
+		shimParams.seed = params.seed * 31 + i;
+		client->shim = new LatencyShim(&client->transport, shimParams);
+		RollbackParams rollbackParams;
+		rollbackParams.playerCount = count;
+		rollbackParams.localPlayer = i;
+		rollbackParams.maxRollbackTicks = params.netRollbackTicks;
+		rollbackParams.timeStep = client->simulation.GetTimeStep();
+		client->session.Setup(&client->simulation, client->shim, rollbackParams);
+		//The same on every client, before the first tick
+		DropDebris(client->simulation);
+		client->random.Seed(params.seed + i);
+		clients.push_back(client);
+	}
+
+	//Wall clock ticks like a window would get them; inputs change every few ticks so predictions miss. The
+	//first player starts the next round once one ends, so landers keep hitting the ground next to the debris.
+	typedef std::chrono::steady_clock Clock;
+	Clock::duration tickTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(clients[0]->simulation.GetTimeStep()));
+	Clock::time_point start = Clock::now();
+	Clock::time_point due = start;
+	while (Clock::now() - start < std::chrono::duration<float>(params.netSeconds))
+	{
+		for (Client* client : clients)
+		{
+			if (client->session.GetTick() % 12 == 0)
+			{
+				client->input.controls.thrustDelta = (client->random.Range(3) - 1) * .004f;
+				client->input.controls.rotationRate = (client->random.Range(3) - 1) * .05f;
+			}
+			Simulation::GameState state = client->simulation.GetGameState();
+			client->input.flags = client == clients[0] && (state == Simulation::Landed || state == Simulation::Crashed) ? NetStartRound : 0;
+			//Push the last client's lander off course behind its session's back, for the others to resync it
+			uint32_t tick = client->session.GetTick();
+			if (params.netDesyncTick > 0 && client == clients.back() && tick >= (uint32_t)params.netDesyncTick && tick < (uint32_t)params.netDesyncTick + 30)
+			{
+				b2Body* body = client->simulation.GetLander(count - 1)->GetBody();
+				body->SetLinearVelocity(body->GetLinearVelocity() + b2Vec2(.05f, 0.f));
+			}
+			client->session.AdvanceTick(client->input);
+		}
+		due += tickTime;
+		std::this_thread::sleep_until(due);
+	}
+
+	ofSetLogLevel(previousLogLevel);
+
+	//Every client has to agree on the newest tick they all know every input of
+	uint32_t commonTick = UINT32_MAX;
+	for (Client* client : clients)
+	{
+		commonTick = std::min(commonTick, client->session.GetLastSyncTick());
+	}
+	bool agree = commonTick > 0;
+	uint32_t firstHash = 0;
+	double frameMillis = clients[0]->simulation.GetTimeStep() * 1000.0;
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		Client* client = clients[i];
+		RollbackStats stats = client->session.GetStats();
+		LatencyShimStats shimStats = client->shim->GetStats();
+		uint32_t hash = 0;
+		if (!client->session.GetSyncHash(commonTick, hash))
+			agree = false;
+		else if (i == 0)
+			firstHash = hash;
+		else
+			agree &= hash == firstHash;
+		ofLogNotice("Headless") << "Client " << i << ": " << stats.ticks << " ticks, " << stats.rollbacks << " rollbacks, " << stats.resimulatedTicks << " resimulated ticks, "
+			<< stats.maxRollbackTicks << " deepest, " << stats.maxRollbackMillis << "ms longest of a " << frameMillis << "ms frame, "
+			<< stats.stalls << " stalls, " << shimStats.sent << " packets sent, " << shimStats.dropped << " dropped, "
+			<< stats.syncChecks << " sync checks, " << stats.desyncs << " desyncs, " << stats.resyncsSent << " resyncs sent, " << stats.resyncsApplied << " applied";
+		//A desync the first player's snapshot settled isn't a failure, peers still apart at the end are
+		if (stats.desyncs > 0)
+			ofLogWarning("Headless") << "Client " << i << " first desynced at tick " << stats.firstDesyncTick;
+		if (stats.maxRollbackMillis > frameMillis)
+			ofLogWarning("Headless") << "Client " << i << " took longer than a frame to roll back";
+	}
+	if (agree)
+		ofLogNotice("Headless") << "All clients agree at tick " << commonTick;
+	else
+	{
+		ofLogError("Headless") << "Clients disagree at tick " << commonTick;
+		result = 1;
+	}
+
+	for (Client* client : clients)
+	{
+		//The session and transport outlive the shim while the client is torn down
+		client->transport.Close();
+		delete client->shim;
+		delete client;
+	}
+	return result;
+}
+
+int HeadlessRunner::BroadcastLoopback()
+{
+	ofLogLevel previousLogLevel = ofGetLogLevel();
+	if (!params.verbose)
+		ofSetLogLevel(OF_LOG_WARNING);
+
+	Simulation simulation;
+	simulation.SetStreamingTerrain(params.streamingTerrain);
+	simulation.Setup(params.arenaWidth, params.arenaHeight);
+	simulation.SetTerrainSeed(params.seed);
+
+	StateServer server;
+	StateServerParams serverParams;
+	serverParams.port = params.statePort;
+	serverParams.maxClients = std::max(params.spectators, serverParams.maxClients);
+	if (!server.Start(serverParams))
+	{
+		ofSetLogLevel(previousLogLevel);
+		return 1;
+	}
+	std::vector<StateClient*> clients;
+	for (int i = 0; i < params.spectators; i++)
+	{
+		StateClientParams clientParams;
+		clientParams.server = "127.0.0.1:" + ofToString(params.statePort);
+		clientParams.port = params.statePort + 1 + i;
+		StateClient* client = new StateClient();
+		if (!client->Setup(clientParams))
+		{
+			delete client;
+			continue;
+		}
+		clients.push_back(client);
+	}
+
+	//A new level every few seconds and debris piling up, so seeds, list sizes and resting bodies all show up
+	typedef std::chrono::steady_clock Clock;
+	Clock::duration tickTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(simulation.GetTimeStep()));
+	Clock::duration publishTime(0), maxPublishTime(0);
+	FastRandom random(params.seed);
+	LanderControls controls;
+	Clock::time_point start = Clock::now();
+	Clock::time_point due = start;
+	uint64_t ticks = 0;
+	while (Clock::now() - start < std::chrono::duration<float>(params.netSeconds))
+	{
+		if (ticks % 300 == 0)
+			simulation.StartRound();
+		if (ticks % 30 == 0)
+		{
+			float x = random.Range(50.f, params.arenaWidth - 50.f);
+			if (random.Range(2) == 0)
+				simulation.SpawnCircle(x, 50.f, random.Range(4.f, 12.f));
+			else
+				simulation.SpawnBox(x, 50.f, random.Range(4.f, 16.f), random.Range(4.f, 16.f));
+		}
+		if (ticks % 12 == 0)
+		{
+			controls.thrustDelta = (random.Range(3) - 1) * .004f;
+			controls.rotationRate = (random.Range(3) - 1) * .05f;
+		}
+		simulation.Step(controls);
+		ticks++;
+
+		Clock::time_point publishStart = Clock::now();
+		server.Publish(simulation);
+		Clock::duration elapsed = Clock::now() - publishStart;
+		publishTime += elapsed;
+		maxPublishTime = std::max(maxPublishTime, elapsed);
+
+		for (StateClient* client : clients)
+		{
+			client->Update();
+		}
+		due += tickTime;
+		std::this_thread::sleep_until(due);
+	}
+
+	//The world stands still now, the last state has to reach everyone as it is
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	SimulationSnapshot snapshot;
+	simulation.Capture(snapshot);
+	NetWorldState expected;
+	expected.Quantize(snapshot, simulation.GetArenaWidth(), simulation.GetArenaHeight());
+	int matching = 0;
+	uint64_t bytesReceived = 0, fullStates = 0, missingBaselines = 0, incomplete = 0;
+	for (StateClient* client : clients)
+	{
+		client->Update();
+		const NetWorldState* state = client->GetState();
+		if (state && *state == expected)
+			matching++;
+		StateClientStats clientStats = client->GetStats();
+		bytesReceived += clientStats.bytesReceived;
+		fullStates += clientStats.fullStates;
+		missingBaselines += clientStats.missingBaseline;
+		incomplete += clientStats.incomplete;
+	}
+	StateServerStats stats = server.GetStats();
+	server.Stop();
+	for (StateClient* client : clients)
+	{
+		delete client;
+	}
+	ofSetLogLevel(previousLogLevel);
+
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	int count = std::max((int)clients.size(), 1);
+	ofLogNotice("Headless") << ticks << " ticks, " << stats.published << " states published, " << stats.replaced << " replaced before sending, "
+		<< std::chrono::duration<double, std::micro>(publishTime).count() / std::max(ticks, (uint64_t)1) << "us to publish on average, "
+		<< std::chrono::duration<double, std::micro>(maxPublishTime).count() << "us at most";
+	ofLogNotice("Headless") << stats.broadcasts << " broadcasts to " << clients.size() << " spectators, " << stats.encodes << " codings, " << stats.fullStates << " full states, "
+		<< stats.oversized << " too big to send";
+	ofLogNotice("Headless") << stats.bytesSent / count / seconds << " bytes/s sent per spectator, "
+		<< (stats.packetsSent > 0 ? stats.bytesSent / stats.packetsSent : 0) << " bytes per packet, "
+		<< bytesReceived / count / seconds << " bytes/s received, " << fullStates << " full states, " << missingBaselines << " missing baselines and " << incomplete << " incomplete states on the spectators";
+	if (matching != (int)clients.size())
+	{
+		ofLogError("Headless") << matching << " of " << clients.size() << " spectators ended on the server's state";
+		return 1;
+	}
+	ofLogNotice("Headless") << "Every spectator ended on the server's state";
+	return 0;
+}
+
+//Whether the body touches anything solid, landing triggers don't count
+static bool IsTouching(b2Body* body)
+{
+	for (b2ContactEdge* edge = body->GetContactList(); edge; edge = edge->next)
+	{
+		b2Contact* contact = edge->contact;
+		if (contact->IsTouching() && !contact->GetFixtureA()->IsSensor() && !contact->GetFixtureB()->IsSensor())
+			return true;
+	}
+	return false;
+}
+
+//Thrust and rotation change every few ticks, the same for a given stream on any simulator
+static void ScriptControls(FastRandom& random, uint64_t step, LanderControls& controls)
+{
+	if (step % 12 != 0)
+		return;
+	controls.thrustDelta = (random.Range(3) - 1) * .004f;
+	controls.rotationRate = (random.Range(3) - 1) * .05f;
+}
+
+int HeadlessRunner::BatchLanders()
+{
+	ofLogLevel previousLogLevel = ofGetLogLevel();
+	if (!params.verbose)
+		ofSetLogLevel(OF_LOG_WARNING);
+	if (params.streamingTerrain)
+		ofLogWarning("Headless") << "The batch simulator only knows single screen levels, ignoring --streaming";
+
+	//A real level and a real lander to take the height field and the rigid body data from
+	Simulation simulation;
+	simulation.Setup(params.arenaWidth, params.arenaHeight);
+	simulation.SetTerrainSeed(params.seed);
+	simulation.StartRound();
+	BatchLanderModel model = BatchLanderModel::FromSimulation(simulation);
+	TerrainHeightField terrain;
+	terrain.Setup(simulation.GetSurface()->GetTerrain(), params.arenaWidth, params.arenaHeight);
+	ofSetLogLevel(previousLogLevel);
+
+	int result = 0;
+	if (params.batchValidate > 0)
+		result = ValidateBatch(simulation, model, terrain);
+	if (params.batchLanders <= 0)
+		return result;
+	if (!params.verbose)
+		ofSetLogLevel(OF_LOG_WARNING);
+
+	typedef std::chrono::steady_clock Clock;
+	BatchLanderSim batch;
+	batch.Setup(model, &terrain, params.batchLanders);
+	batch.Reset(simulation.GetLanderParams());
+	std::vector<LanderControls> controls(params.batchLanders);
+	FastRandom random(params.seed);
+	Clock::duration stepTime(0);
+	uint64_t landerSteps = 0;
+	for (int t = 0; t < params.batchSteps && batch.GetFlyingCount() > 0; t++)
+	{
+		//Choosing controls stands in for the policy and isn't timed
+		for (LanderControls& c : controls)
+		{
+			ScriptControls(random, t, c);
+		}
+		landerSteps += batch.GetFlyingCount();
+		Clock::time_point start = Clock::now();
+		batch.Step(controls.data());
+		stepTime += Clock::now() - start;
+	}
+	int outcomes[5] = {};
+	for (int i = 0; i < batch.GetCount(); i++)
+	{
+		outcomes[(int)batch.GetOutcome(i)]++;
+	}
+
+	//The same rollouts through Box2D for comparison, one lander at a time
+	int referenceSteps = std::min(params.batchSteps, 600);
+	Clock::time_point start = Clock::now();
+	LanderControls referenceControls;
+	simulation.RetryRound();
+	for (int t = 0; t < referenceSteps; t++)
+	{
+		ScriptControls(random, t, referenceControls);
+		simulation.Step(referenceControls);
+	}
+	double referenceSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+	ofSetLogLevel(previousLogLevel);
+
+	double seconds = std::chrono::duration<double>(stepTime).count();
+	ofLogNotice("Headless") << params.batchLanders << " landers, " << landerSteps << " lander steps in " << seconds << "s: "
+		<< landerSteps / std::max(seconds, 1e-9) / 1e6 << "M lander steps/s, Box2D does " << referenceSteps / referenceSeconds / 1e6 << "M";
+	ofLogNotice("Headless") << outcomes[(int)BatchLanderOutcome::Landed] << " landed, " << outcomes[(int)BatchLanderOutcome::TouchedDown] << " touched down elsewhere, "
+		<< outcomes[(int)BatchLanderOutcome::Crashed] << " crashed, " << outcomes[(int)BatchLanderOutcome::OutOfBounds] << " out of bounds, "
+		<< outcomes[(int)BatchLanderOutcome::Flying] << " still flying";
+	return result;
+}
+
+int HeadlessRunner::ValidateBatch(Simulation& simulation, const BatchLanderModel& model, const TerrainHeightField& terrain)
+{
+	ofLogLevel previousLogLevel = ofGetLogLevel();
+	if (!params.verbose)
+		ofSetLogLevel(OF_LOG_WARNING);
+
+	//Box2D first, one rollout after the other on the same level, recording the lander's path until it touches something
+	int rollouts = params.batchValidate;
+	int steps = params.batchSteps;
+	std::vector<b2Vec2> positions(rollouts * steps);
+	std::vector<float> angles(rollouts * steps);
+	std::vector<int> recorded(rollouts, 0);	//Steps of free flight
+	for (int k = 0; k < rollouts; k++)
+	{
+		simulation.RetryRound();
+		FastRandom random(params.seed * 7919 + k);
+		LanderControls controls;
+		Lander* lander = simulation.GetLander();
+		for (int t = 0; t < steps; t++)
+		{
+			ScriptControls(random, t, controls);
+			simulation.Step(controls);
+			Simulation::GameState state = simulation.GetGameState();
+			if (lander->IsCrashed() || IsTouching(lander->GetBody()) || (state != Simulation::Flying && state != Simulation::Landing))
+				break;
+			positions[k * steps + t] = lander->GetBody()->GetPosition();
+			angles[k * steps + t] = lander->GetBody()->GetAngle();
+			recorded[k] = t + 1;
+		}
+	}
+
+	//Then all of them at once, compared tick by tick while both are in free flight; a contact found at the
+	//end of a step is solved by Box2D only in the next one, so that step still compares
+	BatchLanderSim batch;
+	batch.Setup(model, &terrain, rollouts);
+	batch.Reset(simulation.GetLanderParams());
+	std::vector<FastRandom> randoms;
+	for (int k = 0; k < rollouts; k++)
+	{
+		randoms.push_back(FastRandom(params.seed * 7919 + k));
+	}
+	std::vector<LanderControls> controls(rollouts);
+	std::vector<bool> compared(rollouts, true);
+	float maxError = 0.f, maxAngleError = 0.f;
+	uint64_t comparedSteps = 0;
+	int failed = 0;
+	for (int t = 0; t < steps; t++)
+	{
+		for (int k = 0; k < rollouts; k++)
+		{
+			ScriptControls(randoms[k], t, controls[k]);
+		}
+		batch.Step(controls.data());
+		for (int k = 0; k < rollouts; k++)
+		{
+			if (!compared[k])
+				continue;
+			if (t >= recorded[k])
+			{
+				compared[k] = false;
+				continue;
+			}
+			float error = (batch.GetPosition(k) - positions[k * steps + t]).Length() * OFX_BOX2D_SCALE;
+			float angleError = fabs(batch.GetAngle(k) - angles[k * steps + t]);
+			maxError = std::max(maxError, error);
+			maxAngleError = std::max(maxAngleError, angleError);
+			comparedSteps++;
+			if (error > params.batchTolerance)
+			{
+				ofLogError("Headless") << "Rollout " << k << " is " << error << " off Box2D at step " << t + 1;
+				failed++;
+				compared[k] = false;
+			}
+			else if (batch.GetOutcome(k) != BatchLanderOutcome::Flying)
+				compared[k] = false;
+		}
+	}
+	//Where the height field and Box2D's shapes disagree on the first touch, e.g. a peak between two corners
+	int contactsDiffer = 0;
+	for (int k = 0; k < rollouts; k++)
+	{
+		bool batchTouched = batch.GetOutcome(k) != BatchLanderOutcome::Flying;
+		bool box2dTouched = recorded[k] < steps;
+		if (batchTouched != box2dTouched || (batchTouched && std::abs((int)batch.GetEndStep(k) - (recorded[k] + 1)) > 1))
+			contactsDiffer++;
+	}
+	ofSetLogLevel(previousLogLevel);
+	ofLogNotice("Headless") << rollouts << " rollouts, " << comparedSteps << " steps compared, at most " << maxError << " screen units and "
+		<< maxAngleError << " rad off Box2D, " << failed << " beyond " << params.batchTolerance;
+	ofLogNotice("Headless") << contactsDiffer << " rollouts touched down more than a step apart";
+	return failed > 0 ? 1 : 0;
+}
+
+int HeadlessRunner::CheckCrashes()
+{
+	ofLogLevel previousLogLevel = ofGetLogLevel();
+	if (!params.verbose)
+		ofSetLogLevel(OF_LOG_WARNING);
+
+	//Two players side by side; the first one is thrown at the ground upside down, the second one only falls
+	Simulation simulation;
+	simulation.SetPlayerCount(2);
+	simulation.SetStreamingTerrain(params.streamingTerrain);
+	simulation.Setup(params.arenaWidth, params.arenaHeight);
+	simulation.SetTerrainSeed(params.seed);
+	simulation.StartRound();
+	b2Body* thrown = simulation.GetLander(0)->GetBody();
+	thrown->SetTransform(thrown->GetPosition(), b2_pi);
+	thrown->SetLinearVelocity(b2Vec2(0.f, 30.f));
+
+	LanderControls controls[2];
+	int crashStep = -1;
+	for (int step = 0; step < params.maxStepsPerRound && crashStep < 0; step++)
+	{
+		simulation.Step(controls, 2);
+		if (simulation.GetLander(0)->IsCrashed())
+			crashStep = step;
+	}
+	//Long enough for anything the crash set off to show up, too short for the second lander to land
+	for (int step = 0; step < 10; step++)
+	{
+		simulation.Step(controls, 2);
+	}
+
+	ofSetLogLevel(previousLogLevel);
+
+	if (crashStep < 0)
+	{
+		ofLogError("Headless") << "The first lander never crashed";
+		return 1;
+	}
+	if (simulation.GetLander(1)->IsCrashed() || simulation.GetGameState() == Simulation::GameState::Crashed)
+	{
+		ofLogError("Headless") << "The crash of the first lander at step " << crashStep << " took the second one down as well";
+		return 1;
+	}
+	ofLogNotice("Headless") << "The first lander crashed at step " << crashStep << ", the second one flies on";
+	return 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "BatchRunner.h"
+#include "DacEmulator.h"
+#include "IldaPlayer.h"
+#include "LanderAssets.h"
+#include "InputReplayer.h"
+#include "SceneRecorder.h"
+#include "LatencyShim.h"
+#include "BatchLanderSim.h"
+
+struct HeadlessRunParams {
+	int rounds = 1000;
+	int maxStepsPerRound = 60 * 60;	//A minute of simulated time
+	int settleSteps = 60;	//A round ends when the lander rests this long outside a landing spot
+	uint32_t seed = 1;	//Terrain seed of the first round, following rounds count up
+	int threads = 1;	//0 uses every hardware thread
+	int arenaWidth = 1024;
+	int arenaHeight = 768;
+	bool streamingTerrain = false;
+	bool verbose = false;
+	bool runDacEmulator = false;	//Run as a laser DAC emulator instead of simulating
+	DacEmulatorParams dacEmulatorParams;
+	std::string ildaPlayPath;	//Replay this ILDA file instead of simulating
+	IldaPlayerParams ildaPlayerParams;
+	std::string dacAddress;	//Replay to a network DAC at host[:port]
+	std::string ildaRecordPath;	//Replay into another ILDA file, the output is counted only when neither is set
+	int renderFrames = 0;	//Time recording and drawing this many frames of one round instead of simulating rounds
+	bool bakeAssets = false;	//Bake the lander svgs in res/ instead of simulating
+	LanderBakeParams bakeParams;
+	std::string replayPath;	//Replay this input log instead of simulating rounds
+	InputReplayParams replayParams;
+	int snapshotRestores = 0;	//Time capturing and restoring this many snapshots of one round instead of simulating rounds
+	int netClients = 0;	//Play this many rollback clients against each other over loopback UDP instead of simulating rounds
+	int netPort = 47800;	//Port of the first client, the others count up
+	int netRollbackTicks = 8;
+	float netSeconds = 20.f;	//Long enough for landers and debris to rest on the ground, where resimulation drifts
+	LatencyShimParams netShimParams;
+	int netDesyncTick = 0;	//Push the last client's lander off course from this tick on, to check the others resync it
+	int spectators = 0;	//Broadcast a simulation to this many spectators over loopback UDP instead of simulating rounds
+	int statePort = 47900;	//Of the server, spectators receive on the ports after it
+	int batchLanders = 0;	//Time stepping this many landers in a BatchLanderSim instead of simulating rounds
+	int batchSteps = 600;	//Per lander, for timing and validating
+	int batchValidate = 0;	//Compare this many batch rollouts with Box2D ones instead of simulating rounds
+	float batchTolerance = .5f;	//Screen units the batch may drift from Box2D before validation fails
+	bool crashCheck = false;	//Crash one of two landers and check the other one flies on instead of simulating rounds
+};
+
+//Drives simulations without a window, GL context or frame limiter and reports the step rate
+class HeadlessRunner
+{
+	HeadlessRunParams params;
+
+public:
+
+	int Run(int argc, char** argv);
+	void ParseArguments(int argc, char** argv);
+	int PlayIlda();
+	int BenchRender();
+	int Replay();
+	int BenchSnapshots();
+	int NetLoopback();
+	int BroadcastLoopback();
+	int BatchLanders();
+	int ValidateBatch(Simulation& simulation, const BatchLanderModel& model, const TerrainHeightField& terrain);
+	int CheckCrashes();
+};
@@ -0,0 +1,62 @@
+#include "Hud.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+void Hud::Setup(ofVec2f origin, float size, const ofColor& color)
+{
+	this->origin = origin;
+	this->size = size;
+	this->color = color;
+}
+
+int Hud::AddField(const char* label, int precision)
+{
+	HudField field;
+	field.label = label;
+	field.precision = precision;
+	field.position = origin + ofVec2f(0.f, fields.size() * StrokeFont::GetLineHeight(size));
+	//Room for the longest line, laying out never allocates afterwards
+	field.points.reserve(HudField::Capacity * StrokeFont::MaxPointsPerGlyph);
+	field.strokes.reserve(HudField::Capacity * StrokeFont::MaxStrokesPerGlyph);
+	fields.push_back(field);
+	return fields.size() - 1;
+}
+
+void Hud::Set(int field, float value)
+{
+	HudField& line = fields[field];
+	int64_t shown = llround(value * pow(10.0, line.precision));
+	if (shown == line.shown)
+		return;
+	line.shown = shown;
+	line.dirty = true;
+}
+
+void Hud::Record(DrawList& list)
+{
+	const StrokeFont& font = StrokeFont::Get();
+	for (HudField& field : fields)
+	{
+		if (field.dirty)
+		{
+			int length = snprintf(field.text, HudField::Capacity, "%s %.*f", field.label, field.precision, field.shown / pow(10.0, field.precision));
+			field.length = std::min(std::max(length, 0), HudField::Capacity - 1);
+			field.points.clear();
+			field.strokes.clear();
+			font.Layout(field.text, field.length, field.position, size, field.points, field.strokes);
+			field.dirty = false;
+			formatCount++;
+		}
+		for (const StrokeSpan& stroke : field.strokes)
+		{
+			list.AddPolygon(&field.points[stroke.first], stroke.count, color, 0, DrawScreenSpace);
+		}
+	}
+}
+
+uint64_t Hud::GetFormatCount()
+{
+	return formatCount;
+}
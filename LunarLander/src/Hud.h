@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include "DrawList.h"
+#include "StrokeFont.h"
+
+//One line of the HUD: a fixed label and a number
+struct HudField {
+	static const int Capacity = 32;	//Characters, longer lines are cut
+
+	const char* label;
+	int precision;	//Decimals shown
+	int64_t shown = 0;	//The value as it is displayed, scaled by 10^precision
+	bool dirty = true;
+	char text[Capacity];
+	int length = 0;
+	ofVec2f position;
+	//Strokes of the text, laid out when it changes
+	std::vector<ofVec2f> points;
+	std::vector<StrokeSpan> strokes;
+};
+
+//Text overlay with fixed-capacity lines that are only formatted and laid out again when the value they
+//show changes, so a steady frame costs a few comparisons and no allocation. It is recorded as stroke
+//text in screen space, raster and vector outputs draw it alike.
+class Hud
+{
+	std::vector<HudField> fields;
+	ofVec2f origin;
+	float size = 10.f;
+	ofColor color = ofColor::white;
+	uint64_t formatCount = 0;
+
+public:
+
+	//size is the height of a capital
+	void Setup(ofVec2f origin, float size, const ofColor& color);
+	//Adds a line below the last one, the label has to outlive the HUD; returns the field to Set
+	int AddField(const char* label, int precision);
+	void Set(int field, float value);
+	void Record(DrawList& list);
+
+	//How often a field was formatted, for checking the dirty flags work
+	uint64_t GetFormatCount();
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+//Header in front of every frame of an ILDA file, a header with no records ends the file
+struct IldaHeader {
+	uint8_t format = 5;
+	char name[9] = {};	//Frame name, 8 characters without terminator in the file
+	char company[9] = {};
+	uint16_t recordCount = 0;
+	uint16_t frameNumber = 0;
+	uint16_t totalFrames = 0;	//0 when the writer didn't know the length up front
+	uint8_t projector = 0;
+};
+
+//ILDA image data transfer format, big endian throughout. Records of the true color formats are
+//x, y (format 4 adds z) as int16, a status byte and b, g, r; the older indexed formats 0 and 1 carry
+//a palette index instead of a color.
+class IldaFormat
+{
+	static void Write(uint8_t*& out, uint16_t value)
+	{
+		*out++ = (uint8_t)(value >> 8);
+		*out++ = (uint8_t)value;
+	}
+
+	static uint16_t Read(const uint8_t* in)
+	{
+		return (uint16_t)(in[0] << 8 | in[1]);
+	}
+
+public:
+
+	static const int HeaderSize = 32;
+	static const int FormatOffset = 7;
+	static const uint8_t LastPoint = 0x80;
+	static const uint8_t Blanked = 0x40;
+
+	//Record size of a format, 0 for formats without points
+	static int RecordSize(uint8_t format)
+	{
+		switch (format)
+		{
+		case 0: return 8;
+		case 1: return 6;
+		case 4: return 10;
+		case 5: return 8;
+		default: return 0;
+		}
+	}
+
+	static void EncodeHeader(uint8_t* out, const IldaHeader& header)
+	{
+		memcpy(out, "ILDA", 4);
+		out[4] = out[5] = out[6] = 0;
+		out[FormatOffset] = header.format;
+		strncpy((char*)out + 8, header.name, 8);
+		strncpy((char*)out + 16, header.company, 8);
+		out += 24;
+		Write(out, header.recordCount);
+		Write(out, header.frameNumber);
+		Write(out, header.totalFrames);
+		*out++ = header.projector;
+		*out++ = 0;
+	}
+
+	static bool DecodeHeader(const uint8_t* in, IldaHeader& header)
+	{
+		if (memcmp(in, "ILDA", 4))
+			return false;
+		header.format = in[FormatOffset];
+		memcpy(header.name, in + 8, 8);
+		header.name[8] = 0;
+		memcpy(header.company, in + 16, 8);
+		header.company[8] = 0;
+		header.recordCount = Read(in + 24);
+		header.frameNumber = Read(in + 26);
+		header.totalFrames = Read(in + 28);
+		header.projector = in[30];
+		return true;
+	}
+
+	//Format 5 record
+	static void EncodePoint(uint8_t* out, int16_t x, int16_t y, uint8_t status, uint8_t r, uint8_t g, uint8_t b)
+	{
+		Write(out, (uint16_t)x);
+		Write(out, (uint16_t)y);
+		*out++ = status;
+		*out++ = b;
+		*out++ = g;
+		*out++ = r;
+	}
+
+	//Any format with points; indexed colors come out white, there is no palette to look them up in
+	static void DecodePoint(const uint8_t* in, uint8_t format, int16_t& x, int16_t& y, uint8_t& r, uint8_t& g, uint8_t& b)
+	{
+		x = (int16_t)Read(in);
+		y = (int16_t)Read(in + 2);
+		const uint8_t* rest = in + (format == 0 || format == 4 ? 6 : 4);	//Skip z
+		bool blanked = (rest[0] & Blanked) != 0;
+		if (format == 4 || format == 5)
+		{
+			b = rest[1];
+			g = rest[2];
+			r = rest[3];
+		}
+		else
+			r = g = b = 255;
+		if (blanked)
+			r = g = b = 0;
+	}
+};
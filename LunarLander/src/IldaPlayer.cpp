@@ -0,0 +1,138 @@
+#include "IldaPlayer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+bool IldaPlayer::Open(const std::string& path, const IldaPlayerParams& params)
+{
+	this->params = params;
+	frames.clear();
+	if (!file.Open(path))
+		return false;
+
+	//Index the frames once, playback then jumps straight to the records
+	const uint8_t* data = file.GetData();
+	size_t size = file.GetSize();
+	size_t offset = 0;
+	int maxCount = 0;
+	IldaHeader header;
+	while (offset + IldaFormat::HeaderSize <= size)
+	{
+		if (!IldaFormat::DecodeHeader(data + offset, header))
+		{
+			ofLogError("IldaPlayer") << "No ILDA header at byte " << offset << " of " << path;
+			break;
+		}
+		offset += IldaFormat::HeaderSize;
+		if (header.recordCount == 0)
+			break;
+
+		if (header.format == 2)
+		{
+			//A palette, three bytes per color; indexed frames are played white anyway
+			offset += header.recordCount * 3;
+			continue;
+		}
+		int recordSize = IldaFormat::RecordSize(header.format);
+		if (recordSize == 0)
+		{
+			ofLogError("IldaPlayer") << "Unsupported ILDA format " << (int)header.format << " in " << path;
+			break;
+		}
+		if (offset + header.recordCount * recordSize > size)
+		{
+			ofLogWarning("IldaPlayer") << path << " ends in the middle of a frame";
+			break;
+		}
+
+		Frame frame;
+		frame.offset = offset;
+		frame.format = header.format;
+		frame.count = header.recordCount;
+		//IldaRecorder keeps the point rate in the frame name
+		frame.pointsPerSecond = header.name[0] == 'p' ? atoi(header.name + 1) : 0;
+		if (frame.pointsPerSecond <= 0)
+			frame.pointsPerSecond = params.defaultPointsPerSecond;
+		frames.push_back(frame);
+		maxCount = std::max(maxCount, frame.count);
+		offset += header.recordCount * recordSize;
+	}
+	points.resize(maxCount);
+	ofLogNotice("IldaPlayer") << frames.size() << " frames in " << path;
+	return !frames.empty();
+}
+
+int IldaPlayer::GetFrameCount()
+{
+	return frames.size();
+}
+
+IldaPlayerStats IldaPlayer::Play(LaserOutput& output)
+{
+	IldaPlayerStats stats;
+	if (frames.empty())
+		return stats;
+
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start = Clock::now();
+	Clock::time_point due = start;	//When the next frame should go out
+	size_t idx = 0;
+	while (true)
+	{
+		if (idx == frames.size())
+		{
+			if (!params.loop)
+				break;
+			idx = 0;
+		}
+		if (params.loop && params.seconds > 0.f && Clock::now() - start >= std::chrono::duration<float>(params.seconds))
+			break;
+
+		const Frame& frame = frames[idx++];
+		int count = DecodeFrame(frame);
+
+		//Wait for the clock first, then for the output; a slow output delays playback rather than losing
+		//frames, only one that stopped taking them (a DAC that went away) makes us drop
+		if (params.speed > 0.f)
+			std::this_thread::sleep_until(due);
+		Clock::time_point waitStart = Clock::now();
+		bool ready;
+		while (!(ready = output.IsReady()) && Clock::now() - waitStart < std::chrono::seconds(1))
+		{
+			std::this_thread::yield();
+		}
+
+		int pointsPerSecond = params.speed > 0.f ? std::max(1, (int)(frame.pointsPerSecond * params.speed)) : frame.pointsPerSecond;
+		if (ready && output.SubmitFrame(points.data(), count, pointsPerSecond))
+			stats.points += count;
+		else
+			stats.framesDropped++;
+		stats.frames++;
+
+		//Deadlines accumulate from the start, so sleep jitter doesn't add up over a long file
+		if (params.speed > 0.f)
+			due += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(count / (double)pointsPerSecond));
+	}
+	stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	return stats;
+}
+
+int IldaPlayer::DecodeFrame(const Frame& frame)
+{
+	LaserScreenMapping mapping;
+	mapping.width = params.screenWidth;
+	mapping.height = params.screenHeight;
+	int recordSize = IldaFormat::RecordSize(frame.format);
+	const uint8_t* in = file.GetData() + frame.offset;
+	for (int i = 0; i < frame.count; i++)
+	{
+		int16_t x, y;
+		LaserPoint& p = points[i];
+		IldaFormat::DecodePoint(in, frame.format, x, y, p.r, p.g, p.b);
+		mapping.ToScreen(x, y, p);
+		in += recordSize;
+	}
+	return frame.count;
+}
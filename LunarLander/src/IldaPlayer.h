@@ -0,0 +1,46 @@
+#pragma once
+
+#include "LaserOutput.h"
+#include "IldaFormat.h"
+#include "MappedFile.h"
+
+struct IldaPlayerParams {
+	float speed = 1.f;	//Playback rate relative to the recorded point rate, 0 plays as fast as the output takes frames
+	bool loop = false;
+	float seconds = 0.f;	//Stop after this long when looping, 0 plays until the file ends
+	int screenWidth = 1024;	//Screen area the ILDA range is mapped back onto
+	int screenHeight = 768;
+	int defaultPointsPerSecond = 30000;	//For frames not recorded by IldaRecorder
+};
+
+struct IldaPlayerStats {
+	uint64_t frames = 0;
+	uint64_t framesDropped = 0;	//Refused by the output
+	uint64_t points = 0;
+	double seconds = 0.0;
+};
+
+//Replays an ILDA file to any LaserOutput. The file is memory mapped and indexed once on Open, playback
+//decodes each frame into one reused buffer and paces submission by the frames' point rates.
+class IldaPlayer
+{
+	struct Frame {
+		size_t offset;	//Of the first record
+		uint8_t format;
+		int count;
+		int pointsPerSecond;
+	};
+
+	MappedFile file;
+	std::vector<Frame> frames;
+	std::vector<LaserPoint> points;
+	IldaPlayerParams params;
+
+	int DecodeFrame(const Frame& frame);
+
+public:
+
+	bool Open(const std::string& path, const IldaPlayerParams& params);
+	int GetFrameCount();
+	IldaPlayerStats Play(LaserOutput& output);
+};
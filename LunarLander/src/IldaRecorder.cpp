@@ -0,0 +1,155 @@
+#include "IldaRecorder.h"
+
+#include <algorithm>
+
+IldaRecorder::IldaRecorder() : points(1), frames(1)
+{
+}
+
+IldaRecorder::~IldaRecorder()
+{
+	Close();
+}
+
+bool IldaRecorder::Open(const IldaRecorderParams& params)
+{
+	Close();
+	this->params = params;
+	file = fopen(params.path.c_str(), "wb");
+	if (!file)
+	{
+		ofLogError("IldaRecorder") << "Couldn't open " << params.path << " for writing";
+		return false;
+	}
+	//One big buffer, the disk sees a few large writes instead of one per frame
+	setvbuf(file, nullptr, _IOFBF, params.writeBufferBytes);
+
+	points.Reset(params.ringCapacity);
+	//Even frames of a single point can't outrun the frame ring
+	frames.Reset(params.ringCapacity);
+	frame.resize(points.Capacity());
+	encoded.reserve(IldaFormat::HeaderSize + 1024 * IldaFormat::RecordSize(5));
+	framesWritten = 0;
+	framesDropped = 0;
+	bytesWritten = 0;
+	running = true;
+	thread = std::thread(&IldaRecorder::Writer, this);
+	return true;
+}
+
+void IldaRecorder::Close()
+{
+	if (!thread.joinable())
+		return;
+	running = false;
+	thread.join();
+	ofLogNotice("IldaRecorder") << framesWritten << " frames, " << bytesWritten << " bytes written to " << params.path << ", " << framesDropped << " dropped";
+}
+
+IldaRecorderStats IldaRecorder::GetStats()
+{
+	IldaRecorderStats stats;
+	stats.framesWritten = framesWritten;
+	stats.framesDropped = framesDropped;
+	stats.bytesWritten = bytesWritten;
+	return stats;
+}
+
+bool IldaRecorder::IsReady()
+{
+	//Always take the frame when there is room, a recording should have every one of them
+	return running && points.Size() < points.Capacity();
+}
+
+bool IldaRecorder::SubmitFrame(const LaserPoint* points, int count, int pointsPerSecond)
+{
+	//The writer only ever drains the rings, so their sizes seen from here can only overstate the fill
+	if (!running || count > 0xFFFF || this->points.Capacity() - this->points.Size() < (size_t)count || frames.Size() >= frames.Capacity())
+	{
+		framesDropped++;
+		return false;
+	}
+	FrameInfo info = { count, pointsPerSecond };
+	this->points.Push(points, count);
+	frames.Push(&info, 1);
+	return true;
+}
+
+void IldaRecorder::Writer()
+{
+	FrameInfo info;
+	while (true)
+	{
+		if (frames.Pop(&info, 1))
+		{
+			WriteFrame(info);
+			continue;
+		}
+		//Drain what was submitted before Close
+		if (!running && frames.Size() == 0)
+			break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	Finish();
+}
+
+void IldaRecorder::WriteFrame(const FrameInfo& info)
+{
+	points.Pop(frame.data(), info.count);
+	if (framesWritten >= MaxFrames)
+	{
+		framesDropped++;
+		return;
+	}
+
+	IldaHeader header;
+	header.format = 5;
+	snprintf(header.name, sizeof(header.name), "p%d", info.pointsPerSecond);
+	strncpy(header.company, "LUNAR", sizeof(header.company) - 1);
+	header.recordCount = (uint16_t)info.count;
+	header.frameNumber = (uint16_t)framesWritten;
+
+	int recordSize = IldaFormat::RecordSize(header.format);
+	encoded.resize(IldaFormat::HeaderSize + info.count * recordSize);
+	IldaFormat::EncodeHeader(encoded.data(), header);
+
+	LaserScreenMapping mapping;
+	mapping.width = params.screenWidth;
+	mapping.height = params.screenHeight;
+	uint8_t* out = encoded.data() + IldaFormat::HeaderSize;
+	for (int i = 0; i < info.count; i++)
+	{
+		const LaserPoint& p = frame[i];
+		int16_t x, y;
+		mapping.ToDevice(p, x, y);
+		uint8_t status = (p.r | p.g | p.b) ? 0 : IldaFormat::Blanked;
+		if (i == info.count - 1)
+			status |= IldaFormat::LastPoint;
+		IldaFormat::EncodePoint(out, x, y, status, p.r, p.g, p.b);
+		out += recordSize;
+	}
+
+	if (fwrite(encoded.data(), 1, encoded.size(), file) != encoded.size())
+	{
+		ofLogError("IldaRecorder") << "Write to " << params.path << " failed";
+		framesDropped++;
+		return;
+	}
+	bytesWritten += encoded.size();
+	if (++framesWritten == MaxFrames)
+		ofLogWarning("IldaRecorder") << params.path << " holds " << (int)MaxFrames << " frames, the most ILDA can number; the rest are dropped";
+}
+
+void IldaRecorder::Finish()
+{
+	//A header without records ends the file
+	IldaHeader end;
+	end.format = 5;
+	strncpy(end.company, "LUNAR", sizeof(end.company) - 1);
+	uint8_t buffer[IldaFormat::HeaderSize];
+	IldaFormat::EncodeHeader(buffer, end);
+	fwrite(buffer, 1, sizeof(buffer), file);
+	bytesWritten += sizeof(buffer);
+	fclose(file);
+	file = nullptr;
+}
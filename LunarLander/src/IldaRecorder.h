@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include "LaserOutput.h"
+#include "IldaFormat.h"
+#include "SpscRing.h"
+
+struct IldaRecorderParams {
+	std::string path;
+	int screenWidth = 1024;	//Screen area mapped onto the full ILDA range
+	int screenHeight = 768;
+	int ringCapacity = 65536;	//Points queued between the game thread and the writer
+	int writeBufferBytes = 1 << 20;	//stdio buffer of the file, the writer never flushes on its own
+};
+
+struct IldaRecorderStats {
+	uint64_t framesWritten = 0;
+	uint64_t framesDropped = 0;	//No room in the ring, the writer fell behind the disk
+	uint64_t bytesWritten = 0;
+};
+
+//Records every submitted frame to an ILDA file (format 5, true color). The game thread only pushes
+//into lock-free rings; a writer thread encodes the frames and streams them through one buffered file.
+//ILDA has no notion of time, so the point rate of every frame is kept in its name ("p30000").
+//The file is written front to back only: the total frame count of every header is 0, players have to
+//read up to the end header, and frame numbers being 16 bit a recording stops at MaxFrames.
+class IldaRecorder : public LaserOutput
+{
+	struct FrameInfo {
+		int count;
+		int pointsPerSecond;
+	};
+
+	IldaRecorderParams params;
+	SpscRing<LaserPoint> points;
+	SpscRing<FrameInfo> frames;	//Pushed after the frame's points, so a popped frame is always complete
+	std::thread thread;
+	std::atomic<bool> running{ false };
+
+	std::atomic<uint64_t> framesWritten{ 0 };
+	std::atomic<uint64_t> framesDropped{ 0 };
+	std::atomic<uint64_t> bytesWritten{ 0 };
+
+	//Only touched by the writer thread
+	FILE* file = nullptr;
+	std::vector<LaserPoint> frame;
+	std::vector<uint8_t> encoded;
+
+	void Writer();
+	void WriteFrame(const FrameInfo& info);
+	void Finish();
+
+public:
+
+	static const uint64_t MaxFrames = 0xFFFF;	//About 36 minutes at 30 frames per second
+
+	IldaRecorder();
+	~IldaRecorder();
+
+	bool Open(const IldaRecorderParams& params);
+	//Writes the queued frames and closes the file
+	void Close();
+	IldaRecorderStats GetStats();
+
+	bool IsReady() override;
+	bool SubmitFrame(const LaserPoint* points, int count, int pointsPerSecond) override;
+};
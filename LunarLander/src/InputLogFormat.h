@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+//Simulation calls that change the world besides the per-tick controls
+enum class InputEvent : uint8_t {
+	StartRound,
+	ResetRound,
+	AbortRound,
+	SpawnCircle,	//x, y, radius
+	SpawnBox,	//x, y, width, height
+	SetArenaSize,	//width, height
+	RetryRound,
+};
+
+//Everything a replay needs to rebuild the world the recording started from
+struct InputLogHeader {
+	uint32_t magic;
+	uint32_t version;
+	int32_t arenaWidth;
+	int32_t arenaHeight;
+	uint32_t streamingTerrain;
+	float timeStep;
+	uint32_t terrainSeed;	//Seed of the first round
+	float angularDamping;	//LanderParams
+	float linearDamping;
+	float density;
+	float friction;
+	float bounce;
+	float startingPosX;
+	float startingPosY;
+	float startVelocity;
+	float crashImpulse;
+};
+
+//Input log of a play session, native endianness: the header, then a stream of records that each start
+//with a tag byte. Controls only appear when they change, so a tick of steady input costs five bytes.
+//  Tick      uint32 hash of the world after the step, the step used the last controls
+//  Controls  float thrustDelta, float rotationRate
+//  Event     uint8 InputEvent, float args[4], applied before the next tick
+class InputLogFormat
+{
+public:
+
+	static const uint32_t Magic = 0x49444E4C;	//"LNDI"
+	static const uint32_t Version = 1;
+
+	static const uint8_t TickTag = 'T';
+	static const uint8_t ControlsTag = 'C';
+	static const uint8_t EventTag = 'E';
+
+	static const int TickSize = 1 + 4;
+	static const int ControlsSize = 1 + 2 * 4;
+	static const int EventSize = 1 + 1 + 4 * 4;
+};
@@ -0,0 +1,102 @@
+#include "InputRecorder.h"
+
+#include <cstring>
+
+InputRecorder::~InputRecorder()
+{
+	Close();
+}
+
+bool InputRecorder::Open(const std::string& path, Simulation& simulation)
+{
+	Close();
+	file = fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		ofLogError("InputRecorder") << "Couldn't open " << path << " for writing";
+		return false;
+	}
+	setvbuf(file, nullptr, _IOFBF, 1 << 16);
+	this->path = path;
+	hasControls = false;
+	ticks = 0;
+
+	InputLogHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = InputLogFormat::Magic;
+	header.version = InputLogFormat::Version;
+	header.arenaWidth = simulation.GetArenaWidth();
+	header.arenaHeight = simulation.GetArenaHeight();
+	header.streamingTerrain = simulation.GetChunkedSurface() ? 1 : 0;
+	header.timeStep = simulation.GetTimeStep();
+	header.terrainSeed = simulation.GetNextTerrainSeed();
+	LanderParams params = simulation.GetLanderParams();
+	header.angularDamping = params.angularDamping;
+	header.linearDamping = params.linearDamping;
+	header.density = params.density;
+	header.friction = params.friction;
+	header.bounce = params.bounce;
+	header.startingPosX = params.startingPos.x;
+	header.startingPosY = params.startingPos.y;
+	header.startVelocity = params.startVelocity;
+	header.crashImpulse = params.crashImpulse;
+	Write(&header, sizeof(header));
+	return true;
+}
+
+void InputRecorder::Close()
+{
+	if (!file)
+		return;
+	fclose(file);
+	file = nullptr;
+	ofLogNotice("InputRecorder") << ticks << " ticks recorded to " << path;
+}
+
+bool InputRecorder::IsOpen()
+{
+	return file != nullptr;
+}
+
+void InputRecorder::AddTick(const LanderControls& controls, uint32_t hash)
+{
+	if (!file)
+		return;
+	if (!hasControls || controls.thrustDelta != this->controls.thrustDelta || controls.rotationRate != this->controls.rotationRate)
+	{
+		uint8_t record[InputLogFormat::ControlsSize];
+		record[0] = InputLogFormat::ControlsTag;
+		memcpy(record + 1, &controls.thrustDelta, 4);
+		memcpy(record + 5, &controls.rotationRate, 4);
+		Write(record, sizeof(record));
+		this->controls = controls;
+		hasControls = true;
+	}
+	uint8_t record[InputLogFormat::TickSize];
+	record[0] = InputLogFormat::TickTag;
+	memcpy(record + 1, &hash, 4);
+	Write(record, sizeof(record));
+	ticks++;
+}
+
+void InputRecorder::AddEvent(InputEvent event, float arg0, float arg1, float arg2, float arg3)
+{
+	if (!file)
+		return;
+	uint8_t record[InputLogFormat::EventSize];
+	record[0] = InputLogFormat::EventTag;
+	record[1] = (uint8_t)event;
+	float args[4] = { arg0, arg1, arg2, arg3 };
+	memcpy(record + 2, args, sizeof(args));
+	Write(record, sizeof(record));
+}
+
+void InputRecorder::Write(const void* data, size_t size)
+{
+	if (fwrite(data, 1, size, file) != size)
+	{
+		ofLogError("InputRecorder") << "Write to " << path << " failed, recording stopped";
+		fclose(file);
+		file = nullptr;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include "InputLogFormat.h"
+#include "Simulation.h"
+
+//Writes every tick of a simulation to an input log (see InputLogFormat) for InputReplayer to play back.
+//The simulation calls it from Step and from every call that changes the world, on the simulation thread;
+//writes go through a stdio buffer, a tick is a few bytes.
+class InputRecorder
+{
+	FILE* file = nullptr;
+	std::string path;
+	LanderControls controls;	//Last written, a tick with the same controls writes none
+	bool hasControls = false;
+	uint64_t ticks = 0;
+
+	void Write(const void* data, size_t size);
+
+public:
+
+	~InputRecorder();
+
+	//Starts the log from the current state of the simulation, which has to be freshly set up
+	bool Open(const std::string& path, Simulation& simulation);
+	void Close();
+	bool IsOpen();
+
+	void AddTick(const LanderControls& controls, uint32_t hash);
+	void AddEvent(InputEvent event, float arg0 = 0.f, float arg1 = 0.f, float arg2 = 0.f, float arg3 = 0.f);
+};
@@ -0,0 +1,126 @@
+#include "InputReplayer.h"
+
+#include <chrono>
+#include <cstring>
+
+bool InputReplayer::Open(const std::string& path)
+{
+	if (!file.Open(path))
+		return false;
+	if (file.GetSize() < sizeof(header))
+	{
+		ofLogError("InputReplayer") << path << " is too short for an input log";
+		return false;
+	}
+	memcpy(&header, file.GetData(), sizeof(header));
+	if (header.magic != InputLogFormat::Magic || header.version != InputLogFormat::Version)
+	{
+		ofLogError("InputReplayer") << path << " is no input log of this version";
+		return false;
+	}
+	return true;
+}
+
+const InputLogHeader& InputReplayer::GetHeader()
+{
+	return header;
+}
+
+InputReplayStats InputReplayer::Run(const InputReplayParams& params)
+{
+	InputReplayStats stats;
+	Simulation simulation;
+	simulation.SetStreamingTerrain(header.streamingTerrain != 0);
+	simulation.SetTerrainPrefetch(params.terrainPrefetch);
+	simulation.Setup(header.arenaWidth, header.arenaHeight);
+	simulation.SetTimeStep(header.timeStep);
+	simulation.SetTerrainSeed(header.terrainSeed);
+	LanderParams landerParams;
+	landerParams.angularDamping = header.angularDamping;
+	landerParams.linearDamping = header.linearDamping;
+	landerParams.density = header.density;
+	landerParams.friction = header.friction;
+	landerParams.bounce = header.bounce;
+	landerParams.startingPos = ofVec2f(header.startingPosX, header.startingPosY);
+	landerParams.startVelocity = header.startVelocity;
+	landerParams.crashImpulse = header.crashImpulse;
+	simulation.SetLanderParams(landerParams);
+
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start = Clock::now();
+	const uint8_t* in = file.GetData() + sizeof(header);
+	const uint8_t* end = file.GetData() + file.GetSize();
+	LanderControls controls;
+	while (in < end)
+	{
+		uint8_t tag = *in;
+		if (tag == InputLogFormat::TickTag && end - in >= InputLogFormat::TickSize)
+		{
+			uint32_t recorded;
+			memcpy(&recorded, in + 1, 4);
+			in += InputLogFormat::TickSize;
+			simulation.Step(controls);
+			stats.finalHash = simulation.HashState();
+			if (stats.finalHash != recorded)
+			{
+				if (stats.mismatches++ == 0)
+					stats.firstMismatch = stats.ticks;
+				if (params.stopOnMismatch)
+				{
+					stats.ticks++;
+					break;
+				}
+			}
+			stats.ticks++;
+		}
+		else if (tag == InputLogFormat::ControlsTag && end - in >= InputLogFormat::ControlsSize)
+		{
+			memcpy(&controls.thrustDelta, in + 1, 4);
+			memcpy(&controls.rotationRate, in + 5, 4);
+			in += InputLogFormat::ControlsSize;
+		}
+		else if (tag == InputLogFormat::EventTag && end - in >= InputLogFormat::EventSize)
+		{
+			float args[4];
+			memcpy(args, in + 2, sizeof(args));
+			switch ((InputEvent)in[1])
+			{
+			case InputEvent::StartRound:
+				simulation.StartRound();
+				break;
+			case InputEvent::ResetRound:
+				simulation.ResetRound();
+				break;
+			case InputEvent::RetryRound:
+				simulation.RetryRound();
+				break;
+			case InputEvent::AbortRound:
+				simulation.AbortRound();
+				break;
+			case InputEvent::SpawnCircle:
+				simulation.SpawnCircle(args[0], args[1], args[2]);
+				break;
+			case InputEvent::SpawnBox:
+				simulation.SpawnBox(args[0], args[1], args[2], args[3]);
+				break;
+			case InputEvent::SetArenaSize:
+				simulation.SetArenaSize(args[0], args[1]);
+				break;
+			default:
+				ofLogWarning("InputReplayer") << "Unknown event " << (int)in[1] << " after tick " << stats.ticks;
+				break;
+			}
+			in += InputLogFormat::EventSize;
+			stats.events++;
+		}
+		else
+		{
+			//A recording cut short ends in the middle of a record
+			if (tag != InputLogFormat::TickTag && tag != InputLogFormat::ControlsTag && tag != InputLogFormat::EventTag)
+				ofLogError("InputReplayer") << "Unknown record after tick " << stats.ticks;
+			break;
+		}
+	}
+	stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	return stats;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "InputLogFormat.h"
+#include "MappedFile.h"
+#include "Simulation.h"
+
+struct InputReplayParams {
+	bool stopOnMismatch = false;	//Stop at the first tick whose hash differs from the recording
+	int terrainPrefetch = 0;	//Levels generated ahead, as in Simulation::SetTerrainPrefetch
+};
+
+struct InputReplayStats {
+	uint64_t ticks = 0;
+	uint64_t events = 0;
+	uint64_t mismatches = 0;	//Ticks whose world hash differs from the recorded one
+	int64_t firstMismatch = -1;	//Tick of the first one, the simulation diverged from there on
+	uint32_t finalHash = 0;
+	double seconds = 0.0;
+};
+
+//Plays an input log back into a fresh headless simulation, one step per recorded tick without any
+//pacing, and checks the world against the hash recorded for every tick. A session replays in a fraction
+//of the time it was played in, which makes it a regression test and a benchmark of the simulation.
+class InputReplayer
+{
+	MappedFile file;
+	InputLogHeader header;
+
+public:
+
+	bool Open(const std::string& path);
+	const InputLogHeader& GetHeader();
+	InputReplayStats Run(const InputReplayParams& params);
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+//Carries the packets of a rollback session between the peers, unreliably and unordered like UDP
+class InputTransport
+{
+public:
+
+	virtual ~InputTransport() {}
+
+	//To every other peer
+	virtual void Send(const uint8_t* data, int size) = 0;
+	//One waiting packet per call, returns its size or 0 when nothing is waiting
+	virtual int Receive(uint8_t* data, int capacity) = 0;
+};
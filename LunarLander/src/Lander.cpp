@@ -1,44 +1,14 @@
 #include "Lander.h"
 
-Lander::Lander(ofxBox2d* world, LanderParams params, ofVec2f topBoxSize, ofVec2f bottomBoxSize, std::string svgFileName)
+Lander::Lander(ofxBox2d* world, LunarLanderConatactManager* contactManager, LanderParams params, std::string svgFileName)
 {
 	this->params = params;
-	this->topBoxSize = topBoxSize;
-	this->bottomBoxSize = bottomBoxSize;
 	this->landerSvg = svgFileName;
 
-
-	//Create svg File
-	ofxSVG svgHandler;
-	std::string svgFilePath = ofFilePath::join(
-		ofFilePath::join(ofFilePath::getCurrentExeDir(), svgSourceFolder),
-		landerSvg + ".svg");
-	ofFile svgFile = ofFile(svgFilePath, ofFile::ReadOnly, false);
-	if (!svgFile.exists())
-	{
-		ofLogError("App") << "Couldn't fing svg file at " + svgFilePath;
-		return;
-	}
-	//Read svg data
-	svgHandler.load(svgFilePath);
-	auto paths = svgHandler.getPaths();
-
-	//Create polylines
-	graphics.setMode(ofPath::POLYLINES);
-	graphics.setFilled(false);
-	graphics.setStrokeColor(ofColor::aliceBlue);
-	graphics.setStrokeWidth(2);
-	//Add points
-	for (ofPath p : paths)
-	{
-		graphics.append(p);
-	}
-	
-	float normalizeFactor = 1.f / std::max(svgHandler.getWidth(), svgHandler.getHeight());
-	//Center on image center
-	graphics.translate(ofVec2f(-svgHandler.getWidth() / 2.f, -svgHandler.getHeight() / 2.f));
-	//Scale down to normalized space
-	graphics.scale(normalizeFactor, normalizeFactor);
+	//Loaded once per process and shared, a missing asset leaves it empty and the lander invisible
+	model = LanderAssets::Get(landerSvg);
+	topBoxSize = model->topBoxSize;
+	bottomBoxSize = model->bottomBoxSize;
 
 	//Create physics
 	this->world = world;
@@ -71,55 +41,76 @@ Lander::Lander(ofxBox2d* world, LanderParams params, ofVec2f topBoxSize, ofVec2f
 	bottomFixtureDef.density = params.density;
 	bottomFixtureDef.friction = params.friction;
 	bottomFixtureDef.restitution = params.bounce;
+	bottomFixtureDef.filter.categoryBits = ContactTag::TagLanderLegs;
+	topFixtureDef.filter.categoryBits = ContactTag::TagLanderHull;
 
 	//Create fixtures
 	topFixture = physicsBody->CreateFixture(&topFixtureDef);
 	bottomFixture = physicsBody->CreateFixture(&bottomFixtureDef);
 
+	this->contactManager = contactManager;
 	crashListener = new LanderCrashContactListener(this);
-	crashListener->SetFixtureFilter(topFixture);
-	LunarLanderConatactManager::Get()->AddCallback(crashListener, ContactCallbackFlag::PostSolve);
+	contactManager->AddCallback(crashListener, ContactCallbackFlag::PostSolve);
 }
 
-void Lander::Draw()
+Lander::~Lander()
 {
-	if(!isActive)
-		return;
-	ofPushStyle();
-	ofPushMatrix();
-	//Apply physics transform to graphics
-
-	ofTranslate(currentPosition);
-	ofRotateRad(currentRotationRad);
-	ofScale(currentScale);
-
-	/*ofSetColor(ofColor::lightPink);
-	ofDrawRectangle(-params.topBoxSize / 2.f - ofVec2f(0.f, params.topBoxSize.y / 2.f), params.topBoxSize.x, params.topBoxSize.y);
-	ofSetColor(ofColor::azure);
-	ofDrawRectangle(-params.bottomBoxSize / 2.f + ofVec2f(0.f, params.bottomBoxSize.y / 2.f), params.bottomBoxSize.x, params.bottomBoxSize.y);*/
-	ofSetColor(180);
-	graphics.draw();
-
-
-	ofPopMatrix();
-
-	ofSetColor(ofColor::white);
-	std::string dbgString = "LANDER INFO\n";
-	dbgString += "Pos: " + ofToString(currentPosition) + "\n";
-	dbgString += "Rot: " + ofToString(GetRotationDeg()) + "\n";
-	dbgString += "deltaRot: " + ofToString(currentRotationRate * RAD_TO_DEG) + "\n";
-	dbgString += "thrust: " + ofToString(currentThrusterStrength) + "\n";
-	ofDrawBitmapString(dbgString, ofVec2f(30, 30));
+	if (crashListener)
+		contactManager->RemoveCallback(crashListener);
+	delete crashListener;
+}
 
-	ofPopStyle();
+void Lander::Record(DrawList& list, float alpha, float tolerance)
+{
+	if (!isActive)
+		return;
+	//The model is in normalized space, the tolerance is in screen units
+	float localTolerance = tolerance / currentScale;
+	if (localTolerance != laserTolerance)
+		SimplifyModel(localTolerance);
+
+	//Apply physics transform to graphics, interpolated between the last two ticks
+	DrawTransform transform;
+	transform.translation = previousPosition.getInterpolated(currentPosition, alpha);
+	transform.rotationRad = previousRotationRad + (currentRotationRad - previousRotationRad) * alpha;
+	transform.scale = currentScale;
+	framePoints.resize(model->points.size());
+	DrawList::Apply(transform, model->points.data(), model->points.size(), framePoints.data());
+	laserFramePoints.resize(laserModel.points.size());
+	DrawList::Apply(transform, laserModel.points.data(), laserModel.points.size(), laserFramePoints.data());
+
+	//Raster outputs get the full outline, vector outputs the simplified one
+	for (const LanderSubpath& subpath : model->subpaths)
+	{
+		list.AddPolygon(&framePoints[subpath.first], subpath.count, ofColor::aliceBlue, 0, (subpath.closed ? DrawClosed : 0) | DrawRasterOnly);
+	}
+	for (const LanderSubpath& subpath : laserModel.subpaths)
+	{
+		list.AddPolygon(&laserFramePoints[subpath.first], subpath.count, ofColor(180), 0, (subpath.closed ? DrawClosed : 0) | DrawVectorOnly);
+	}
 }
 
 void Lander::Update()
 {
+	float rotation = physicsBody->GetAngle();
+	physicsBody->ApplyForceToCenter(b2Vec2(sin(rotation) * currentThrusterStrength, -cos(rotation) * currentThrusterStrength), true);
+	physicsBody->ApplyTorque(currentRotationRate, true);
+}
+
+void Lander::Sync()
+{
+	previousPosition = currentPosition;
+	previousRotationRad = currentRotationRad;
 	currentPosition = worldPtToscreenPt(physicsBody->GetPosition());
 	currentRotationRad = physicsBody->GetAngle();
-	physicsBody->ApplyForceToCenter(b2Vec2(sin(currentRotationRad) * currentThrusterStrength, -cos(currentRotationRad) * currentThrusterStrength), true);
-	physicsBody->ApplyTorque(currentRotationRate, true);
+}
+
+void Lander::SnapState()
+{
+	//Teleports must not be interpolated from the old position
+	Sync();
+	previousPosition = currentPosition;
+	previousRotationRad = currentRotationRad;
 }
 
 void Lander::SetScale(float scale)
@@ -161,9 +152,12 @@ void Lander::Start(LanderParams params)
 	physicsBody->SetAngularDamping(params.angularDamping);
 	physicsBody->SetTransform(screenPtToWorldPt(params.startingPos), 0.f);
 	physicsBody->SetLinearVelocity(b2Vec2(params.startVelocity, 0.f));
+	physicsBody->SetAngularVelocity(0.f);
 	physicsBody->SetActive(true);
 	currentThrusterStrength = 0.f;
 	isActive = true;
+	isCrashed = false;
+	SnapState();
 }
 
 void Lander::Sleep()
@@ -195,8 +189,35 @@ void Lander::Reset()
 		0.f
 	);
 	physicsBody->SetLinearVelocity(b2Vec2(params.startVelocity, 0.f));
+	physicsBody->SetAngularVelocity(0.f);
 	currentThrusterStrength = 0.f;
+	isCrashed = false;
 	physicsBody->SetActive(true);
+	SnapState();
+}
+
+void Lander::Capture(LanderSnapshot& snapshot)
+{
+	snapshot.body.Capture(physicsBody);
+	snapshot.thrusterStrength = currentThrusterStrength;
+	snapshot.rotationRate = currentRotationRate;
+	snapshot.active = isActive;
+	snapshot.crashed = isCrashed;
+}
+
+void Lander::Restore(const LanderSnapshot& snapshot)
+{
+	snapshot.body.Restore(physicsBody);
+	currentThrusterStrength = snapshot.thrusterStrength;
+	currentRotationRate = snapshot.rotationRate;
+	isActive = snapshot.active;
+	isCrashed = snapshot.crashed;
+	SnapState();
+}
+
+void Lander::Crash()
+{
+	isCrashed = true;
 }
 
 ofVec2f Lander::GetPosition()
@@ -220,7 +241,60 @@ bool Lander::IsStationary(float tolerance)
 	return vel < tolerance && vel > -tolerance;
 }
 
+bool Lander::IsCrashed()
+{
+	return isCrashed;
+}
+
+bool Lander::IsActive()
+{
+	return isActive;
+}
+
+float Lander::GetRotationRate()
+{
+	return currentRotationRate;
+}
+
+float Lander::GetThrusterStrength()
+{
+	return currentThrusterStrength;
+}
+
+float Lander::GetCrashImpulse()
+{
+	return params.crashImpulse;
+}
+
 b2Body* Lander::GetBody()
 {
 	return physicsBody;
-}
\ No newline at end of file
+}
+
+b2Fixture* Lander::GetHullFixture()
+{
+	return topFixture;
+}
+
+void Lander::SimplifyModel(float tolerance)
+{
+	laserModel.points.clear();
+	laserModel.subpaths.clear();
+	for (const LanderSubpath& subpath : model->subpaths)
+	{
+		simplifyIn.clear();
+		simplifyIn.setClosed(subpath.closed);
+		for (int i = 0; i < subpath.count; i++)
+		{
+			const ofVec2f& point = model->points[subpath.first + i];
+			simplifyIn.addVertex(point.x, point.y, 0.f);
+		}
+		simplifier.Simplify(simplifyIn, tolerance, std::vector<int>(), simplifyOut);
+		laserModel.subpaths.push_back({ (int)laserModel.points.size(), (int)simplifyOut.size(), subpath.closed });
+		for (const ofDefaultVertexType& v : simplifyOut)
+		{
+			laserModel.points.push_back(ofVec2f(v.x, v.y));
+		}
+	}
+	laserTolerance = tolerance;
+}
@@ -5,6 +5,10 @@
 #include "ofUtils.h"
 #include "ofxBox2d.h"
 #include "ContactListeners.h"
+#include "LaserLod.h"
+#include "DrawList.h"
+#include "LanderAssets.h"
+#include "SimulationSnapshot.h"
 
 struct LanderParams {
 	float angularDamping;
@@ -14,27 +18,37 @@ struct LanderParams {
 	float bounce;
 	ofVec2f startingPos = ofVec2f(200.f, 100.f);
 	float startVelocity = 10.f;
+	float crashImpulse = .5f;	//Normal impulse on the top box that destroys the lander
 };
 
 class Lander {
 
-	const std::string svgSourceFolder = "res/";
-
 	LanderParams params;
 	std::string landerSvg;
-	ofVec2f topBoxSize = ofVec2f(.65f, .6f);
-	ofVec2f bottomBoxSize = ofVec2f(.8f, .4f);
+	ofVec2f topBoxSize;
+	ofVec2f bottomBoxSize;
 
 	ofVec2f currentPosition = ofVec2f(0.f, 0.f);
 	float currentRotationRad = 0.f;
+	ofVec2f previousPosition = ofVec2f(0.f, 0.f);	//State of the previous tick, for interpolated drawing
+	float previousRotationRad = 0.f;
 	float currentScale = 1.f;
 
 	float currentRotationRate = 0.f;
 	float currentThrusterStrength = 0.f;
 
-	ofPath graphics;
+	std::shared_ptr<const LanderModel> model;
+	std::vector<ofVec2f> framePoints;	//The model moved to where it is drawn this frame
+	//Simplified model for the laser, rebuilt when the tolerance changes
+	PolylineSimplifier simplifier;
+	ofPolyline simplifyIn;
+	ofPolyline simplifyOut;
+	LanderModel laserModel;
+	std::vector<ofVec2f> laserFramePoints;
+	float laserTolerance = -1.f;
 
-	LanderCrashContactListener* crashListener;
+	LanderCrashContactListener* crashListener = nullptr;
+	LunarLanderConatactManager* contactManager = nullptr;
 
 	ofxBox2d* world;
 	b2Body* physicsBody;
@@ -45,12 +59,16 @@ class Lander {
 	b2FixtureDef bottomFixtureDef;
 
 	bool isActive = false;
+	bool isCrashed = false;
 
 public:
 
-	Lander(ofxBox2d* world, LanderParams params, ofVec2f topBoxSize, ofVec2f bottomBoxSize, std::string svgFileName);
-	void Draw();
+	Lander(ofxBox2d* world, LunarLanderConatactManager* contactManager, LanderParams params, std::string svgFileName);
+	~Lander();
+	//Records the lander interpolated between the last two ticks, the laser outline is simplified to the tolerance in screen units
+	void Record(DrawList& list, float alpha = 1.f, float tolerance = 0.f);
 	void Update();
+	void Sync();
 	void SetScale(float scale);
 
 	void Start(LanderParams params);
@@ -60,12 +78,26 @@ public:
 	void AddThrusterStrength(float strength);
 	void SetRotationRate(float rotation);
 	void Reset();
+	void Crash();
+	void Capture(LanderSnapshot& snapshot);
+	//Puts the lander back in place without touching its fixtures
+	void Restore(const LanderSnapshot& snapshot);
 
 	ofVec2f GetPosition();
 	float GetRotationRad();
 	float GetRotationDeg();
 	bool IsStationary(float tolerance = .5f);
+	bool IsCrashed();
+	bool IsActive();
+	float GetRotationRate();
+	float GetThrusterStrength();
+	float GetCrashImpulse();
 
 	b2Body* GetBody();
+	b2Fixture* GetHullFixture();
+
+private:
 
+	void SnapState();
+	void SimplifyModel(float tolerance);
 };
\ No newline at end of file
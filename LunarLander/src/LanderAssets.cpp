@@ -0,0 +1,203 @@
+#include "LanderAssets.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include "MappedFile.h"
+#include "Fnv1a.h"
+
+uint64_t LanderAssets::SourceHash(const std::string& svgPath, const LanderModel& boxes, bool& found)
+{
+	MappedFile svg;
+	found = svg.Open(svgPath);
+	if (!found)
+		return 0;
+	uint64_t hash = Fnv1aOffset64;
+	Fnv1a(hash, svg.GetData(), svg.GetSize());
+	//Other boxes make another asset from the same svg
+	float sizes[4] = { boxes.topBoxSize.x, boxes.topBoxSize.y, boxes.bottomBoxSize.x, boxes.bottomBoxSize.y };
+	Fnv1a(hash, sizes, sizeof(sizes));
+	uint32_t version = Version;
+	Fnv1a(hash, &version, sizeof(version));
+	return hash;
+}
+
+bool LanderAssets::ReadBakedHash(const std::string& bakedPath, uint64_t& hash)
+{
+	FILE* file = fopen(bakedPath.c_str(), "rb");
+	if (!file)
+		return false;
+	Header header;
+	bool read = fread(&header, sizeof(header), 1, file) == 1;
+	fclose(file);
+	if (!read || header.magic != Magic || header.version != Version)
+		return false;
+	hash = header.sourceHash;
+	return true;
+}
+
+std::string LanderAssets::GetResourceFolder()
+{
+	return ofFilePath::join(ofFilePath::getCurrentExeDir(), "res/");
+}
+
+std::string LanderAssets::GetBakedPath(const std::string& svgPath)
+{
+	return ofFilePath::removeExt(svgPath) + ".lnd";
+}
+
+bool LanderAssets::Bake(const std::string& svgPath, const LanderBakeParams& params, bool& skipped)
+{
+	skipped = false;
+	std::string bakedPath = GetBakedPath(svgPath);
+	bool found;
+	uint64_t hash = SourceHash(svgPath, params.boxes, found);
+	if (!found)
+		return false;
+	uint64_t bakedHash;
+	if (!params.force && ReadBakedHash(bakedPath, bakedHash) && bakedHash == hash)
+	{
+		skipped = true;
+		return true;
+	}
+
+	LanderModel model;
+	if (!LanderModel::LoadSvg(svgPath, model))
+		return false;
+
+	Header header;
+	header.magic = Magic;
+	header.version = Version;
+	header.sourceHash = hash;
+	header.pointCount = model.points.size();
+	header.subpathCount = model.subpaths.size();
+	header.topBoxSize[0] = params.boxes.topBoxSize.x;
+	header.topBoxSize[1] = params.boxes.topBoxSize.y;
+	header.bottomBoxSize[0] = params.boxes.bottomBoxSize.x;
+	header.bottomBoxSize[1] = params.boxes.bottomBoxSize.y;
+
+	std::vector<uint8_t> data(sizeof(Header) + model.subpaths.size() * 3 * sizeof(int32_t) + model.points.size() * 2 * sizeof(float));
+	uint8_t* out = data.data();
+	memcpy(out, &header, sizeof(header));
+	out += sizeof(header);
+	for (const LanderSubpath& subpath : model.subpaths)
+	{
+		int32_t record[3] = { subpath.first, subpath.count, subpath.closed ? 1 : 0 };
+		memcpy(out, record, sizeof(record));
+		out += sizeof(record);
+	}
+	for (const ofVec2f& point : model.points)
+	{
+		float xy[2] = { point.x, point.y };
+		memcpy(out, xy, sizeof(xy));
+		out += sizeof(xy);
+	}
+
+	FILE* file = fopen(bakedPath.c_str(), "wb");
+	if (!file)
+	{
+		ofLogError("LanderAssets") << "Couldn't open " << bakedPath << " for writing";
+		return false;
+	}
+	bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+	fclose(file);
+	if (!written)
+		ofLogError("LanderAssets") << "Write to " << bakedPath << " failed";
+	return written;
+}
+
+int LanderAssets::BakeFolder(const std::string& folder, const LanderBakeParams& params)
+{
+	ofDirectory directory(folder);
+	directory.allowExt("svg");
+	directory.listDir();
+	int baked = 0, skipped = 0, failed = 0;
+	for (size_t i = 0; i < directory.size(); i++)
+	{
+		bool wasSkipped;
+		if (!Bake(directory.getPath(i), params, wasSkipped))
+		{
+			ofLogError("LanderAssets") << "Couldn't bake " << directory.getPath(i);
+			failed++;
+		}
+		else if (wasSkipped)
+			skipped++;
+		else
+			baked++;
+	}
+	ofLogNotice("LanderAssets") << baked << " baked, " << skipped << " unchanged, " << failed << " failed in " << folder;
+	return failed;
+}
+
+bool LanderAssets::LoadBaked(const std::string& bakedPath, LanderModel& model)
+{
+	MappedFile file;
+	if (!ofFile::doesFileExist(bakedPath, false) || !file.Open(bakedPath))
+		return false;
+
+	Header header;
+	if (file.GetSize() < sizeof(header))
+		return false;
+	memcpy(&header, file.GetData(), sizeof(header));
+	size_t size = sizeof(Header) + (size_t)header.subpathCount * 3 * sizeof(int32_t) + (size_t)header.pointCount * 2 * sizeof(float);
+	if (header.magic != Magic || header.version != Version || file.GetSize() != size)
+	{
+		ofLogWarning("LanderAssets") << bakedPath << " is from another version or damaged, bake the assets again";
+		return false;
+	}
+
+	const uint8_t* in = file.GetData() + sizeof(header);
+	model.subpaths.resize(header.subpathCount);
+	for (LanderSubpath& subpath : model.subpaths)
+	{
+		int32_t record[3];
+		memcpy(record, in, sizeof(record));
+		in += sizeof(record);
+		subpath = { record[0], record[1], record[2] != 0 };
+		if (subpath.first < 0 || subpath.count < 0 || (uint32_t)(subpath.first + subpath.count) > header.pointCount)
+			return false;
+	}
+	//ofVec2f is two packed floats
+	model.points.resize(header.pointCount);
+	memcpy(model.points.data(), in, header.pointCount * 2 * sizeof(float));
+	model.topBoxSize = ofVec2f(header.topBoxSize[0], header.topBoxSize[1]);
+	model.bottomBoxSize = ofVec2f(header.bottomBoxSize[0], header.bottomBoxSize[1]);
+	return true;
+}
+
+std::shared_ptr<const LanderModel> LanderAssets::Get(const std::string& name)
+{
+	static std::mutex mutex;
+	static std::map<std::string, std::shared_ptr<const LanderModel> > models;
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = models.find(name);
+	if (found != models.end())
+		return found->second;
+
+	std::string svgPath = ofFilePath::join(GetResourceFolder(), name + ".svg");
+	std::string bakedPath = GetBakedPath(svgPath);
+	std::shared_ptr<LanderModel> model = std::make_shared<LanderModel>();
+	bool loaded = LoadBaked(bakedPath, *model);
+	if (loaded)
+	{
+		//The baked boxes are part of the hash; without the svg there is nothing to compare and the file is used
+		bool found;
+		uint64_t hash = SourceHash(svgPath, *model, found), bakedHash;
+		if (found && (!ReadBakedHash(bakedPath, bakedHash) || bakedHash != hash))
+		{
+			ofLogWarning("LanderAssets") << svgPath << " changed since " << bakedPath << " was baked, parsing it instead; bake the assets again";
+			*model = LanderModel();
+			loaded = false;
+		}
+	}
+	if (!loaded)
+	{
+		if (LanderModel::LoadSvg(svgPath, *model))
+			ofLogNotice("LanderAssets") << name << " isn't baked, parsed " << svgPath;
+		else
+			ofLogError("LanderAssets") << "Couldn't find " << name << " in " << GetResourceFolder();
+	}
+	models[name] = model;
+	return model;
+}
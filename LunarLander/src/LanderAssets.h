@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include "LanderModel.h"
+
+struct LanderBakeParams {
+	LanderModel boxes;	//Only the collision boxes are used, they are baked into every asset
+	bool force = false;	//Rebake assets whose source hasn't changed
+};
+
+//Lander models baked from svg into a compact binary file (".lnd" next to the svg), so loading one costs
+//a memory map instead of parsing xml. The file holds the normalized, flattened outline and the collision
+//boxes, plus a hash of everything it was baked from; baking skips files whose hash still matches.
+//
+//Layout, native endianness: header, subpathCount records of 3 int32 (first, count, closed), pointCount
+//pairs of float.
+class LanderAssets
+{
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t pointCount;
+		uint32_t subpathCount;
+		float topBoxSize[2];
+		float bottomBoxSize[2];
+	};
+
+	static const uint32_t Magic = 0x52444E4C;	//"LNDR"
+	static const uint32_t Version = 1;
+
+	static uint64_t SourceHash(const std::string& svgPath, const LanderModel& boxes, bool& found);
+	static bool ReadBakedHash(const std::string& bakedPath, uint64_t& hash);
+
+public:
+
+	static std::string GetResourceFolder();
+	static std::string GetBakedPath(const std::string& svgPath);
+
+	//Bakes one svg, true when the baked file is up to date afterwards
+	static bool Bake(const std::string& svgPath, const LanderBakeParams& params, bool& skipped);
+	//Bakes every svg in the folder, returns how many failed
+	static int BakeFolder(const std::string& folder, const LanderBakeParams& params);
+
+	static bool LoadBaked(const std::string& bakedPath, LanderModel& model);
+	//The model of res/<name>, loaded once per process and shared by every lander (and thread) using it.
+	//The baked file is used when there is one and it was baked from the svg as it is now, the svg otherwise.
+	static std::shared_ptr<const LanderModel> Get(const std::string& name);
+};
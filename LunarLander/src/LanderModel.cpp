@@ -0,0 +1,34 @@
+#include "LanderModel.h"
+
+#include "ofxSvg.h"
+
+bool LanderModel::LoadSvg(const std::string& path, LanderModel& model)
+{
+	model.points.clear();
+	model.subpaths.clear();
+	if (!ofFile::doesFileExist(path, false))
+		return false;
+
+	ofxSVG svgHandler;
+	svgHandler.load(path);
+	float width = svgHandler.getWidth(), height = svgHandler.getHeight();
+	float normalizeFactor = 1.f / std::max(width, height);
+	ofVec2f center(width / 2.f, height / 2.f);
+
+	//The only tessellation the lander ever does
+	for (const ofPath& svgPath : svgHandler.getPaths())
+	{
+		for (const ofPolyline& line : svgPath.getOutline())
+		{
+			if (line.size() == 0)
+				continue;
+			LanderSubpath subpath = { (int)model.points.size(), (int)line.size(), line.isClosed() };
+			for (const ofDefaultVertexType& v : line)
+			{
+				model.points.push_back((ofVec2f(v.x, v.y) - center) * normalizeFactor);
+			}
+			model.subpaths.push_back(subpath);
+		}
+	}
+	return true;
+}
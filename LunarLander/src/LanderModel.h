@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ofMain.h"
+
+struct LanderSubpath {
+	int first;	//First point in the model's point array
+	int count;
+	bool closed;
+};
+
+//Outline of a lander, flattened once: every subpath of the svg is a range of one contiguous point array,
+//centered on the image and normalized so the longer side of the image is 1
+struct LanderModel {
+	std::vector<ofVec2f> points;
+	std::vector<LanderSubpath> subpaths;
+	//Collision boxes in normalized space, the svg has none so it gets these
+	ofVec2f topBoxSize = ofVec2f(.65f, .6f);
+	ofVec2f bottomBoxSize = ofVec2f(.8f, .4f);
+
+	//Flattens the outlines of every path in the svg, false when it can't be read
+	static bool LoadSvg(const std::string& path, LanderModel& model);
+};
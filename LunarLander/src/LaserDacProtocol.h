@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+//Header of a data packet, followed by pointCount points of PointSize bytes
+struct LaserDacHeader {
+	uint32_t pointsPerSecond;
+	uint16_t pointCount;
+	uint64_t sendTimeMicros;	//Steady clock of the sender, echoed back in the status
+};
+
+//Reply of the DAC to every data packet
+struct LaserDacStatus {
+	uint32_t bufferFullness;	//Points queued in the DAC
+	uint32_t bufferCapacity;
+	uint32_t underruns;	//Times the DAC ran dry since the connection opened
+	uint64_t echoSendTimeMicros;
+};
+
+//Wire format between NetworkLaserOutput and a DAC over TCP, little endian throughout.
+//Points are x, y as int16 (y up, full range is the projection area), then r, g, b and a spare byte.
+class LaserDacProtocol
+{
+	static void Write(uint8_t*& out, uint64_t value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++)
+		{
+			*out++ = (uint8_t)(value >> (8 * i));
+		}
+	}
+
+	static uint64_t Read(const uint8_t*& in, int bytes)
+	{
+		uint64_t value = 0;
+		for (int i = 0; i < bytes; i++)
+		{
+			value |= (uint64_t)*in++ << (8 * i);
+		}
+		return value;
+	}
+
+public:
+
+	static const uint32_t DataMagic = 0x4C444154;	//"TADL"
+	static const uint32_t StatusMagic = 0x4C445354;	//"TSDL"
+	static const int DefaultPort = 7765;
+	static const int HeaderSize = 18;
+	static const int PointSize = 8;
+	static const int StatusSize = 24;
+	static const int MaxPointsPerPacket = 1024;
+
+	static uint64_t NowMicros()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static void EncodeHeader(uint8_t* out, const LaserDacHeader& header)
+	{
+		Write(out, DataMagic, 4);
+		Write(out, header.pointsPerSecond, 4);
+		Write(out, header.pointCount, 2);
+		Write(out, header.sendTimeMicros, 8);
+	}
+
+	static bool DecodeHeader(const uint8_t* in, LaserDacHeader& header)
+	{
+		if (Read(in, 4) != DataMagic)
+			return false;
+		header.pointsPerSecond = (uint32_t)Read(in, 4);
+		header.pointCount = (uint16_t)Read(in, 2);
+		header.sendTimeMicros = Read(in, 8);
+		return true;
+	}
+
+	static void EncodePoint(uint8_t* out, int16_t x, int16_t y, uint8_t r, uint8_t g, uint8_t b)
+	{
+		Write(out, (uint16_t)x, 2);
+		Write(out, (uint16_t)y, 2);
+		*out++ = r;
+		*out++ = g;
+		*out++ = b;
+		*out++ = 0;
+	}
+
+	static void EncodeStatus(uint8_t* out, const LaserDacStatus& status)
+	{
+		Write(out, StatusMagic, 4);
+		Write(out, status.bufferFullness, 4);
+		Write(out, status.bufferCapacity, 4);
+		Write(out, status.underruns, 4);
+		Write(out, status.echoSendTimeMicros, 8);
+	}
+
+	static bool DecodeStatus(const uint8_t* in, LaserDacStatus& status)
+	{
+		if (Read(in, 4) != StatusMagic)
+			return false;
+		status.bufferFullness = (uint32_t)Read(in, 4);
+		status.bufferCapacity = (uint32_t)Read(in, 4);
+		status.underruns = (uint32_t)Read(in, 4);
+		status.echoSendTimeMicros = Read(in, 8);
+		return true;
+	}
+};
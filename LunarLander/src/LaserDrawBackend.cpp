@@ -0,0 +1,29 @@
+#include "LaserDrawBackend.h"
+
+void LaserDrawBackend::SetFrame(LaserFrameBuilder* frame)
+{
+	this->frame = frame;
+}
+
+void LaserDrawBackend::Draw(const DrawList& list)
+{
+	frame->BeginFrame();
+	LaserTransform view;
+	view.translation = list.GetView().translation;
+	view.rotationRad = list.GetView().rotationRad;
+	view.scale = list.GetView().scale;
+	for (const DrawCommand& command : list.GetCommands())
+	{
+		if (command.type != DrawCommandType::Polyline || (command.flags & DrawRasterOnly) || command.outlineCount == 0)
+			continue;
+		//The frame builder folds the view into each path's transform itself
+		frame->SetView(command.flags & DrawScreenSpace ? LaserTransform() : view);
+		const DrawTransform& source = list.GetTransform(command.transform);
+		LaserTransform transform;
+		transform.translation = source.translation;
+		transform.rotationRad = source.rotationRad;
+		transform.scale = source.scale;
+		frame->AddPath(list.GetVertices() + command.outlineFirst, command.outlineCount, (command.flags & DrawClosed) != 0, command.color, transform, (command.flags & DrawStatic) != 0);
+	}
+	frame->EndFrame();
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "DrawList.h"
+#include "LaserFrameBuilder.h"
+
+//Builds a laser frame from a list: every polyline that isn't raster only becomes a path of its outline.
+//Fills, paths and text have no laser equivalent and are skipped.
+class LaserDrawBackend : public DrawBackend
+{
+	LaserFrameBuilder* frame = nullptr;
+
+public:
+
+	void SetFrame(LaserFrameBuilder* frame);
+	void Draw(const DrawList& list) override;
+};
@@ -0,0 +1,231 @@
+#include "LaserFrameBuilder.h"
+
+void LaserFrameBuilder::Setup(const LaserFrameParams& params)
+{
+	this->params = params;
+	budget = std::max(1, (int)(params.pointsPerSecond / params.targetFps));
+	//A frame never has more lit points than the budget, so neither can the staged vertices
+	vertices.resize(budget);
+	paths.resize(params.maxPaths);
+	pathEnds.resize(params.maxPaths);
+	order.reserve(params.maxPaths);
+	points.resize(budget);
+	optimizer.Setup(params.maxPaths, params.optimizeBudgetMicros);
+	pointCount = 0;
+}
+
+void LaserFrameBuilder::BeginFrame()
+{
+	vertexCount = 0;
+	pathCount = 0;
+	pointCount = 0;
+	stats = LaserFrameStats();
+}
+
+void LaserFrameBuilder::EndFrame()
+{
+	if (params.optimizePaths)
+	{
+		optimizer.Optimize(pathEnds, pathCount, beam, order);
+		stats.optimizeMicros = optimizer.GetLastMicros();
+	}
+	else
+	{
+		order.clear();
+		for (int i = 0; i < pathCount; i++)
+		{
+			order.push_back({ i, false });
+		}
+	}
+	stats.blankTravel = LaserPathOptimizer::BlankTravel(pathEnds, order, beam);
+
+	for (const LaserPathRef& ref : order)
+	{
+		EmitPath(paths[ref.path], ref.reversed);
+	}
+
+	stats.maxLitStep = LaserResampler::MaxLitStep(points.data(), pointCount);
+	stats.maxBlankStep = LaserResampler::MaxBlankStep(points.data(), pointCount);
+	stats.demandPoints = pointCount + stats.droppedPoints;
+	if (pointCount > 0)
+	{
+		beam = ofVec2f(points[pointCount - 1].x, points[pointCount - 1].y);
+		if (params.padToBudget)
+		{
+			//Park the blanked beam on the last point for the rest of the frame
+			Blank(beam.x, beam.y, budget - pointCount);
+		}
+	}
+}
+
+void LaserFrameBuilder::SetView(const LaserTransform& view)
+{
+	this->view = view;
+}
+
+void LaserFrameBuilder::AddPath(const ofVec2f* vertices, int count, bool closed, const ofColor& color, const LaserTransform& transform, bool isStatic)
+{
+	if (count == 0 || !BeginPath())
+		return;
+
+	//Fold the path and view transforms into one, so every vertex costs a single multiply-add
+	float scale = transform.scale * view.scale;
+	float rotation = transform.rotationRad + view.rotationRad;
+	float cosR = cos(rotation) * scale, sinR = sin(rotation) * scale;
+	float viewCos = cos(view.rotationRad) * view.scale, viewSin = sin(view.rotationRad) * view.scale;
+	ofVec2f offset(
+		viewCos * transform.translation.x - viewSin * transform.translation.y + view.translation.x,
+		viewSin * transform.translation.x + viewCos * transform.translation.y + view.translation.y
+	);
+
+	int total = closed ? count + 1 : count;
+	int fits = std::min(total, budget - vertexCount);
+	stats.droppedPoints += total - fits;
+	for (int i = 0; i < fits; i++)
+	{
+		const ofVec2f& v = vertices[i % count];
+		this->vertices[vertexCount++] = ofVec2f(cosR * v.x - sinR * v.y + offset.x, sinR * v.x + cosR * v.y + offset.y);
+	}
+	EndPath(color, isStatic);
+}
+
+const LaserPoint* LaserFrameBuilder::GetPoints()
+{
+	return points.data();
+}
+
+int LaserFrameBuilder::GetPointCount()
+{
+	return pointCount;
+}
+
+int LaserFrameBuilder::GetBudget()
+{
+	return budget;
+}
+
+const LaserFrameParams& LaserFrameBuilder::GetParams()
+{
+	return params;
+}
+
+const LaserFrameStats& LaserFrameBuilder::GetStats()
+{
+	return stats;
+}
+
+void LaserFrameBuilder::DrawPreview()
+{
+	//The mesh keeps its capacity between frames
+	preview.clear();
+	preview.setMode(OF_PRIMITIVE_LINES);
+	for (int i = 1; i < pointCount; i++)
+	{
+		const LaserPoint& a = points[i - 1];
+		const LaserPoint& b = points[i];
+		if (!(b.r | b.g | b.b))
+			continue;
+		ofFloatColor color(ofColor(b.r, b.g, b.b));
+		preview.addVertex(ofDefaultVertexType(a.x, a.y, 0.f));
+		preview.addColor(color);
+		preview.addVertex(ofDefaultVertexType(b.x, b.y, 0.f));
+		preview.addColor(color);
+	}
+	preview.draw();
+}
+
+bool LaserFrameBuilder::BeginPath()
+{
+	if (pathCount < params.maxPaths)
+	{
+		paths[pathCount].start = vertexCount;
+		return true;
+	}
+	stats.droppedPaths++;
+	return false;
+}
+
+void LaserFrameBuilder::EndPath(const ofColor& color, bool isStatic)
+{
+	LaserPath& path = paths[pathCount];
+	path.count = vertexCount - path.start;
+	path.color = color;
+	if (path.count == 0)
+		return;
+	pathEnds[pathCount] = { vertices[path.start], vertices[vertexCount - 1], isStatic };
+	pathCount++;
+	stats.paths++;
+}
+
+void LaserFrameBuilder::EmitPath(const LaserPath& path, bool reversed)
+{
+	auto vertex = [&](int i) -> const ofVec2f& { return vertices[path.start + (reversed ? path.count - 1 - i : i)]; };
+	const ofVec2f& first = vertex(0);
+
+	//Beam off at the end of the previous path, or where the previous frame parked it, jump, dwell on the new
+	//start, then draw
+	ofVec2f last = pointCount > 0 ? ofVec2f(points[pointCount - 1].x, points[pointCount - 1].y) : beam;
+	Blank(last.x, last.y, params.blankingPoints);
+	if (params.resample)
+	{
+		int steps = LaserResampler::EasedStepCount(last, first, params.maxBlankStep);
+		int fits = std::min(steps, budget - pointCount);
+		//Out of budget the jump stops short instead of taking longer steps than the galvos can follow
+		ofVec2f target = fits < steps ? last + (first - last) * ((float)fits / steps) : first;
+		LaserResampler::EaseBlank(last, target, fits, points.data() + pointCount);
+		pointCount += fits;
+		stats.blankPoints += fits;
+		stats.droppedPoints += steps - fits;
+	}
+	Blank(first.x, first.y, params.blankingPoints);
+	Push(first.x, first.y, path.color);
+
+	float cornerAngle = params.cornerAngleDeg * DEG_TO_RAD;
+	for (int i = 1; i < path.count; i++)
+	{
+		const ofVec2f& from = vertex(i - 1);
+		const ofVec2f& to = vertex(i);
+		if (!params.resample)
+		{
+			Push(to.x, to.y, path.color);
+			continue;
+		}
+		if (i >= 2)
+		{
+			int dwell = LaserResampler::CornerDwell(vertex(i - 2), from, to, cornerAngle, params.maxCornerDwell);
+			for (int d = 0; d < dwell; d++)
+			{
+				Push(from.x, from.y, path.color);
+			}
+		}
+		int steps = LaserResampler::StepCount(from, to, params.maxStep);
+		int fits = std::min(steps, budget - pointCount);
+		ofVec2f target = fits < steps ? from + (to - from) * ((float)fits / steps) : to;
+		LaserResampler::ResampleSegment(from, target, fits, path.color, points.data() + pointCount);
+		pointCount += fits;
+		stats.litPoints += fits;
+		stats.droppedPoints += steps - fits;
+	}
+}
+
+void LaserFrameBuilder::Push(float x, float y, const ofColor& color)
+{
+	if (pointCount >= budget)
+	{
+		stats.droppedPoints++;
+		return;
+	}
+	points[pointCount++] = { x, y, color.r, color.g, color.b };
+	if (color.r | color.g | color.b)
+		stats.litPoints++;
+	else
+		stats.blankPoints++;
+}
+
+void LaserFrameBuilder::Blank(float x, float y, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		Push(x, y, ofColor(0, 0, 0));
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ofMain.h"
+#include "LaserPathOptimizer.h"
+#include "LaserResampler.h"
+
+//One sample sent to the laser, in screen coordinates. A point with all channels at 0 is blanked.
+struct LaserPoint {
+	float x;
+	float y;
+	uint8_t r;
+	uint8_t g;
+	uint8_t b;
+};
+
+//Scale, then rotate, then translate
+struct LaserTransform {
+	ofVec2f translation = ofVec2f(0.f, 0.f);
+	float rotationRad = 0.f;
+	float scale = 1.f;
+};
+
+struct LaserFrameParams {
+	int pointsPerSecond = 30000;	//Scan rate of the projector
+	float targetFps = 30.f;	//Frames per second to hold, together with the scan rate this is the point budget of a frame
+	int blankingPoints = 8;	//Blanked points at both ends of a jump, so the galvos settle before the beam turns on
+	bool padToBudget = true;	//Fill short frames with blanked points, so the frame rate and brightness stay constant
+	int maxPaths = 512;	//Paths per frame, more are dropped
+	bool optimizePaths = true;	//Reorder and reverse paths to shorten blank travel, otherwise they are scanned as added
+	int optimizeBudgetMicros = 200;	//Time the path ordering may take per frame
+	bool resample = true;	//Space the points for the galvos, otherwise only the path vertices are scanned
+	float maxStep = 8.f;	//Longest lit step between two points in screen units, sets the scan velocity
+	float maxBlankStep = 40.f;	//Longest step of a blank jump, at the fastest point of the easing
+	float cornerAngleDeg = 30.f;	//Turns sharper than this get dwell points
+	int maxCornerDwell = 6;	//Dwell points on a full turn back
+};
+
+struct LaserFrameStats {
+	int paths = 0;
+	int litPoints = 0;
+	int blankPoints = 0;
+	int droppedPoints = 0;	//Points that did not fit the budget
+	int droppedPaths = 0;	//Paths over maxPaths
+	int demandPoints = 0;	//Points the frame needed before padding, including the dropped ones
+	float blankTravel = 0.f;	//Distance jumped with the beam off, in screen units
+	int optimizeMicros = 0;
+	float maxLitStep = 0.f;	//Longest lit step of the frame, should stay at maxStep when resampling
+	float maxBlankStep = 0.f;	//Longest blanked step, should stay at maxBlankStep when resampling
+};
+
+//Collects the geometry of a frame into one ordered point list for a laser projector.
+//Paths are staged while the frame is built and scanned out in an optimized order by EndFrame.
+//All buffers are sized once from the budget, building a frame never allocates.
+class LaserFrameBuilder
+{
+	struct LaserPath {
+		int start;	//First vertex in the vertex pool
+		int count;
+		ofColor color;
+	};
+
+	LaserFrameParams params;
+	int budget = 0;
+
+	//Staged geometry of the frame being built
+	std::vector<ofVec2f> vertices;
+	int vertexCount = 0;
+	std::vector<LaserPath> paths;
+	std::vector<LaserPathEnds> pathEnds;
+	int pathCount = 0;
+
+	LaserPathOptimizer optimizer;
+	std::vector<LaserPathRef> order;
+
+	std::vector<LaserPoint> points;	//Sized to the budget, only the first pointCount are part of the frame
+	int pointCount = 0;
+	ofVec2f beam = ofVec2f(0.f, 0.f);	//Where the previous frame left the beam
+
+	LaserTransform view;	//Applied after the transform of each path, e.g. the camera
+	LaserFrameStats stats;
+
+	ofMesh preview;
+
+	bool BeginPath();
+	void EndPath(const ofColor& color, bool isStatic);
+	void EmitPath(const LaserPath& path, bool reversed);
+	void Push(float x, float y, const ofColor& color);
+	void Blank(float x, float y, int count);
+
+public:
+
+	void Setup(const LaserFrameParams& params);
+	void BeginFrame();
+	void EndFrame();
+
+	void SetView(const LaserTransform& view);
+	//A closed path ends on its first vertex again
+	void AddPath(const ofVec2f* vertices, int count, bool closed, const ofColor& color, const LaserTransform& transform = LaserTransform(), bool isStatic = false);
+
+	const LaserPoint* GetPoints();
+	int GetPointCount();
+	int GetBudget();
+	const LaserFrameParams& GetParams();
+	const LaserFrameStats& GetStats();
+
+	//Draws the lit segments of the frame with OpenGL, to check a frame without a projector
+	void DrawPreview();
+};
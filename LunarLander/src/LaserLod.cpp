@@ -0,0 +1,133 @@
+#include "LaserLod.h"
+
+void PolylineSimplifier::Simplify(const ofPolyline& in, float tolerance, const std::vector<int>& protectedIdx, ofPolyline& out)
+{
+	int n = in.size();
+	out.clear();
+	out.setClosed(in.isClosed());
+	if (n < 3 || tolerance <= 0.f)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			out.addVertex(in[i]);
+		}
+		return;
+	}
+
+	keep.assign(n, 0);
+	keep[0] = keep[n - 1] = 1;
+	for (int idx : protectedIdx)
+	{
+		if (idx >= 0 && idx < n)
+			keep[idx] = 1;
+	}
+
+	//Protected vertices split the line, every stretch between them is simplified on its own
+	stack.clear();
+	int last = 0;
+	for (int i = 1; i < n; i++)
+	{
+		if (keep[i])
+		{
+			stack.push_back({ last, i });
+			last = i;
+		}
+	}
+
+	float toleranceSq = tolerance * tolerance;
+	while (!stack.empty())
+	{
+		int a = stack.back().first, b = stack.back().second;
+		stack.pop_back();
+		if (b - a < 2)
+			continue;
+
+		//Furthest vertex from the chord a-b
+		float ax = in[a].x, ay = in[a].y;
+		float dx = in[b].x - ax, dy = in[b].y - ay;
+		float lengthSq = dx * dx + dy * dy;
+		int furthest = -1;
+		float furthestSq = toleranceSq;
+		for (int i = a + 1; i < b; i++)
+		{
+			float px = in[i].x - ax, py = in[i].y - ay;
+			float distSq;
+			if (lengthSq > 0.f)
+			{
+				float cross = px * dy - py * dx;
+				distSq = cross * cross / lengthSq;
+			}
+			else
+				distSq = px * px + py * py;
+			if (distSq > furthestSq)
+			{
+				furthest = i;
+				furthestSq = distSq;
+			}
+		}
+		if (furthest < 0)
+			continue;
+		keep[furthest] = 1;
+		stack.push_back({ a, furthest });
+		stack.push_back({ furthest, b });
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		if (keep[i])
+			out.addVertex(in[i]);
+	}
+}
+
+void LaserLodController::Setup(const LaserLodParams& params)
+{
+	this->params = params;
+	level = 0;
+	cheapFrames = 0;
+}
+
+void LaserLodController::Update(const LaserFrameStats& stats, int budget)
+{
+	float target = budget * params.headroom;
+	if (stats.demandPoints > target)
+	{
+		level = std::min(level + 1, params.maxLevel);
+		cheapFrames = 0;
+	}
+	//Relax only well under the target, so the level does not flip back and forth
+	else if (stats.demandPoints < target * .5f)
+	{
+		if (++cheapFrames >= params.relaxFrames && level > 0)
+		{
+			level--;
+			cheapFrames = 0;
+		}
+	}
+	else
+		cheapFrames = 0;
+}
+
+int LaserLodController::GetLevel()
+{
+	return level;
+}
+
+float LaserLodController::GetTerrainTolerance()
+{
+	return level == 0 ? 0.f : params.baseTolerance * (1 << (level - 1));
+}
+
+float LaserLodController::GetLanderTolerance()
+{
+	return std::min(GetTerrainTolerance() * params.landerToleranceScale, params.maxLanderTolerance);
+}
+
+float LaserLodController::GetDebrisDetailDistance()
+{
+	return params.debrisDetailDistance / (1 + level);
+}
+
+float LaserLodController::GetDebrisCullDistance()
+{
+	return params.debrisCullDistance / (1 + level);
+}
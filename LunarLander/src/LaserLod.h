@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include "ofMain.h"
+#include "LaserFrameBuilder.h"
+
+//Ramer-Douglas-Peucker simplification of open polylines, with vertices that are always kept.
+//Owns its scratch buffers, so simplifying does not allocate once they have grown.
+class PolylineSimplifier
+{
+	std::vector<uint8_t> keep;
+	std::vector<std::pair<int, int> > stack;
+
+public:
+
+	void Simplify(const ofPolyline& in, float tolerance, const std::vector<int>& protectedIdx, ofPolyline& out);
+};
+
+struct LaserLodParams {
+	float headroom = .9f;	//Fraction of the point budget the frame should stay under
+	int maxLevel = 6;
+	float baseTolerance = .5f;	//Terrain tolerance of level 1 in screen units, doubling with every level
+	float landerToleranceScale = .25f;	//The lander is simplified much less than the terrain
+	float maxLanderTolerance = 1.f;
+	float debrisDetailDistance = 400.f;	//Debris closer than this to the lander is outlined at level 0
+	float debrisCullDistance = 1200.f;	//Debris further than this is not drawn at level 0
+	int relaxFrames = 30;	//Frames well under the budget before the level goes down again
+};
+
+//Picks the detail level of the laser frame from the measured point demand of the previous frames.
+//Goes up as soon as a frame is over the budget, and only comes down after a run of cheap frames.
+class LaserLodController
+{
+	LaserLodParams params;
+	int level = 0;
+	int cheapFrames = 0;
+
+public:
+
+	void Setup(const LaserLodParams& params);
+	void Update(const LaserFrameStats& stats, int budget);
+
+	int GetLevel();
+	float GetTerrainTolerance();
+	float GetLanderTolerance();
+	float GetDebrisDetailDistance();
+	float GetDebrisCullDistance();
+};
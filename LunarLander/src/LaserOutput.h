@@ -0,0 +1,55 @@
+#pragma once
+
+#include "LaserFrameBuilder.h"
+
+//Maps the screen area onto the signed 16 bit range projectors use, with y pointing up
+struct LaserScreenMapping {
+	int width = 1024;
+	int height = 768;
+
+	void ToDevice(const LaserPoint& point, int16_t& x, int16_t& y) const
+	{
+		x = (int16_t)ofClamp(point.x * 65534.f / width - 32767.f, -32767.f, 32767.f);
+		y = (int16_t)ofClamp(32767.f - point.y * 65534.f / height, -32767.f, 32767.f);
+	}
+
+	void ToScreen(int16_t x, int16_t y, LaserPoint& point) const
+	{
+		point.x = (x + 32767.f) * width / 65534.f;
+		point.y = (32767.f - y) * height / 65534.f;
+	}
+};
+
+//Where finished laser frames go. Submitting never blocks the game thread, an output that is not ready
+//drops the frame and keeps the previous one playing.
+class LaserOutput
+{
+public:
+
+	virtual ~LaserOutput() {}
+
+	//True when the output has room for another frame, building one otherwise is wasted work
+	virtual bool IsReady() = 0;
+	virtual bool SubmitFrame(const LaserPoint* points, int count, int pointsPerSecond) = 0;
+};
+
+//Takes every frame and only counts them, for measuring what feeds an output without one attached
+class NullLaserOutput : public LaserOutput
+{
+public:
+
+	uint64_t frames = 0;
+	uint64_t points = 0;
+
+	bool IsReady() override
+	{
+		return true;
+	}
+
+	bool SubmitFrame(const LaserPoint* points, int count, int pointsPerSecond) override
+	{
+		frames++;
+		this->points += count;
+		return true;
+	}
+};
@@ -0,0 +1,252 @@
+#include "LaserPathOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include "Fnv1a.h"
+
+static inline float Distance(const ofVec2f& a, const ofVec2f& b)
+{
+	float dx = a.x - b.x, dy = a.y - b.y;
+	return sqrt(dx * dx + dy * dy);
+}
+
+void LaserPathOptimizer::Setup(int maxPaths, int budgetMicros)
+{
+	this->budgetMicros = budgetMicros;
+	units.reserve(maxPaths);
+	tour.reserve(maxPaths);
+	staticOrder.reserve(maxPaths);
+	hasStaticOrder = false;
+}
+
+void LaserPathOptimizer::Optimize(const std::vector<LaserPathEnds>& paths, int count, ofVec2f beam, std::vector<LaserPathRef>& order)
+{
+	Clock::time_point start = Clock::now();
+	Clock::time_point deadline = start + std::chrono::microseconds(budgetMicros);
+
+	//Order the static block on its own first, unless it is the same as last time
+	uint64_t key = HashStatic(paths, count);
+	if (!hasStaticOrder || key != staticKey)
+	{
+		units.clear();
+		for (int i = 0; i < count; i++)
+		{
+			if (paths[i].isStatic)
+				units.push_back({ paths[i].start, paths[i].end, i, false });
+		}
+		staticOrderDone = OrderUnits(units.empty() ? beam : units[0].start, deadline);
+		staticOrder.clear();
+		for (const Unit& unit : units)
+		{
+			staticOrder.push_back({ unit.path, unit.reversed });
+		}
+		staticKey = key;
+		hasStaticOrder = true;
+	}
+	else if (!staticOrderDone)
+	{
+		//Carry on with 2-opt where the last frame's budget ran out
+		tour.clear();
+		for (const LaserPathRef& ref : staticOrder)
+		{
+			tour.push_back({ paths[ref.path].start, paths[ref.path].end, ref.path, ref.reversed });
+		}
+		//From where the first ordering started, the start of the first static path
+		int first = 0;
+		while (!paths[first].isStatic)
+		{
+			first++;
+		}
+		staticOrderDone = ImproveTour(paths[first].start, deadline);
+		staticOrder.clear();
+		for (const Unit& unit : tour)
+		{
+			staticOrder.push_back({ unit.path, unit.reversed });
+		}
+	}
+
+	units.clear();
+	if (!staticOrder.empty())
+	{
+		const LaserPathRef& first = staticOrder.front();
+		const LaserPathRef& last = staticOrder.back();
+		units.push_back({
+			first.reversed ? paths[first.path].end : paths[first.path].start,
+			last.reversed ? paths[last.path].start : paths[last.path].end,
+			-1, false });
+	}
+	for (int i = 0; i < count; i++)
+	{
+		if (!paths[i].isStatic)
+			units.push_back({ paths[i].start, paths[i].end, i, false });
+	}
+	OrderUnits(beam, deadline);
+
+	order.clear();
+	for (const Unit& unit : units)
+	{
+		if (unit.path >= 0)
+		{
+			order.push_back({ unit.path, unit.reversed });
+			continue;
+		}
+		//A reversed block is scanned back to front with every path flipped
+		int n = staticOrder.size();
+		for (int i = 0; i < n; i++)
+		{
+			const LaserPathRef& ref = staticOrder[unit.reversed ? n - 1 - i : i];
+			order.push_back({ ref.path, ref.reversed != unit.reversed });
+		}
+	}
+
+	lastMicros = (int)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+	lastBlankTravel = BlankTravel(paths, order, beam);
+}
+
+int LaserPathOptimizer::GetLastMicros()
+{
+	return lastMicros;
+}
+
+float LaserPathOptimizer::GetLastBlankTravel()
+{
+	return lastBlankTravel;
+}
+
+ofVec2f LaserPathOptimizer::UnitStart(const Unit& unit)
+{
+	return unit.reversed ? unit.end : unit.start;
+}
+
+ofVec2f LaserPathOptimizer::UnitEnd(const Unit& unit)
+{
+	return unit.reversed ? unit.start : unit.end;
+}
+
+float LaserPathOptimizer::BlankTravel(const std::vector<LaserPathEnds>& paths, const std::vector<LaserPathRef>& order, ofVec2f beam)
+{
+	float travel = 0.f;
+	for (const LaserPathRef& ref : order)
+	{
+		const LaserPathEnds& path = paths[ref.path];
+		travel += Distance(beam, ref.reversed ? path.end : path.start);
+		beam = ref.reversed ? path.start : path.end;
+	}
+	return travel;
+}
+
+bool LaserPathOptimizer::OrderUnits(ofVec2f beam, Clock::time_point deadline)
+{
+	if (units.empty())
+		return true;
+
+	//Greedy: always jump to the closest free end, entering the unit from that end
+	tour.clear();
+	ofVec2f position = beam;
+	while (!units.empty())
+	{
+		int best = 0;
+		bool bestReversed = false;
+		float bestDistance = FLT_MAX;
+		for (int i = 0; i < (int)units.size(); i++)
+		{
+			float toStart = Distance(position, units[i].start);
+			float toEnd = Distance(position, units[i].end);
+			if (toStart < bestDistance)
+			{
+				best = i;
+				bestReversed = false;
+				bestDistance = toStart;
+			}
+			if (toEnd < bestDistance)
+			{
+				best = i;
+				bestReversed = true;
+				bestDistance = toEnd;
+			}
+		}
+		Unit unit = units[best];
+		unit.reversed = bestReversed;
+		tour.push_back(unit);
+		position = UnitEnd(unit);
+		units[best] = units.back();
+		units.pop_back();
+	}
+
+	bool done = ImproveTour(beam, deadline);
+	std::swap(units, tour);
+	return done;
+}
+
+bool LaserPathOptimizer::ImproveTour(ofVec2f beam, Clock::time_point deadline)
+{
+	//2-opt: reversing a stretch of the tour also flips the direction of every unit in it.
+	//The tour is open, only the jumps into and out of the stretch change.
+	int n = tour.size();
+	bool improved = true;
+	bool finished = false;
+	while (improved && Clock::now() < deadline)
+	{
+		improved = false;
+		int i = 0;
+		for (; i < n && Clock::now() < deadline; i++)
+		{
+			ofVec2f before = i == 0 ? beam : UnitEnd(tour[i - 1]);
+			for (int j = i; j < n; j++)
+			{
+				ofVec2f a = UnitStart(tour[i]);
+				ofVec2f b = UnitEnd(tour[j]);
+				float current = Distance(before, a);
+				float swapped = Distance(before, b);
+				if (j + 1 < n)
+				{
+					ofVec2f after = UnitStart(tour[j + 1]);
+					current += Distance(b, after);
+					swapped += Distance(a, after);
+				}
+				if (swapped < current - 1e-3f)
+				{
+					std::reverse(tour.begin() + i, tour.begin() + j + 1);
+					for (int k = i; k <= j; k++)
+					{
+						tour[k].reversed = !tour[k].reversed;
+					}
+					improved = true;
+				}
+			}
+		}
+		//Only a whole pass without a move leaves nothing to improve
+		finished = !improved && i == n;
+	}
+	return finished;
+}
+
+uint64_t LaserPathOptimizer::HashStatic(const std::vector<LaserPathEnds>& paths, int count)
+{
+	//FNV-1a over the static ends relative to the first one, quantized to a quarter pixel,
+	//so a scrolling camera keeps the key
+	uint64_t hash = Fnv1aOffset64;
+	auto mix = [&hash](float value)
+	{
+		int32_t quantized = (int32_t)std::round(value * 4.f);
+		Fnv1a(hash, &quantized, sizeof(quantized));
+	};
+	bool hasOrigin = false;
+	ofVec2f origin;
+	for (int i = 0; i < count; i++)
+	{
+		if (!paths[i].isStatic)
+			continue;
+		if (!hasOrigin)
+		{
+			origin = paths[i].start;
+			hasOrigin = true;
+		}
+		mix((float)i);
+		mix(paths[i].start.x - origin.x);
+		mix(paths[i].start.y - origin.y);
+		mix(paths[i].end.x - origin.x);
+		mix(paths[i].end.y - origin.y);
+	}
+	return hash;
+}
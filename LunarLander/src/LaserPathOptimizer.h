@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "ofMain.h"
+
+//First and last point of a path, as it was added to the frame
+struct LaserPathEnds {
+	ofVec2f start;
+	ofVec2f end;
+	bool isStatic;	//Part of the geometry that rarely changes, e.g. the terrain
+};
+
+//A path in scan order, reversed paths are scanned from their end to their start
+struct LaserPathRef {
+	int path;
+	bool reversed;
+};
+
+//Orders the paths of a laser frame and picks their direction to keep the blanked beam travel short.
+//A greedy nearest neighbour pass builds the order, 2-opt moves improve it until the time budget runs out.
+//The static paths are ordered once, then moved around as one block as long as they stay the same; an order
+//the budget cut short is improved on the following frames until 2-opt finds nothing left to do.
+class LaserPathOptimizer
+{
+	typedef std::chrono::steady_clock Clock;
+
+	//Something the tour visits: a single dynamic path, or the whole block of static paths
+	struct Unit {
+		ofVec2f start;
+		ofVec2f end;
+		int path;	//-1 for the static block
+		bool reversed;
+	};
+
+	std::vector<Unit> units;
+	std::vector<Unit> tour;
+	std::vector<LaserPathRef> staticOrder;	//Cached order of the static block
+	uint64_t staticKey = 0;
+	bool hasStaticOrder = false;
+	bool staticOrderDone = false;	//2-opt ran out of moves, a partial order is improved further next frame
+
+	int budgetMicros = 200;
+	int lastMicros = 0;
+	float lastBlankTravel = 0.f;
+
+	//Both return false when the deadline cut 2-opt short
+	bool OrderUnits(ofVec2f beam, Clock::time_point deadline);
+	bool ImproveTour(ofVec2f beam, Clock::time_point deadline);
+	static ofVec2f UnitStart(const Unit& unit);
+	static ofVec2f UnitEnd(const Unit& unit);
+	static uint64_t HashStatic(const std::vector<LaserPathEnds>& paths, int count);
+
+public:
+
+	void Setup(int maxPaths, int budgetMicros);
+	void Optimize(const std::vector<LaserPathEnds>& paths, int count, ofVec2f beam, std::vector<LaserPathRef>& order);
+
+	int GetLastMicros();
+	float GetLastBlankTravel();
+
+	static float BlankTravel(const std::vector<LaserPathEnds>& paths, const std::vector<LaserPathRef>& order, ofVec2f beam);
+};
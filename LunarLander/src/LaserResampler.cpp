@@ -0,0 +1,129 @@
+#include "LaserResampler.h"
+#include "LaserFrameBuilder.h"
+#include "Simd.h"
+
+int LaserResampler::StepCount(ofVec2f a, ofVec2f b, float maxStep)
+{
+	float dx = b.x - a.x, dy = b.y - a.y;
+	return (int)ceil(sqrt(dx * dx + dy * dy) / maxStep);
+}
+
+int LaserResampler::EasedStepCount(ofVec2f a, ofVec2f b, float maxStep)
+{
+	//Smoothstep's slope peaks at 1.5 in the middle, no step of it is longer than 1.5 / steps of the jump
+	return StepCount(a, b, maxStep / 1.5f);
+}
+
+void LaserResampler::ResampleSegment(ofVec2f a, ofVec2f b, int steps, const ofColor& color, LaserPoint* out)
+{
+	if (steps <= 0)
+		return;
+	float dx = b.x - a.x, dy = b.y - a.y;
+	float inv = 1.f / steps;
+	int i = 0;
+#ifdef LUNAR_SSE2
+	//Four points per iteration, the positions are interleaved into the point structs afterwards
+	__m128 ax = _mm_set1_ps(a.x), ay = _mm_set1_ps(a.y);
+	__m128 vdx = _mm_set1_ps(dx * inv), vdy = _mm_set1_ps(dy * inv);
+	__m128 idx = _mm_setr_ps(1.f, 2.f, 3.f, 4.f);
+	const __m128 four = _mm_set1_ps(4.f);
+	alignas(16) float xs[4], ys[4];
+	for (; i + 4 <= steps; i += 4)
+	{
+		_mm_store_ps(xs, _mm_add_ps(ax, _mm_mul_ps(vdx, idx)));
+		_mm_store_ps(ys, _mm_add_ps(ay, _mm_mul_ps(vdy, idx)));
+		idx = _mm_add_ps(idx, four);
+		for (int k = 0; k < 4; k++)
+		{
+			out[i + k] = { xs[k], ys[k], color.r, color.g, color.b };
+		}
+	}
+#endif
+	for (; i < steps; i++)
+	{
+		float t = (i + 1) * inv;
+		out[i] = { a.x + dx * t, a.y + dy * t, color.r, color.g, color.b };
+	}
+	//Land exactly on the vertex, the next segment starts from it
+	out[steps - 1].x = b.x;
+	out[steps - 1].y = b.y;
+}
+
+void LaserResampler::EaseBlank(ofVec2f a, ofVec2f b, int steps, LaserPoint* out)
+{
+	if (steps <= 0)
+		return;
+	float dx = b.x - a.x, dy = b.y - a.y;
+	float inv = 1.f / steps;
+	int i = 0;
+#ifdef LUNAR_SSE2
+	//Smoothstep t*t*(3-2t): slow off the last point, fast in the middle, slow onto the next start
+	__m128 ax = _mm_set1_ps(a.x), ay = _mm_set1_ps(a.y);
+	__m128 vdx = _mm_set1_ps(dx), vdy = _mm_set1_ps(dy);
+	__m128 vinv = _mm_set1_ps(inv);
+	__m128 idx = _mm_setr_ps(1.f, 2.f, 3.f, 4.f);
+	const __m128 four = _mm_set1_ps(4.f), two = _mm_set1_ps(2.f), three = _mm_set1_ps(3.f);
+	alignas(16) float xs[4], ys[4];
+	for (; i + 4 <= steps; i += 4)
+	{
+		__m128 t = _mm_mul_ps(idx, vinv);
+		__m128 s = _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(three, _mm_mul_ps(two, t)));
+		_mm_store_ps(xs, _mm_add_ps(ax, _mm_mul_ps(vdx, s)));
+		_mm_store_ps(ys, _mm_add_ps(ay, _mm_mul_ps(vdy, s)));
+		idx = _mm_add_ps(idx, four);
+		for (int k = 0; k < 4; k++)
+		{
+			out[i + k] = { xs[k], ys[k], 0, 0, 0 };
+		}
+	}
+#endif
+	for (; i < steps; i++)
+	{
+		float t = (i + 1) * inv;
+		float s = t * t * (3.f - 2.f * t);
+		out[i] = { a.x + dx * s, a.y + dy * s, 0, 0, 0 };
+	}
+	out[steps - 1].x = b.x;
+	out[steps - 1].y = b.y;
+}
+
+int LaserResampler::CornerDwell(ofVec2f previous, ofVec2f corner, ofVec2f next, float cornerAngleRad, int maxDwell)
+{
+	float ax = corner.x - previous.x, ay = corner.y - previous.y;
+	float bx = next.x - corner.x, by = next.y - corner.y;
+	float lengths = sqrt((ax * ax + ay * ay) * (bx * bx + by * by));
+	if (lengths <= 0.f || maxDwell <= 0)
+		return 0;
+	//Turn angle between the incoming and outgoing direction, 0 for a straight line
+	float angle = acos(ofClamp((ax * bx + ay * by) / lengths, -1.f, 1.f));
+	if (angle < cornerAngleRad)
+		return 0;
+	float sharpness = (angle - cornerAngleRad) / std::max(PI - cornerAngleRad, 1e-3f);
+	return 1 + (int)round((maxDwell - 1) * sharpness);
+}
+
+float LaserResampler::MaxLitStep(const LaserPoint* points, int count)
+{
+	float maxStep = 0.f;
+	for (int i = 1; i < count; i++)
+	{
+		if (!(points[i].r | points[i].g | points[i].b))
+			continue;
+		float dx = points[i].x - points[i - 1].x, dy = points[i].y - points[i - 1].y;
+		maxStep = std::max(maxStep, dx * dx + dy * dy);
+	}
+	return sqrt(maxStep);
+}
+
+float LaserResampler::MaxBlankStep(const LaserPoint* points, int count)
+{
+	float maxStep = 0.f;
+	for (int i = 1; i < count; i++)
+	{
+		if (points[i].r | points[i].g | points[i].b)
+			continue;
+		float dx = points[i].x - points[i - 1].x, dy = points[i].y - points[i - 1].y;
+		maxStep = std::max(maxStep, dx * dx + dy * dy);
+	}
+	return sqrt(maxStep);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ofMain.h"
+
+struct LaserPoint;
+
+//Kernels that space laser points for the galvos: constant velocity along lit segments,
+//dwell on sharp corners and eased blank jumps. Stateless, so they can be checked without a frame.
+class LaserResampler
+{
+public:
+
+	//Points needed to cover a segment without any step longer than maxStep, 0 for a zero length segment
+	static int StepCount(ofVec2f a, ofVec2f b, float maxStep);
+	//The same for an eased blank jump, whose middle step is 1.5 times as long as the average one
+	static int EasedStepCount(ofVec2f a, ofVec2f b, float maxStep);
+	//Writes steps evenly spaced points from a (exclusive) to b (inclusive)
+	static void ResampleSegment(ofVec2f a, ofVec2f b, int steps, const ofColor& color, LaserPoint* out);
+	//Writes steps blanked points from a (exclusive) to b (inclusive), spaced to ease in and out of the jump
+	static void EaseBlank(ofVec2f a, ofVec2f b, int steps, LaserPoint* out);
+	//Extra points to hold on the middle vertex, growing from 1 at cornerAngleRad to maxDwell at a full turn back
+	static int CornerDwell(ofVec2f previous, ofVec2f corner, ofVec2f next, float cornerAngleRad, int maxDwell);
+
+	//Longest step onto a lit point, blank jumps are not drawn and may be longer
+	static float MaxLitStep(const LaserPoint* points, int count);
+	//Longest step onto a blanked point, the galvos have to follow those just the same
+	static float MaxBlankStep(const LaserPoint* points, int count);
+};
@@ -0,0 +1,62 @@
+#include "LatencyShim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static uint64_t NowMicros()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+LatencyShim::LatencyShim(InputTransport* transport, const LatencyShimParams& params, int capacity) : random(params.seed)
+{
+	this->transport = transport;
+	this->params = params;
+	held.resize(capacity);
+}
+
+void LatencyShim::Send(const uint8_t* data, int size)
+{
+	SendDue();
+	if (size <= 0 || size > RollbackProtocol::MaxDatagramSize || random.NextFloat() < params.loss)
+	{
+		stats.dropped++;
+		return;
+	}
+	auto slot = std::find_if(held.begin(), held.end(), [](const Held& packet) { return packet.size == 0; });
+	if (slot == held.end())
+	{
+		stats.dropped++;
+		return;
+	}
+	float delay = std::max(0.f, params.latencyMillis + (random.NextFloat() * 2.f - 1.f) * params.jitterMillis);
+	slot->dueMicros = NowMicros() + (uint64_t)(delay * 1000.f);
+	slot->size = size;
+	memcpy(slot->data, data, size);
+}
+
+int LatencyShim::Receive(uint8_t* data, int capacity)
+{
+	SendDue();
+	return transport->Receive(data, capacity);
+}
+
+LatencyShimStats LatencyShim::GetStats()
+{
+	return stats;
+}
+
+void LatencyShim::SendDue()
+{
+	uint64_t now = NowMicros();
+	for (Held& packet : held)
+	{
+		if (packet.size > 0 && packet.dueMicros <= now)
+		{
+			transport->Send(packet.data, packet.size);
+			packet.size = 0;
+			stats.sent++;
+		}
+	}
+}
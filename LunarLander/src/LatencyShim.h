@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include "InputTransport.h"
+#include "RollbackProtocol.h"
+#include "Random.h"
+
+struct LatencyShimParams {
+	float latencyMillis = 0.f;	//Added to every outgoing packet
+	float jitterMillis = 0.f;	//Up to this much more or less, so packets also arrive out of order
+	float loss = 0.f;	//Share of packets dropped
+	uint64_t seed = 1;
+};
+
+struct LatencyShimStats {
+	uint64_t sent = 0;
+	uint64_t dropped = 0;	//By the loss setting or because the queue was full
+};
+
+//Wraps a transport and holds back what is sent through it, for testing a rollback session against a bad
+//network on one machine. Held packets go out from whichever of Send and Receive is called next after
+//they are due.
+class LatencyShim : public InputTransport
+{
+	struct Held {
+		uint64_t dueMicros;
+		int size = 0;	//0 for a free slot
+		uint8_t data[RollbackProtocol::MaxDatagramSize];
+	};
+
+	InputTransport* transport;
+	LatencyShimParams params;
+	FastRandom random;
+	std::vector<Held> held;
+	LatencyShimStats stats;
+
+	void SendDue();
+
+public:
+
+	LatencyShim(InputTransport* transport, const LatencyShimParams& params, int capacity = 256);
+
+	void Send(const uint8_t* data, int size) override;
+	int Receive(uint8_t* data, int capacity) override;
+	LatencyShimStats GetStats();
+};
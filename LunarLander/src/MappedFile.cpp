@@ -0,0 +1,104 @@
+#include "MappedFile.h"
+
+#include "ofLog.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		ofLogError("MappedFile") << "Couldn't open " << path;
+		return false;
+	}
+	file = handle;
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(handle, &fileSize);
+	size = (size_t)fileSize.QuadPart;
+	if (size == 0)
+		return true;	//Windows refuses to map empty files
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping)
+		data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		ofLogError("MappedFile") << "Couldn't open " << path;
+		return false;
+	}
+	struct stat info;
+	fstat(file, &info);
+	size = (size_t)info.st_size;
+	if (size == 0)
+		return true;
+	void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	if (view != MAP_FAILED)
+	{
+		data = (const uint8_t*)view;
+		madvise(view, size, MADV_SEQUENTIAL);
+	}
+#endif
+	if (!data)
+	{
+		ofLogError("MappedFile") << "Couldn't map " << path;
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+	mapping = nullptr;
+	file = nullptr;
+#else
+	if (data)
+		munmap((void*)data, size);
+	if (file >= 0)
+		close(file);
+	file = -1;
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+bool MappedFile::IsOpen()
+{
+#ifdef _WIN32
+	return file != nullptr;
+#else
+	return file >= 0;
+#endif
+}
+
+const uint8_t* MappedFile::GetData()
+{
+	return data;
+}
+
+size_t MappedFile::GetSize()
+{
+	return size;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+//Read-only view of a whole file mapped into memory, pages are loaded by the OS as they are touched
+class MappedFile
+{
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* file = nullptr;	//HANDLEs, kept opaque so windows.h stays out of the header
+	void* mapping = nullptr;
+#else
+	int file = -1;
+#endif
+
+public:
+
+	MappedFile() {}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	bool Open(const std::string& path);
+	void Close();
+	bool IsOpen();
+	const uint8_t* GetData();
+	size_t GetSize();
+};
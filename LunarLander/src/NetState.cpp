@@ -0,0 +1,333 @@
+#include "NetState.h"
+
+#include <cmath>
+#include <cstring>
+
+static const float PositionScale = 1024.f;
+static const float AngleScale = 4096.f;
+static const float SizeScale = 16.f;
+static const float ThrustScale = 4096.f;
+static const float FuelScale = 256.f;
+
+static int32_t Quantize(float value, float scale)
+{
+	return (int32_t)std::lround(value * scale);
+}
+
+static void QuantizeBody(const BodySnapshot& body, NetEntity& entity)
+{
+	entity.values[NetBodyX] = Quantize(body.position.x, PositionScale);
+	entity.values[NetBodyY] = Quantize(body.position.y, PositionScale);
+	entity.values[NetBodyAngle] = Quantize(body.angle, AngleScale);
+	entity.values[NetBodyFlags] = body.active ? NetBodyActive : 0;
+}
+
+static void DequantizeBody(const NetEntity& entity, BodySnapshot& body)
+{
+	body.position.Set(entity.values[NetBodyX] / PositionScale, entity.values[NetBodyY] / PositionScale);
+	body.angle = entity.values[NetBodyAngle] / AngleScale;
+	body.linearVelocity.SetZero();
+	body.angularVelocity = 0.f;
+	body.awake = false;
+	body.active = (entity.values[NetBodyFlags] & NetBodyActive) != 0;
+}
+
+static void QuantizeDebris(const std::vector<DebrisSnapshot>& debris, std::vector<NetEntity>& entities)
+{
+	entities.resize(debris.size());
+	for (size_t i = 0; i < debris.size(); i++)
+	{
+		entities[i] = NetEntity();
+		QuantizeBody(debris[i].body, entities[i]);
+		entities[i].values[NetBodyWidth] = Quantize(debris[i].width, SizeScale);
+		entities[i].values[NetBodyHeight] = Quantize(debris[i].height, SizeScale);
+	}
+}
+
+static void DequantizeDebris(const std::vector<NetEntity>& entities, std::vector<DebrisSnapshot>& debris)
+{
+	debris.resize(entities.size());
+	for (size_t i = 0; i < entities.size(); i++)
+	{
+		DequantizeBody(entities[i], debris[i].body);
+		debris[i].width = entities[i].values[NetBodyWidth] / SizeScale;
+		debris[i].height = entities[i].values[NetBodyHeight] / SizeScale;
+	}
+}
+
+bool NetEntity::operator==(const NetEntity& other) const
+{
+	return memcmp(values, other.values, sizeof(values)) == 0;
+}
+
+void NetWorldState::Quantize(const SimulationSnapshot& snapshot, int arenaWidth, int arenaHeight)
+{
+	round = NetEntity();
+	round.values[NetRoundStep] = (int32_t)snapshot.stepCount;
+	round.values[NetRoundGameState] = snapshot.gameState;
+	round.values[NetRoundTerrainSeed] = (int32_t)snapshot.terrainSeed;
+	round.values[NetRoundTimeMillis] = ::Quantize(snapshot.simulationTime - snapshot.roundStartTime, 1000.f);
+	round.values[NetRoundFuel] = ::Quantize(snapshot.fuelUsed, FuelScale);
+	round.values[NetRoundArenaWidth] = arenaWidth;
+	round.values[NetRoundArenaHeight] = arenaHeight;
+
+	landers.resize(snapshot.landers.size());
+	for (size_t i = 0; i < snapshot.landers.size(); i++)
+	{
+		const LanderSnapshot& lander = snapshot.landers[i];
+		landers[i] = NetEntity();
+		QuantizeBody(lander.body, landers[i]);
+		landers[i].values[NetBodyThrust] = ::Quantize(lander.thrusterStrength, ThrustScale);
+		landers[i].values[NetBodyFlags] |= (lander.active ? NetLanderActive : 0) | (lander.crashed ? NetLanderCrashed : 0);
+	}
+	QuantizeDebris(snapshot.circles, circles);
+	QuantizeDebris(snapshot.boxes, boxes);
+}
+
+void NetWorldState::Dequantize(SimulationSnapshot& snapshot, float timeStep) const
+{
+	snapshot.valid = true;
+	snapshot.stepCount = (uint32_t)round.values[NetRoundStep];
+	snapshot.simulationTime = snapshot.stepCount * timeStep;
+	snapshot.roundStartTime = snapshot.simulationTime - round.values[NetRoundTimeMillis] / 1000.f;
+	snapshot.fuelUsed = round.values[NetRoundFuel] / FuelScale;
+	snapshot.landingTimer = snapshot.simulationTime;
+	snapshot.gameState = round.values[NetRoundGameState];
+	snapshot.terrainSeed = (uint32_t)round.values[NetRoundTerrainSeed];
+	//Spectators never start a round themselves
+	snapshot.nextTerrainSeed = snapshot.terrainSeed;
+
+	snapshot.landers.resize(landers.size());
+	for (size_t i = 0; i < landers.size(); i++)
+	{
+		LanderSnapshot& lander = snapshot.landers[i];
+		DequantizeBody(landers[i], lander.body);
+		lander.thrusterStrength = landers[i].values[NetBodyThrust] / ThrustScale;
+		lander.rotationRate = 0.f;
+		lander.active = (landers[i].values[NetBodyFlags] & NetLanderActive) != 0;
+		lander.crashed = (landers[i].values[NetBodyFlags] & NetLanderCrashed) != 0;
+	}
+	DequantizeDebris(circles, snapshot.circles);
+	DequantizeDebris(boxes, snapshot.boxes);
+}
+
+int NetWorldState::GetArenaWidth() const
+{
+	return round.values[NetRoundArenaWidth];
+}
+
+int NetWorldState::GetArenaHeight() const
+{
+	return round.values[NetRoundArenaHeight];
+}
+
+bool NetWorldState::operator==(const NetWorldState& other) const
+{
+	return round == other.round && landers == other.landers && circles == other.circles && boxes == other.boxes;
+}
+
+static void Write(uint8_t*& out, uint32_t value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+	{
+		*out++ = (uint8_t)(value >> (8 * i));
+	}
+}
+
+static uint32_t Read(const uint8_t*& in, int bytes)
+{
+	uint32_t value = 0;
+	for (int i = 0; i < bytes; i++)
+	{
+		value |= (uint32_t)*in++ << (8 * i);
+	}
+	return value;
+}
+
+static void WriteVarint(uint8_t*& out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		*out++ = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (uint8_t)value;
+}
+
+static bool ReadVarint(const uint8_t*& in, const uint8_t* end, uint32_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		if (in == end)
+			return false;
+		uint8_t byte = *in++;
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+//Small differences of either sign take few bytes
+static uint32_t ZigZag(int32_t value)
+{
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t UnZigZag(uint32_t value)
+{
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static const int MaxEntitySize = 1 + NetEntity::FieldCount * 5;
+
+static void EncodeEntity(const NetEntity& entity, const NetEntity& baseline, uint8_t*& out)
+{
+	uint8_t* mask = out++;
+	*mask = 0;
+	for (int i = 0; i < NetEntity::FieldCount; i++)
+	{
+		uint32_t delta = (uint32_t)entity.values[i] - (uint32_t)baseline.values[i];
+		if (delta == 0)
+			continue;
+		*mask |= 1 << i;
+		WriteVarint(out, ZigZag((int32_t)delta));
+	}
+}
+
+static bool DecodeEntity(const uint8_t*& in, const uint8_t* end, const NetEntity& baseline, NetEntity& entity)
+{
+	if (in == end)
+		return false;
+	uint8_t mask = *in++;
+	for (int i = 0; i < NetEntity::FieldCount; i++)
+	{
+		uint32_t delta = 0;
+		if ((mask & (1 << i)) && !ReadVarint(in, end, delta))
+			return false;
+		entity.values[i] = (int32_t)((uint32_t)baseline.values[i] + (uint32_t)UnZigZag(delta));
+	}
+	return true;
+}
+
+static bool EncodeList(const std::vector<NetEntity>& entities, const std::vector<NetEntity>* baseline, uint8_t*& out, const uint8_t* end)
+{
+	static const NetEntity none;
+	for (size_t i = 0; i < entities.size(); i++)
+	{
+		if (end - out < MaxEntitySize)
+			return false;
+		EncodeEntity(entities[i], baseline && i < baseline->size() ? (*baseline)[i] : none, out);
+	}
+	return true;
+}
+
+static bool DecodeList(const uint8_t*& in, const uint8_t* end, const std::vector<NetEntity>* baseline, std::vector<NetEntity>& entities)
+{
+	static const NetEntity none;
+	for (size_t i = 0; i < entities.size(); i++)
+	{
+		if (!DecodeEntity(in, end, baseline && i < baseline->size() ? (*baseline)[i] : none, entities[i]))
+			return false;
+	}
+	return true;
+}
+
+int NetStateCodec::Encode(const NetWorldState& state, const NetWorldState* baseline, uint8_t* out, int capacity)
+{
+	const uint8_t* end = out + capacity;
+	uint8_t* start = out;
+	if (capacity < StateHeaderSize + 3 * 5 + MaxEntitySize)
+		return 0;
+	if (state.landers.size() > MaxEntities || state.circles.size() > MaxEntities || state.boxes.size() > MaxEntities)
+		return 0;
+	Write(out, StateMagic, 4);
+	Write(out, state.sequence, 4);
+	Write(out, baseline ? baseline->sequence : 0, 4);
+	WriteVarint(out, state.landers.size());
+	WriteVarint(out, state.circles.size());
+	WriteVarint(out, state.boxes.size());
+	static const NetEntity none;
+	EncodeEntity(state.round, baseline ? baseline->round : none, out);
+	if (!EncodeList(state.landers, baseline ? &baseline->landers : nullptr, out, end)
+		|| !EncodeList(state.circles, baseline ? &baseline->circles : nullptr, out, end)
+		|| !EncodeList(state.boxes, baseline ? &baseline->boxes : nullptr, out, end))
+		return 0;
+	return out - start;
+}
+
+bool NetStateCodec::ReadHeader(const uint8_t* in, int size, uint32_t& sequence, uint32_t& baseline)
+{
+	if (size < StateHeaderSize || Read(in, 4) != StateMagic)
+		return false;
+	sequence = Read(in, 4);
+	baseline = Read(in, 4);
+	return true;
+}
+
+bool NetStateCodec::Decode(const uint8_t* in, int size, const NetWorldState* baseline, NetWorldState& state)
+{
+	const uint8_t* end = in + size;
+	uint32_t sequence, baselineSequence;
+	if (!ReadHeader(in, size, sequence, baselineSequence))
+		return false;
+	if ((baselineSequence != 0) != (baseline != nullptr) || (baseline && baseline->sequence != baselineSequence))
+		return false;
+	in += StateHeaderSize;
+	uint32_t landerCount, circleCount, boxCount;
+	if (!ReadVarint(in, end, landerCount) || !ReadVarint(in, end, circleCount) || !ReadVarint(in, end, boxCount))
+		return false;
+	if (landerCount > MaxEntities || circleCount > MaxEntities || boxCount > MaxEntities)
+		return false;
+	state.sequence = sequence;
+	state.landers.resize(landerCount);
+	state.circles.resize(circleCount);
+	state.boxes.resize(boxCount);
+	static const NetEntity none;
+	return DecodeEntity(in, end, baseline ? baseline->round : none, state.round)
+		&& DecodeList(in, end, baseline ? &baseline->landers : nullptr, state.landers)
+		&& DecodeList(in, end, baseline ? &baseline->circles : nullptr, state.circles)
+		&& DecodeList(in, end, baseline ? &baseline->boxes : nullptr, state.boxes);
+}
+
+int NetStateCodec::EncodeFragment(uint32_t sequence, int index, int count, const uint8_t* data, int length, uint8_t* out)
+{
+	Write(out, FragmentMagic, 4);
+	Write(out, sequence, 4);
+	Write(out, index, 1);
+	Write(out, count, 1);
+	memcpy(out, data, length);
+	return FragmentHeaderSize + length;
+}
+
+bool NetStateCodec::DecodeFragment(const uint8_t* in, int size, uint32_t& sequence, int& index, int& count, const uint8_t*& data, int& length)
+{
+	if (size < FragmentHeaderSize || Read(in, 4) != FragmentMagic)
+		return false;
+	sequence = Read(in, 4);
+	index = Read(in, 1);
+	count = Read(in, 1);
+	data = in;
+	length = size - FragmentHeaderSize;
+	if (count == 0 || count > MaxFragments || index >= count || length == 0 || length > FragmentBytes)
+		return false;
+	return index == count - 1 || length == FragmentBytes;
+}
+
+int NetStateCodec::EncodeAck(uint16_t port, uint32_t sequence, uint8_t* out)
+{
+	Write(out, AckMagic, 4);
+	Write(out, port, 2);
+	Write(out, sequence, 4);
+	return AckSize;
+}
+
+bool NetStateCodec::DecodeAck(const uint8_t* in, int size, uint16_t& port, uint32_t& sequence)
+{
+	if (size < AckSize || Read(in, 4) != AckMagic)
+		return false;
+	port = (uint16_t)Read(in, 2);
+	sequence = Read(in, 4);
+	return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "SimulationSnapshot.h"
+
+//One body, or the round itself, as a few integers; a field a client already has costs a bit in the mask
+struct NetEntity {
+	static const int FieldCount = 8;
+
+	int32_t values[FieldCount] = {};
+
+	bool operator==(const NetEntity& other) const;
+};
+
+enum NetRoundField {
+	NetRoundStep,
+	NetRoundGameState,
+	NetRoundTerrainSeed,
+	NetRoundTimeMillis,	//Since the round started
+	NetRoundFuel,
+	NetRoundArenaWidth,
+	NetRoundArenaHeight,
+};
+
+enum NetBodyField {
+	NetBodyX,
+	NetBodyY,
+	NetBodyAngle,
+	NetBodyWidth,	//Radius of a circle, unused for landers
+	NetBodyHeight,
+	NetBodyThrust,	//Landers only
+	NetBodyFlags,
+};
+
+enum NetBodyFlags {
+	NetBodyActive = 1,	//The Box2D body takes part in the world
+	NetLanderActive = 2,
+	NetLanderCrashed = 4,
+};
+
+//The world as spectators get it: positions in 1/1024 m, angles in 1/4096 rad, sizes in 1/16 px. The
+//terrain is only its seed, clients generate it themselves.
+struct NetWorldState {
+	uint32_t sequence = 0;	//Counts up from 1 per broadcast state, 0 for none
+	NetEntity round;
+	std::vector<NetEntity> landers;
+	std::vector<NetEntity> circles;
+	std::vector<NetEntity> boxes;
+
+	void Quantize(const SimulationSnapshot& snapshot, int arenaWidth, int arenaHeight);
+	//Bodies come back asleep, spectators only draw them
+	void Dequantize(SimulationSnapshot& snapshot, float timeStep) const;
+	int GetArenaWidth() const;
+	int GetArenaHeight() const;
+	//Same world, the sequence isn't compared
+	bool operator==(const NetWorldState& other) const;
+};
+
+//Wire format of the state broadcast, little endian. A state packet carries each entity as a mask of the
+//fields that differ from the baseline state the client acknowledged, followed by the zigzag varint
+//differences; entities past the end of a baseline list are coded against zero, a state without baseline
+//against nothing at all. Clients acknowledge the newest state they have, which also keeps them registered.
+//A coded state travels in fragments small enough that IP never splits them; a client decodes it once every
+//fragment arrived, and a state that lost one is simply replaced by the next.
+class NetStateCodec
+{
+public:
+
+	static const uint32_t StateMagic = 0x534E444C;	//"LNDS"
+	static const uint32_t AckMagic = 0x414E444C;	//"LNDA"
+	static const uint32_t FragmentMagic = 0x464E444C;	//"LNDF"
+	static const int StateHeaderSize = 4 + 4 + 4;
+	static const int AckSize = 4 + 2 + 4;
+	static const int MaxEntities = 1024;	//Per list
+	static const int MaxStateSize = StateHeaderSize + 3 * 5 + (1 + 3 * MaxEntities) * (1 + NetEntity::FieldCount * 5);
+	static const int FragmentHeaderSize = 4 + 4 + 1 + 1;
+	static const int FragmentBytes = 1200;	//State bytes per fragment, under any common MTU with the headers
+	static const int MaxFragments = (MaxStateSize + FragmentBytes - 1) / FragmentBytes;
+	static const int MaxPacketSize = FragmentHeaderSize + FragmentBytes;
+
+	//Codes state against baseline, in full when baseline is nullptr; 0 when it doesn't fit into capacity
+	static int Encode(const NetWorldState& state, const NetWorldState* baseline, uint8_t* out, int capacity);
+	//The baseline a packet needs, 0 for a full state
+	static bool ReadHeader(const uint8_t* in, int size, uint32_t& sequence, uint32_t& baseline);
+	static bool Decode(const uint8_t* in, int size, const NetWorldState* baseline, NetWorldState& state);
+
+	//Fragment index of count of the coded state sequence; every fragment but the last is FragmentBytes long
+	static int EncodeFragment(uint32_t sequence, int index, int count, const uint8_t* data, int length, uint8_t* out);
+	//data points into the packet
+	static bool DecodeFragment(const uint8_t* in, int size, uint32_t& sequence, int& index, int& count, const uint8_t*& data, int& length);
+
+	//port is where the client receives states
+	static int EncodeAck(uint16_t port, uint32_t sequence, uint8_t* out);
+	static bool DecodeAck(const uint8_t* in, int size, uint16_t& port, uint32_t& sequence);
+};
@@ -0,0 +1,191 @@
+#include "NetworkLaserOutput.h"
+
+#include <cstring>
+
+NetworkLaserOutput::NetworkLaserOutput() : ring(1)
+{
+}
+
+NetworkLaserOutput::~NetworkLaserOutput()
+{
+	Stop();
+}
+
+void NetworkLaserOutput::Setup(const NetworkLaserOutputParams& params)
+{
+	Stop();
+	this->params = params;
+	ring.Reset(params.ringCapacity);
+	chunk.resize(LaserDacProtocol::MaxPointsPerPacket);
+	packet.resize(LaserDacProtocol::HeaderSize + LaserDacProtocol::MaxPointsPerPacket * LaserDacProtocol::PointSize);
+	received.resize(LaserDacProtocol::StatusSize * 16);
+	inFlight.resize(MaxInFlight);
+	running = true;
+	thread = std::thread(&NetworkLaserOutput::Sender, this);
+}
+
+void NetworkLaserOutput::Stop()
+{
+	if (!thread.joinable())
+		return;
+	running = false;
+	thread.join();
+	client.close();
+	connected = false;
+}
+
+NetworkLaserOutputStats NetworkLaserOutput::GetStats()
+{
+	NetworkLaserOutputStats stats;
+	stats.connected = connected;
+	stats.framesSubmitted = framesSubmitted;
+	stats.framesDropped = framesDropped;
+	stats.pointsSent = pointsSent;
+	stats.dacFullness = dacFullness;
+	stats.dacUnderruns = dacUnderruns;
+	stats.roundTripMicros = roundTripMicros;
+	return stats;
+}
+
+void NetworkLaserOutput::ParseAddress(const std::string& address, NetworkLaserOutputParams& params)
+{
+	auto hostPort = ofSplitString(address, ":");
+	params.host = hostPort[0];
+	if (hostPort.size() > 1)
+		params.port = ofToInt(hostPort[1]);
+}
+
+bool NetworkLaserOutput::IsReady()
+{
+	//Keep at most one frame queued ahead of the sender, anything more only adds latency
+	return running && ring.Size() <= (size_t)lastFrameSize;
+}
+
+bool NetworkLaserOutput::SubmitFrame(const LaserPoint* points, int count, int pointsPerSecond)
+{
+	framesSubmitted++;
+	this->pointsPerSecond = pointsPerSecond;
+	lastFrameSize = count;
+	if (!ring.Push(points, count))
+	{
+		framesDropped++;
+		return false;
+	}
+	return true;
+}
+
+void NetworkLaserOutput::Sender()
+{
+	uint64_t lastAttempt = 0;
+	while (running)
+	{
+		uint64_t now = LaserDacProtocol::NowMicros();
+		if (!client.isConnected())
+		{
+			connected = false;
+			if (now - lastAttempt >= (uint64_t)params.reconnectMillis * 1000)
+			{
+				lastAttempt = now;
+				if (client.setup(params.host, params.port, false))
+				{
+					hasStatus = false;
+					receivedCount = 0;
+					inFlightCount = 0;
+					pointsInFlight = 0;
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
+		}
+		connected = true;
+		ReadStatus();
+
+		//Until the DAC reported its buffer, send one packet to make it answer
+		int room;
+		if (!hasStatus)
+			room = inFlightCount == 0 ? LaserDacProtocol::MaxPointsPerPacket : 0;
+		else if (inFlightCount == MaxInFlight)
+			room = 0;
+		else
+		{
+			//The DAC kept playing since its last report
+			int64_t played = (int64_t)(now - statusTime) * pointsPerSecond / 1000000;
+			int64_t estimated = std::max<int64_t>(0, (int64_t)status.bufferFullness + pointsInFlight - played);
+			room = (int)(status.bufferCapacity * params.targetFill - estimated);
+		}
+
+		int count = 0;
+		if (room > 0)
+			count = (int)ring.Pop(chunk.data(), std::min(room, LaserDacProtocol::MaxPointsPerPacket));
+		if (count > 0)
+			SendChunk(count);
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void NetworkLaserOutput::ReadStatus()
+{
+	int bytes = client.receiveRawBytes((char*)received.data() + receivedCount, received.size() - receivedCount);
+	if (bytes <= 0)
+		return;
+	receivedCount += bytes;
+
+	//Only the newest complete status matters
+	int complete = receivedCount / LaserDacProtocol::StatusSize;
+	if (complete == 0)
+		return;
+	LaserDacStatus latest;
+	if (LaserDacProtocol::DecodeStatus(received.data() + (complete - 1) * LaserDacProtocol::StatusSize, latest))
+	{
+		status = latest;
+		hasStatus = true;
+		statusTime = LaserDacProtocol::NowMicros();
+		//The status counts every packet up to the one it echoes, the ones sent after it are still on the way
+		while (inFlightCount > 0 && inFlight[inFlightStart].sendTimeMicros <= status.echoSendTimeMicros)
+		{
+			pointsInFlight -= inFlight[inFlightStart].points;
+			inFlightStart = (inFlightStart + 1) % MaxInFlight;
+			inFlightCount--;
+		}
+		dacFullness = status.bufferFullness;
+		dacUnderruns = status.underruns;
+		roundTripMicros = (int)(statusTime - status.echoSendTimeMicros);
+	}
+	else
+		ofLogWarning("NetworkLaserOutput") << "Bad status from the DAC";
+	int rest = receivedCount - complete * LaserDacProtocol::StatusSize;
+	memmove(received.data(), received.data() + complete * LaserDacProtocol::StatusSize, rest);
+	receivedCount = rest;
+}
+
+void NetworkLaserOutput::SendChunk(int count)
+{
+	LaserDacHeader header;
+	header.pointsPerSecond = pointsPerSecond;
+	header.pointCount = count;
+	header.sendTimeMicros = LaserDacProtocol::NowMicros();
+	LaserDacProtocol::EncodeHeader(packet.data(), header);
+
+	LaserScreenMapping mapping;
+	mapping.width = params.screenWidth;
+	mapping.height = params.screenHeight;
+	uint8_t* out = packet.data() + LaserDacProtocol::HeaderSize;
+	for (int i = 0; i < count; i++)
+	{
+		const LaserPoint& p = chunk[i];
+		int16_t x, y;
+		mapping.ToDevice(p, x, y);
+		LaserDacProtocol::EncodePoint(out, x, y, p.r, p.g, p.b);
+		out += LaserDacProtocol::PointSize;
+	}
+
+	//Blocking the sender thread on the socket is fine, the game thread never waits for it
+	if (client.sendRawBytes((const char*)packet.data(), LaserDacProtocol::HeaderSize + count * LaserDacProtocol::PointSize))
+	{
+		inFlight[(inFlightStart + inFlightCount) % MaxInFlight] = { header.sendTimeMicros, count };
+		inFlightCount++;
+		pointsInFlight += count;
+		pointsSent += count;
+	}
+}
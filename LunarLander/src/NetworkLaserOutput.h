@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include "ofxNetwork.h"
+#include "LaserOutput.h"
+#include "LaserDacProtocol.h"
+#include "SpscRing.h"
+
+struct NetworkLaserOutputParams {
+	std::string host = "127.0.0.1";
+	int port = LaserDacProtocol::DefaultPort;
+	int screenWidth = 1024;	//Screen area mapped onto the full DAC range
+	int screenHeight = 768;
+	int ringCapacity = 8192;	//Points queued between the game thread and the sender
+	float targetFill = .5f;	//Fraction of the DAC buffer kept queued, more is smoother but later
+	int reconnectMillis = 1000;
+};
+
+struct NetworkLaserOutputStats {
+	bool connected = false;
+	uint64_t framesSubmitted = 0;
+	uint64_t framesDropped = 0;	//No room in the ring
+	uint64_t pointsSent = 0;
+	uint32_t dacFullness = 0;	//Last reported by the DAC
+	uint32_t dacUnderruns = 0;
+	int roundTripMicros = 0;	//Packet sent to status received
+};
+
+//Streams frames to a network DAC over TCP. The game thread only pushes points into a lock-free ring;
+//a sender thread owns the socket and sends as much as the DAC's buffer reports leave room for.
+class NetworkLaserOutput : public LaserOutput
+{
+	struct SentPacket {
+		uint64_t sendTimeMicros;
+		int points;
+	};
+
+	static const int MaxInFlight = 256;	//Packets the DAC hasn't reported yet, the sender waits beyond that
+
+	NetworkLaserOutputParams params;
+	SpscRing<LaserPoint> ring;
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	std::atomic<int> pointsPerSecond{ 30000 };
+	std::atomic<int> lastFrameSize{ 0 };
+
+	std::atomic<bool> connected{ false };
+	std::atomic<uint64_t> framesSubmitted{ 0 };
+	std::atomic<uint64_t> framesDropped{ 0 };
+	std::atomic<uint64_t> pointsSent{ 0 };
+	std::atomic<uint32_t> dacFullness{ 0 };
+	std::atomic<uint32_t> dacUnderruns{ 0 };
+	std::atomic<int> roundTripMicros{ 0 };
+
+	//Only touched by the sender thread
+	ofxTCPClient client;
+	std::vector<LaserPoint> chunk;
+	std::vector<uint8_t> packet;
+	std::vector<uint8_t> received;
+	int receivedCount = 0;
+	LaserDacStatus status;
+	bool hasStatus = false;
+	uint64_t statusTime = 0;
+	//Packets sent after the one the last status echoes, oldest first, which that status doesn't count yet
+	std::vector<SentPacket> inFlight;
+	int inFlightStart = 0;
+	int inFlightCount = 0;
+	uint32_t pointsInFlight = 0;
+
+	void Sender();
+	void ReadStatus();
+	void SendChunk(int count);
+
+public:
+
+	NetworkLaserOutput();
+	~NetworkLaserOutput();
+
+	void Setup(const NetworkLaserOutputParams& params);
+	void Stop();
+	NetworkLaserOutputStats GetStats();
+
+	//Fills host and port from "host[:port]"
+	static void ParseAddress(const std::string& address, NetworkLaserOutputParams& params);
+
+	bool IsReady() override;
+	bool SubmitFrame(const LaserPoint* points, int count, int pointsPerSecond) override;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+//Small seedable PRNG (xorshift64*), owned per instance so worlds on different threads never share state
+class FastRandom
+{
+	uint64_t state;
+
+public:
+
+	FastRandom(uint64_t seed = 1)
+	{
+		Seed(seed);
+	}
+
+	void Seed(uint64_t seed)
+	{
+		//splitmix64 scramble so neighbouring seeds give unrelated streams and the state is never zero
+		uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		state = (z ^ (z >> 31)) | 1ull;
+	}
+
+	uint32_t Next()
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (uint32_t)((state * 0x2545F4914F6CDD1Dull) >> 32);
+	}
+
+	//Uniform float in [0, 1)
+	float NextFloat()
+	{
+		return (Next() >> 8) * (1.f / 16777216.f);
+	}
+
+	//Uniform float in [min, max)
+	float Range(float min, float max)
+	{
+		return min + (max - min) * NextFloat();
+	}
+
+	//Uniform int in [0, max), 0 for an empty range
+	int Range(int max)
+	{
+		return max > 0 ? (int)(Next() % (uint32_t)max) : 0;
+	}
+};
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "Simulation.h"
+#include "SimulationSnapshot.h"
+
+enum NetInputFlags : uint8_t {
+	NetStartRound = 1,	//Starts a round on every peer at this tick
+};
+
+//What one player does in one tick
+struct NetInput {
+	LanderControls controls;
+	uint8_t flags = 0;
+};
+
+//Inputs of one player for consecutive ticks, plus the hash the sender's world had after the newest
+//tick it knows every player's input for, to catch peers that diverged
+struct InputPacket {
+	static const int MaxInputs = 16;
+
+	uint8_t player = 0;
+	uint8_t count = 0;
+	uint32_t firstTick = 0;
+	uint32_t syncTick = 0;
+	uint32_t syncHash = 0;
+	NetInput inputs[MaxInputs];
+};
+
+//Part of a snapshot the first player sends when a peer's hashes differ from its own, so the peer can take
+//over its world. A snapshot takes a few chunks; one that doesn't arrive whole is sent again later.
+struct ResyncChunk {
+	static const int MaxBytes = 1024;
+	static const int MaxChunks = 64;
+
+	uint8_t player = 0;
+	uint32_t tick = 0;	//Of the snapshot, one whose every earlier input is known
+	uint32_t size = 0;	//Of the whole encoded snapshot
+	uint8_t index = 0;
+	uint8_t count = 0;
+	uint16_t length = 0;
+	const uint8_t* data = nullptr;	//Points into the packet
+};
+
+//Wire format of InputPacket over UDP, little endian throughout. Every packet repeats the sender's
+//last MaxInputs inputs, so a lost packet is covered by the next one and nothing is ever resent.
+//Snapshots go in ResyncChunks, floats as their bits so the receiver restores the very same world.
+class RollbackProtocol
+{
+	static void Write(uint8_t*& out, uint32_t value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++)
+		{
+			*out++ = (uint8_t)(value >> (8 * i));
+		}
+	}
+
+	static uint32_t Read(const uint8_t*& in, int bytes)
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < bytes; i++)
+		{
+			value |= (uint32_t)*in++ << (8 * i);
+		}
+		return value;
+	}
+
+	static void WriteFloat(uint8_t*& out, float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, 4);
+		Write(out, bits, 4);
+	}
+
+	static float ReadFloat(const uint8_t*& in)
+	{
+		uint32_t bits = Read(in, 4);
+		float value;
+		memcpy(&value, &bits, 4);
+		return value;
+	}
+
+	static void WriteBody(uint8_t*& out, const BodySnapshot& body)
+	{
+		float values[6] = { body.position.x, body.position.y, body.angle, body.linearVelocity.x, body.linearVelocity.y, body.angularVelocity };
+		for (float value : values)
+		{
+			WriteFloat(out, value);
+		}
+		Write(out, (body.awake ? 1 : 0) | (body.active ? 2 : 0), 1);
+	}
+
+	static void ReadBody(const uint8_t*& in, BodySnapshot& body)
+	{
+		body.position.x = ReadFloat(in);
+		body.position.y = ReadFloat(in);
+		body.angle = ReadFloat(in);
+		body.linearVelocity.x = ReadFloat(in);
+		body.linearVelocity.y = ReadFloat(in);
+		body.angularVelocity = ReadFloat(in);
+		uint32_t flags = Read(in, 1);
+		body.awake = (flags & 1) != 0;
+		body.active = (flags & 2) != 0;
+	}
+
+	static void WriteDebris(uint8_t*& out, const std::vector<DebrisSnapshot>& debris)
+	{
+		Write(out, (uint32_t)debris.size(), 2);
+		for (const DebrisSnapshot& shape : debris)
+		{
+			WriteBody(out, shape.body);
+			WriteFloat(out, shape.width);
+			WriteFloat(out, shape.height);
+		}
+	}
+
+	static bool ReadDebris(const uint8_t*& in, const uint8_t* end, std::vector<DebrisSnapshot>& debris)
+	{
+		if (end - in < 2)
+			return false;
+		uint32_t count = Read(in, 2);
+		if (end - in < (ptrdiff_t)(count * DebrisSize))
+			return false;
+		debris.resize(count);
+		for (DebrisSnapshot& shape : debris)
+		{
+			ReadBody(in, shape.body);
+			shape.width = ReadFloat(in);
+			shape.height = ReadFloat(in);
+		}
+		return true;
+	}
+
+public:
+
+	static const uint32_t Magic = 0x4E444E4C;	//"LNDN"
+	static const int HeaderSize = 4 + 1 + 1 + 4 + 4 + 4;
+	static const int InputSize = 4 + 4 + 1;
+	static const int MaxPacketSize = HeaderSize + InputPacket::MaxInputs * InputSize;
+
+	static const uint32_t ResyncMagic = 0x594E444C;	//"LNDY"
+	static const int ResyncHeaderSize = 4 + 1 + 4 + 4 + 1 + 1 + 2;
+	static const int MaxResyncPacketSize = ResyncHeaderSize + ResyncChunk::MaxBytes;
+	static const int MaxDatagramSize = MaxResyncPacketSize;	//Of either kind of packet
+	static const int MaxSnapshotSize = ResyncChunk::MaxBytes * ResyncChunk::MaxChunks;
+	static const int BodySize = 6 * 4 + 1;
+	static const int LanderSize = BodySize + 4 + 4 + 1;
+	static const int DebrisSize = BodySize + 4 + 4;
+	static const int SnapshotHeaderSize = 8 + 4 * 4 + 1 + 4 + 4 + 1;
+
+	static int Encode(const InputPacket& packet, uint8_t* out)
+	{
+		uint8_t* start = out;
+		Write(out, Magic, 4);
+		Write(out, packet.player, 1);
+		Write(out, packet.count, 1);
+		Write(out, packet.firstTick, 4);
+		Write(out, packet.syncTick, 4);
+		Write(out, packet.syncHash, 4);
+		for (int i = 0; i < packet.count; i++)
+		{
+			WriteFloat(out, packet.inputs[i].controls.thrustDelta);
+			WriteFloat(out, packet.inputs[i].controls.rotationRate);
+			Write(out, packet.inputs[i].flags, 1);
+		}
+		return out - start;
+	}
+
+	static bool Decode(const uint8_t* in, int size, InputPacket& packet)
+	{
+		if (size < HeaderSize || Read(in, 4) != Magic)
+			return false;
+		packet.player = (uint8_t)Read(in, 1);
+		packet.count = (uint8_t)Read(in, 1);
+		packet.firstTick = Read(in, 4);
+		packet.syncTick = Read(in, 4);
+		packet.syncHash = Read(in, 4);
+		if (packet.count > InputPacket::MaxInputs || size < HeaderSize + packet.count * InputSize)
+			return false;
+		for (int i = 0; i < packet.count; i++)
+		{
+			packet.inputs[i].controls.thrustDelta = ReadFloat(in);
+			packet.inputs[i].controls.rotationRate = ReadFloat(in);
+			packet.inputs[i].flags = (uint8_t)Read(in, 1);
+		}
+		return true;
+	}
+
+	static int EncodeResync(const ResyncChunk& chunk, uint8_t* out)
+	{
+		uint8_t* start = out;
+		Write(out, ResyncMagic, 4);
+		Write(out, chunk.player, 1);
+		Write(out, chunk.tick, 4);
+		Write(out, chunk.size, 4);
+		Write(out, chunk.index, 1);
+		Write(out, chunk.count, 1);
+		Write(out, chunk.length, 2);
+		memcpy(out, chunk.data, chunk.length);
+		return (int)(out + chunk.length - start);
+	}
+
+	static bool DecodeResync(const uint8_t* in, int size, ResyncChunk& chunk)
+	{
+		if (size < ResyncHeaderSize || Read(in, 4) != ResyncMagic)
+			return false;
+		chunk.player = (uint8_t)Read(in, 1);
+		chunk.tick = Read(in, 4);
+		chunk.size = Read(in, 4);
+		chunk.index = (uint8_t)Read(in, 1);
+		chunk.count = (uint8_t)Read(in, 1);
+		chunk.length = (uint16_t)Read(in, 2);
+		chunk.data = in;
+		//Every chunk but the last is full
+		if (chunk.size == 0 || chunk.size > (uint32_t)MaxSnapshotSize || chunk.index >= chunk.count
+			|| chunk.count != (chunk.size + ResyncChunk::MaxBytes - 1) / ResyncChunk::MaxBytes)
+			return false;
+		uint32_t offset = (uint32_t)chunk.index * ResyncChunk::MaxBytes;
+		return chunk.length == std::min(chunk.size - offset, (uint32_t)ResyncChunk::MaxBytes) && size >= ResyncHeaderSize + chunk.length;
+	}
+
+	//Returns the size written, 0 when the snapshot doesn't fit
+	static int EncodeSnapshot(const SimulationSnapshot& snapshot, uint8_t* out, int capacity)
+	{
+		int size = SnapshotHeaderSize + (int)snapshot.landers.size() * LanderSize + 4 + (int)(snapshot.circles.size() + snapshot.boxes.size()) * DebrisSize;
+		if (size > capacity || snapshot.landers.size() > 0xFF || snapshot.circles.size() > 0xFFFF || snapshot.boxes.size() > 0xFFFF)
+			return 0;
+		Write(out, (uint32_t)snapshot.stepCount, 4);
+		Write(out, (uint32_t)(snapshot.stepCount >> 32), 4);
+		WriteFloat(out, snapshot.simulationTime);
+		WriteFloat(out, snapshot.roundStartTime);
+		WriteFloat(out, snapshot.fuelUsed);
+		WriteFloat(out, snapshot.landingTimer);
+		Write(out, (uint32_t)snapshot.gameState, 1);
+		Write(out, snapshot.terrainSeed, 4);
+		Write(out, snapshot.nextTerrainSeed, 4);
+		Write(out, (uint32_t)snapshot.landers.size(), 1);
+		for (const LanderSnapshot& lander : snapshot.landers)
+		{
+			WriteBody(out, lander.body);
+			WriteFloat(out, lander.thrusterStrength);
+			WriteFloat(out, lander.rotationRate);
+			Write(out, (lander.active ? 1 : 0) | (lander.crashed ? 2 : 0), 1);
+		}
+		WriteDebris(out, snapshot.circles);
+		WriteDebris(out, snapshot.boxes);
+		return size;
+	}
+
+	//Into the snapshot's storage, which only grows when it holds less debris than the encoded one
+	static bool DecodeSnapshot(const uint8_t* in, int size, SimulationSnapshot& snapshot)
+	{
+		const uint8_t* end = in + size;
+		if (size < SnapshotHeaderSize)
+			return false;
+		snapshot.stepCount = Read(in, 4);
+		snapshot.stepCount |= (uint64_t)Read(in, 4) << 32;
+		snapshot.simulationTime = ReadFloat(in);
+		snapshot.roundStartTime = ReadFloat(in);
+		snapshot.fuelUsed = ReadFloat(in);
+		snapshot.landingTimer = ReadFloat(in);
+		snapshot.gameState = (int)Read(in, 1);
+		snapshot.terrainSeed = Read(in, 4);
+		snapshot.nextTerrainSeed = Read(in, 4);
+		uint32_t landerCount = Read(in, 1);
+		if (end - in < (ptrdiff_t)(landerCount * LanderSize))
+			return false;
+		snapshot.landers.resize(landerCount);
+		for (LanderSnapshot& lander : snapshot.landers)
+		{
+			ReadBody(in, lander.body);
+			lander.thrusterStrength = ReadFloat(in);
+			lander.rotationRate = ReadFloat(in);
+			uint32_t flags = Read(in, 1);
+			lander.active = (flags & 1) != 0;
+			lander.crashed = (flags & 2) != 0;
+		}
+		if (!ReadDebris(in, end, snapshot.circles) || !ReadDebris(in, end, snapshot.boxes))
+			return false;
+		snapshot.valid = true;
+		return true;
+	}
+};
@@ -0,0 +1,398 @@
+#include "RollbackSession.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+void RollbackSession::Setup(Simulation* simulation, InputTransport* transport, const RollbackParams& params)
+{
+	this->simulation = simulation;
+	this->transport = transport;
+	this->params = params;
+	//Inputs of every tick that can still be rolled back have to stay in the history
+	this->params.maxRollbackTicks = std::min(std::max(params.maxRollbackTicks, 1), HistoryTicks / 4);
+	snapshots.Setup(this->params.maxRollbackTicks + 1, 64, params.playerCount);
+	snapshotTicks.assign(this->params.maxRollbackTicks + 1, UINT32_MAX);
+	players.assign(params.playerCount, Player());
+	controls.resize(params.playerCount);
+	std::fill(syncHashTicks, syncHashTicks + HistoryTicks, UINT32_MAX);
+	lastSyncTick = 0;
+	tick = 0;
+	rollbackFrom = 0;
+	accumulator = 0.f;
+	stats = RollbackStats();
+	resyncData.resize(RollbackProtocol::MaxSnapshotSize);
+	resyncTick = UINT32_MAX;
+	resyncPending = false;
+	lastResyncSent = 0;
+	rollbackFloor = 0;
+	resyncSnapshot.landers.reserve(params.playerCount);
+	resyncSnapshot.circles.reserve(64);
+	resyncSnapshot.boxes.reserve(64);
+	simulation->StartRound();
+}
+
+int RollbackSession::Advance(float frameTime, const NetInput& localInput)
+{
+	accumulator += frameTime;
+	int steps = 0;
+	while (accumulator >= params.timeStep)
+	{
+		if (steps >= params.maxCatchUpTicks)
+		{
+			accumulator = std::fmod(accumulator, params.timeStep);
+			break;
+		}
+		if (!AdvanceTick(localInput))
+		{
+			//Waiting for a peer, catch up once it is back without building a backlog
+			accumulator = std::min(accumulator, params.timeStep * params.maxCatchUpTicks);
+			break;
+		}
+		accumulator -= params.timeStep;
+		steps++;
+	}
+	return steps;
+}
+
+bool RollbackSession::AdvanceTick(const NetInput& localInput)
+{
+	ReceivePackets();
+
+	//Predicting further would need a snapshot older than the arena keeps
+	for (int i = 0; i < params.playerCount; i++)
+	{
+		if (i != params.localPlayer && tick >= players[i].confirmedUntil + params.maxRollbackTicks)
+		{
+			stats.stalls++;
+			SendInputs();
+			return false;
+		}
+	}
+
+	Player& local = players[params.localPlayer];
+	TickInput& entry = local.ticks[tick % HistoryTicks];
+	entry.tick = tick;
+	entry.input = localInput;
+	entry.confirmed = true;
+	local.confirmedUntil = tick + 1;
+	SendInputs();
+
+	Rollback();
+	SimulateTick(tick);
+	tick++;
+	stats.ticks++;
+	rollbackFrom = tick;
+	UpdateSyncHashes();
+	if (resyncPending && tick >= lastResyncSent + ResyncIntervalTicks)
+		SendResync();
+	return true;
+}
+
+void RollbackSession::ReceivePackets()
+{
+	uint8_t data[RollbackProtocol::MaxDatagramSize];
+	InputPacket packet;
+	ResyncChunk chunk;
+	int size;
+	while ((size = transport->Receive(data, sizeof(data))) > 0)
+	{
+		if (RollbackProtocol::Decode(data, size, packet))
+		{
+			stats.packetsReceived++;
+			ApplyPacket(packet);
+		}
+		else if (RollbackProtocol::DecodeResync(data, size, chunk))
+		{
+			stats.packetsReceived++;
+			ApplyResync(chunk);
+		}
+	}
+}
+
+void RollbackSession::ApplyPacket(const InputPacket& packet)
+{
+	if (packet.player >= params.playerCount || packet.player == params.localPlayer)
+		return;
+	Player& player = players[packet.player];
+	for (int i = 0; i < packet.count; i++)
+	{
+		uint32_t at = packet.firstTick + i;
+		//Already known, or so far ahead it would overwrite inputs still needed
+		if (at < player.confirmedUntil || at >= tick + HistoryTicks / 2)
+			continue;
+		TickInput& entry = player.ticks[at % HistoryTicks];
+		//Ticks before a snapshot taken over are the first player's, they aren't simulated again
+		bool simulated = at < tick && at >= rollbackFloor && entry.tick == at;
+		if (simulated && (entry.used.controls.thrustDelta != packet.inputs[i].controls.thrustDelta
+			|| entry.used.controls.rotationRate != packet.inputs[i].controls.rotationRate
+			|| entry.used.flags != packet.inputs[i].flags))
+			rollbackFrom = std::min(rollbackFrom, at);
+		entry.tick = at;
+		entry.input = packet.inputs[i];
+		entry.confirmed = true;
+	}
+	while (player.ticks[player.confirmedUntil % HistoryTicks].tick == player.confirmedUntil
+		&& player.ticks[player.confirmedUntil % HistoryTicks].confirmed)
+	{
+		player.confirmedUntil++;
+	}
+
+	if (packet.syncTick > player.syncTick)
+	{
+		player.syncTick = packet.syncTick;
+		player.syncHash = packet.syncHash;
+		player.syncChecked = false;
+		CheckSync(player);
+	}
+}
+
+void RollbackSession::ApplyResync(const ResyncChunk& chunk)
+{
+	if (chunk.player != 0 || params.localPlayer == 0)
+		return;
+	if (chunk.tick != resyncTick || chunk.size != resyncSize)
+	{
+		//Chunks of an older snapshot still missing are given up on
+		resyncTick = chunk.tick;
+		resyncSize = chunk.size;
+		resyncReceived = 0;
+		std::fill(resyncChunks, resyncChunks + ResyncChunk::MaxChunks, false);
+	}
+	if (resyncChunks[chunk.index])
+		return;
+	resyncChunks[chunk.index] = true;
+	memcpy(resyncData.data() + chunk.index * ResyncChunk::MaxBytes, chunk.data, chunk.length);
+	if (++resyncReceived < chunk.count)
+		return;
+	resyncTick = UINT32_MAX;
+
+	//Ahead of us, or further back than the inputs kept
+	uint32_t at = chunk.tick;
+	if (at == 0 || at > tick || tick - at >= HistoryTicks / 2)
+		return;
+	if (!RollbackProtocol::DecodeSnapshot(resyncData.data(), resyncSize, resyncSnapshot))
+	{
+		ofLogError("RollbackSession") << "Malformed snapshot of tick " << at << " from the first player";
+		return;
+	}
+	uint32_t hash = resyncSnapshot.Hash();
+	uint32_t ownHash;
+	int slot = at % snapshots.GetSlotCount();
+	if (GetSyncHash(at, ownHash) ? ownHash == hash : snapshotTicks[slot] == at && snapshots.Get(slot).Hash() == hash)
+		return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	simulation->Restore(resyncSnapshot);
+	std::fill(snapshotTicks.begin(), snapshotTicks.end(), UINT32_MAX);
+	rollbackFloor = at;
+	for (uint32_t resimulated = at; resimulated < tick; resimulated++)
+	{
+		SimulateTick(resimulated);
+	}
+	rollbackFrom = tick;
+	double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	stats.maxRollbackMillis = std::max(stats.maxRollbackMillis, millis);
+
+	//Our hashes from the snapshot on were of the world we just dropped
+	for (int i = 0; i < HistoryTicks; i++)
+	{
+		if (syncHashTicks[i] != UINT32_MAX && syncHashTicks[i] >= at)
+			syncHashTicks[i] = UINT32_MAX;
+	}
+	syncHashes[at % HistoryTicks] = hash;
+	syncHashTicks[at % HistoryTicks] = at;
+	lastSyncTick = std::min(lastSyncTick, at);
+	if (stats.resyncsApplied++ == 0)
+		ofLogNotice("RollbackSession") << "Took over the first player's world at tick " << at;
+}
+
+void RollbackSession::SendResync()
+{
+	//The newest snapshot whose every earlier input is known, the same on every peer that is in sync
+	uint32_t at = lastSyncTick;
+	int slot = at % snapshots.GetSlotCount();
+	if (at == 0 || snapshotTicks[slot] != at)
+		return;
+	int size = RollbackProtocol::EncodeSnapshot(snapshots.Get(slot), resyncData.data(), (int)resyncData.size());
+	resyncPending = false;
+	lastResyncSent = tick;
+	if (size == 0)
+	{
+		ofLogError("RollbackSession") << "Snapshot of tick " << at << " is too large to send";
+		return;
+	}
+
+	ResyncChunk chunk;
+	chunk.player = (uint8_t)params.localPlayer;
+	chunk.tick = at;
+	chunk.size = size;
+	chunk.count = (uint8_t)((size + ResyncChunk::MaxBytes - 1) / ResyncChunk::MaxBytes);
+	uint8_t data[RollbackProtocol::MaxResyncPacketSize];
+	for (int i = 0; i < chunk.count; i++)
+	{
+		chunk.index = (uint8_t)i;
+		chunk.length = (uint16_t)std::min(size - i * ResyncChunk::MaxBytes, (int)ResyncChunk::MaxBytes);
+		chunk.data = resyncData.data() + i * ResyncChunk::MaxBytes;
+		transport->Send(data, RollbackProtocol::EncodeResync(chunk, data));
+	}
+	stats.resyncsSent++;
+}
+
+void RollbackSession::SendInputs()
+{
+	const Player& local = players[params.localPlayer];
+	InputPacket packet;
+	packet.player = params.localPlayer;
+	packet.count = std::min((uint32_t)InputPacket::MaxInputs, local.confirmedUntil);
+	packet.firstTick = local.confirmedUntil - packet.count;
+	for (int i = 0; i < packet.count; i++)
+	{
+		packet.inputs[i] = local.ticks[(packet.firstTick + i) % HistoryTicks].input;
+	}
+	packet.syncTick = lastSyncTick;
+	packet.syncHash = lastSyncTick > 0 ? syncHashes[lastSyncTick % HistoryTicks] : 0;
+	uint8_t data[RollbackProtocol::MaxPacketSize];
+	transport->Send(data, RollbackProtocol::Encode(packet, data));
+}
+
+void RollbackSession::Rollback()
+{
+	if (rollbackFrom >= tick)
+		return;
+	int slot = rollbackFrom % snapshots.GetSlotCount();
+	if (snapshotTicks[slot] != rollbackFrom)
+	{
+		ofLogError("RollbackSession") << "No snapshot of tick " << rollbackFrom << " left, the peers will diverge";
+		rollbackFrom = tick;
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	simulation->Restore(snapshots.Get(slot));
+	for (uint32_t at = rollbackFrom; at < tick; at++)
+	{
+		SimulateTick(at);
+	}
+	double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	int depth = tick - rollbackFrom;
+	stats.rollbacks++;
+	stats.resimulatedTicks += depth;
+	stats.maxRollbackTicks = std::max(stats.maxRollbackTicks, depth);
+	stats.maxRollbackMillis = std::max(stats.maxRollbackMillis, millis);
+	rollbackFrom = tick;
+}
+
+NetInput RollbackSession::Predict(const Player& player)
+{
+	//The last known input goes on, one-off requests don't
+	NetInput prediction;
+	if (player.confirmedUntil > 0)
+	{
+		const TickInput& last = player.ticks[(player.confirmedUntil - 1) % HistoryTicks];
+		if (last.tick == player.confirmedUntil - 1)
+			prediction.controls = last.input.controls;
+	}
+	return prediction;
+}
+
+void RollbackSession::SimulateTick(uint32_t at)
+{
+	int slot = at % snapshots.GetSlotCount();
+	//Restored in place too, so this run goes on from the same contacts as one rolled back to the snapshot
+	simulation->Checkpoint(snapshots.Get(slot));
+	snapshotTicks[slot] = at;
+
+	bool startRound = false;
+	for (int i = 0; i < params.playerCount; i++)
+	{
+		Player& player = players[i];
+		TickInput& entry = player.ticks[at % HistoryTicks];
+		if (entry.tick != at || !entry.confirmed)
+		{
+			entry.tick = at;
+			entry.confirmed = false;
+			entry.used = Predict(player);
+		}
+		else
+			entry.used = entry.input;
+		controls[i] = entry.used.controls;
+		startRound |= (entry.used.flags & NetStartRound) != 0;
+	}
+	if (startRound)
+		simulation->StartRound();
+	simulation->Step(controls.data(), params.playerCount);
+}
+
+void RollbackSession::UpdateSyncHashes()
+{
+	uint32_t confirmed = tick;
+	for (const Player& player : players)
+	{
+		confirmed = std::min(confirmed, player.confirmedUntil);
+	}
+	//The snapshot of a tick is final once every input before it is known; the newest snapshot is of tick - 1
+	uint32_t last = std::min(confirmed, tick - 1);
+	for (uint32_t at = lastSyncTick + 1; at <= last; at++)
+	{
+		int slot = at % snapshots.GetSlotCount();
+		if (snapshotTicks[slot] != at)
+			continue;
+		syncHashes[at % HistoryTicks] = snapshots.Get(slot).Hash();
+		syncHashTicks[at % HistoryTicks] = at;
+	}
+	lastSyncTick = std::max(lastSyncTick, last);
+	for (Player& player : players)
+	{
+		CheckSync(player);
+	}
+}
+
+void RollbackSession::CheckSync(Player& player)
+{
+	uint32_t hash;
+	if (player.syncChecked || player.syncTick == 0 || !GetSyncHash(player.syncTick, hash))
+		return;
+	player.syncChecked = true;
+	stats.syncChecks++;
+	if (hash != player.syncHash)
+	{
+		if (stats.desyncs++ == 0)
+		{
+			stats.firstDesyncTick = player.syncTick;
+			ofLogWarning("RollbackSession") << "Peers diverged at tick " << player.syncTick;
+		}
+		//The first player's world is the one the others fall back to
+		if (params.localPlayer == 0)
+			resyncPending = true;
+	}
+}
+
+uint32_t RollbackSession::GetTick()
+{
+	return tick;
+}
+
+int RollbackSession::GetLocalPlayer()
+{
+	return params.localPlayer;
+}
+
+bool RollbackSession::GetSyncHash(uint32_t at, uint32_t& hash)
+{
+	if (at == 0 || syncHashTicks[at % HistoryTicks] != at)
+		return false;
+	hash = syncHashes[at % HistoryTicks];
+	return true;
+}
+
+uint32_t RollbackSession::GetLastSyncTick()
+{
+	return lastSyncTick;
+}
+
+RollbackStats RollbackSession::GetStats()
+{
+	return stats;
+}
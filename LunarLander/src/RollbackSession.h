@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Simulation.h"
+#include "SimulationSnapshot.h"
+#include "InputTransport.h"
+#include "RollbackProtocol.h"
+
+struct RollbackParams {
+	int playerCount = 2;
+	int localPlayer = 0;
+	int maxRollbackTicks = 8;	//How far the session predicts ahead of a peer before it waits for it
+	float timeStep = 1.f / 60.f;
+	int maxCatchUpTicks = 5;	//Ticks allowed per frame before dropping time
+};
+
+struct RollbackStats {
+	uint64_t ticks = 0;
+	uint64_t rollbacks = 0;
+	uint64_t resimulatedTicks = 0;
+	int maxRollbackTicks = 0;
+	double maxRollbackMillis = 0.0;	//Longest restore and resimulation
+	uint64_t stalls = 0;	//Ticks waited for a peer that fell too far behind
+	uint64_t packetsReceived = 0;
+	uint64_t syncChecks = 0;	//Peer hashes compared against our own
+	uint64_t desyncs = 0;	//Of those, the ones that differed
+	int64_t firstDesyncTick = -1;
+	uint64_t resyncsSent = 0;	//Snapshots the first player sent after a desync
+	uint64_t resyncsApplied = 0;	//Snapshots taken over from the first player
+};
+
+//Peer-to-peer rollback over a shared simulation, one lander per player. Only inputs travel: every peer
+//runs the whole game, applies its own input at once and predicts everyone else to keep doing what they
+//did last. When a remote input arrives that differs from the prediction the world is restored to the
+//snapshot of that tick and the ticks since are simulated again, so local control never waits for the
+//network. A snapshot of each of the last maxRollbackTicks ticks is kept in a preallocated arena.
+//Resimulating isn't bit-identical in every case Box2D can get into, so peers can still drift apart: the
+//first player settles it by sending its snapshot of the newest final tick to whoever reported a
+//different hash, and a peer that disagrees with it takes it over and simulates again from there.
+class RollbackSession
+{
+	static const int HistoryTicks = 64;	//Power of two, longer than any rollback plus the packet window
+	static const int ResyncIntervalTicks = 30;	//Between two snapshots the first player sends
+
+	struct TickInput {
+		uint32_t tick = UINT32_MAX;	//Which tick the slot holds
+		NetInput input;
+		NetInput used;	//What the simulation ran with, the input or a prediction
+		bool confirmed = false;
+	};
+
+	struct Player {
+		TickInput ticks[HistoryTicks];
+		uint32_t confirmedUntil = 0;	//Every input before this tick is known
+		uint32_t syncTick = 0;	//Newest hash the peer reported, 0 for none
+		uint32_t syncHash = 0;
+		bool syncChecked = true;
+	};
+
+	RollbackParams params;
+	Simulation* simulation = nullptr;
+	InputTransport* transport = nullptr;
+	SnapshotArena snapshots;
+	std::vector<uint32_t> snapshotTicks;
+	std::vector<Player> players;
+	std::vector<LanderControls> controls;
+	//Hashes of the snapshots of ticks whose every earlier input is known, final on every peer
+	uint32_t syncHashes[HistoryTicks];
+	uint32_t syncHashTicks[HistoryTicks];
+	uint32_t lastSyncTick = 0;
+	uint32_t tick = 0;	//Next tick to simulate
+	uint32_t rollbackFrom;	//Earliest tick whose input turned out different, tick when there is none
+	float accumulator = 0.f;
+	RollbackStats stats;
+
+	//Resync, of the snapshot being sent or put together from its chunks
+	std::vector<uint8_t> resyncData;
+	bool resyncChunks[ResyncChunk::MaxChunks];
+	uint32_t resyncTick = UINT32_MAX;
+	uint32_t resyncSize = 0;
+	int resyncReceived = 0;
+	bool resyncPending = false;
+	uint32_t lastResyncSent = 0;
+	uint32_t rollbackFloor = 0;	//Snapshot taken over, nothing before it is simulated again
+	SimulationSnapshot resyncSnapshot;
+
+	void ReceivePackets();
+	void ApplyPacket(const InputPacket& packet);
+	void ApplyResync(const ResyncChunk& chunk);
+	void SendResync();
+	void SendInputs();
+	void Rollback();
+	void SimulateTick(uint32_t at);
+	NetInput Predict(const Player& player);
+	void UpdateSyncHashes();
+	void CheckSync(Player& player);
+
+public:
+
+	//The simulation has to be set up with params.playerCount players and the same terrain seed on every peer;
+	//the first round starts at tick 0
+	void Setup(Simulation* simulation, InputTransport* transport, const RollbackParams& params);
+	//Runs as many ticks as the frame time covers, with the local input for each; returns the ticks run
+	int Advance(float frameTime, const NetInput& localInput);
+	//One tick, false when it has to wait for a peer
+	bool AdvanceTick(const NetInput& localInput);
+
+	uint32_t GetTick();
+	int GetLocalPlayer();
+	//Hash of the world at the start of a tick once every input before it is known, false when the tick
+	//isn't final yet or too old
+	bool GetSyncHash(uint32_t at, uint32_t& hash);
+	uint32_t GetLastSyncTick();
+	RollbackStats GetStats();
+};
@@ -0,0 +1,121 @@
+#include "SceneRecorder.h"
+
+SceneRecorder::SceneRecorder()
+{
+	//Below the gauges
+	hud.Setup(ofVec2f(30.f, 60.f), 8.f, ofColor::white);
+	positionXField = hud.AddField("POS X", 1);
+	positionYField = hud.AddField("POS Y", 1);
+	rotationField = hud.AddField("ROT", 1);
+	rotationRateField = hud.AddField("DROT", 1);
+	thrustField = hud.AddField("THRUST", 2);
+}
+
+void SceneRecorder::Record(Simulation& simulation, LaserLodController& lod, float cameraX, bool debug, DrawList& list)
+{
+	list.Clear();
+	DrawTransform camera;
+	camera.translation.x = -cameraX;
+	list.SetView(camera);
+
+	//The landing pads and the lander are kept at any level of detail
+	float terrainTolerance = lod.GetTerrainTolerance();
+	if (simulation.GetChunkedSurface())
+		simulation.GetChunkedSurface()->Record(list, terrainTolerance);
+	else
+		simulation.GetSurface()->Record(list, terrainTolerance);
+	for (int i = 0; i < simulation.GetPlayerCount(); i++)
+	{
+		simulation.GetLander(i)->Record(list, simulation.GetInterpolationAlpha(), lod.GetLanderTolerance());
+	}
+
+	Lander* lander = simulation.GetLander(std::min(focusPlayer, simulation.GetPlayerCount() - 1));
+	ofVec2f landerPos = lander->GetPosition();
+	for (auto& circle : simulation.GetCircles())
+	{
+		RecordBody(list, circle->body, ofColor::fromHex(0xf6c738), circle->getPosition().distance(landerPos), lod);
+	}
+	for (auto& box : simulation.GetBoxes())
+	{
+		RecordBody(list, box->body, ofColor::fromHex(0xBF2545), box->getPosition().distance(landerPos), lod);
+	}
+
+	if (debug)
+	{
+		b2World* world = simulation.GetWorld()->getWorld();
+		debugRenderer.Begin();
+		world->SetDebugDraw(&debugRenderer);
+		world->DrawDebugData();
+		debugRenderer.End(list);
+	}
+
+	//HUD gauges: thrust, fuel used this round
+	float thrust = std::min(lander->GetThrusterStrength() / .5f, 1.f);
+	list.AddLine(ofVec2f(30.f, 30.f), ofVec2f(30.f + 200.f * thrust, 30.f), ofColor::orange, DrawScreenSpace);
+	float fuel = std::min(simulation.GetFuelUsed() / 10.f, 1.f);
+	list.AddLine(ofVec2f(30.f, 45.f), ofVec2f(30.f + 200.f * fuel, 45.f), ofColor::cyan, DrawScreenSpace);
+
+	hud.Set(positionXField, landerPos.x);
+	hud.Set(positionYField, landerPos.y);
+	hud.Set(rotationField, lander->GetRotationDeg());
+	hud.Set(rotationRateField, lander->GetRotationRate() * RAD_TO_DEG);
+	hud.Set(thrustField, lander->GetThrusterStrength());
+	hud.Record(list);
+}
+
+void SceneRecorder::SetFocusPlayer(int player)
+{
+	focusPlayer = player;
+}
+
+Hud& SceneRecorder::GetHud()
+{
+	return hud;
+}
+
+void SceneRecorder::RecordBody(DrawList& list, b2Body* body, const ofColor& color, float distance, LaserLodController& lod)
+{
+	//The laser outlines debris near the lander, further away it shrinks to a dot, then it is culled
+	const b2Transform& transform = body->GetTransform();
+	bool detailed = distance < lod.GetDebrisDetailDistance();
+	bool culled = distance >= lod.GetDebrisCullDistance();
+	ofVec2f center = worldPtToscreenPt(transform.p);
+	ofVec2f dot[2] = { center, center + ofVec2f(1.f, 0.f) };
+
+	//Every polygon and circle fixture of the body, filled, in screen space
+	for (b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext())
+	{
+		shape.clear();
+		b2Shape* source = fixture->GetShape();
+		if (source->GetType() == b2Shape::e_polygon)
+		{
+			b2PolygonShape* polygon = (b2PolygonShape*)source;
+			for (int i = 0; i < polygon->m_count; i++)
+			{
+				shape.push_back(worldPtToscreenPt(b2Mul(transform, polygon->m_vertices[i])));
+			}
+		}
+		else if (source->GetType() == b2Shape::e_circle)
+		{
+			b2CircleShape* circle = (b2CircleShape*)source;
+			ofVec2f circleCenter = worldPtToscreenPt(b2Mul(transform, circle->m_p));
+			float radius = circle->m_radius * OFX_BOX2D_SCALE;
+			for (int i = 0; i < 12; i++)
+			{
+				float angle = i * TWO_PI / 12.f;
+				shape.push_back(ofVec2f(circleCenter.x + cos(angle) * radius, circleCenter.y + sin(angle) * radius));
+			}
+		}
+		if (shape.empty())
+			continue;
+
+		if (detailed)
+			list.AddPolygon(shape.data(), shape.size(), color, 0, DrawClosed | DrawFilled);
+		else
+		{
+			list.AddPolygon(shape.data(), shape.size(), color, 0, DrawClosed | DrawFilled, dot, culled ? 0 : 2);
+			//One dot per body is enough
+			culled = true;
+		}
+	}
+}
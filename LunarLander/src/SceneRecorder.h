@@ -0,0 +1,32 @@
+#pragma once
+
+#include "DrawList.h"
+#include "Simulation.h"
+#include "LaserLod.h"
+#include "Box2dDebugRenderer.h"
+#include "Hud.h"
+
+//Records everything on screen into a draw list once per frame, for all outputs to share
+class SceneRecorder
+{
+	Box2dDebugRenderer debugRenderer;
+	std::vector<ofVec2f> shape;
+	Hud hud;
+	int focusPlayer = 0;	//Whose lander the HUD and debris detail follow
+	int positionXField;
+	int positionYField;
+	int rotationField;
+	int rotationRateField;
+	int thrustField;
+
+	void RecordBody(DrawList& list, b2Body* body, const ofColor& color, float distance, LaserLodController& lod);
+
+public:
+
+	SceneRecorder();
+
+	//Outline detail follows the laser's level of detail, the full geometry is always recorded
+	void Record(Simulation& simulation, LaserLodController& lod, float cameraX, bool debug, DrawList& list);
+	void SetFocusPlayer(int player);
+	Hud& GetHud();
+};
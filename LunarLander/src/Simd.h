@@ -0,0 +1,7 @@
+#pragma once
+
+//SSE2 is part of every x64 target, elsewhere the kernels fall back to scalar code
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LUNAR_SSE2 1
+#include <emmintrin.h>
+#endif
@@ -0,0 +1,622 @@
+#include "Simulation.h"
+#include "InputRecorder.h"
+#include "Fnv1a.h"
+
+#include <algorithm>
+
+void Simulation::Setup(int arenaWidth, int arenaHeight)
+{
+	this->arenaWidth = arenaWidth;
+	this->arenaHeight = arenaHeight;
+	world.init();
+	world.setGravity(0, 1);
+	//Streaming terrain goes on sideways forever, so the arena gets no walls
+	if (!streamingTerrain)
+		world.createBounds(ofRectangle(0, 0, arenaWidth, arenaHeight));
+	world.setFPS(1.f / timeStep);
+
+	world.getWorld()->SetContactListener(&contactManager);
+
+	surfGenerationParams = {
+		.5f,	//minHeight
+		.95f,	//maxHeight
+		200,	//numPoints
+		.05f, 	//maxHeightDiff
+		4, 		//minPlateauSize
+		8, 		//maxPlateauSize
+		3		//plateauCount
+	};
+	if (streamingTerrain)
+	{
+		//Every chunk looks like one screen of the classic terrain
+		chunkedSurfParams.chunk = surfGenerationParams;
+		chunkedSurfParams.chunkWidth = arenaWidth;
+		chunkedSurf = new ChunkedSurface(&world);
+		chunkedSurf->SetParams(chunkedSurfParams);
+		chunkedSurf->SetScreenSize(arenaWidth, arenaHeight);
+	}
+	else
+	{
+		surf = new Surface(&world);
+		surf->SetScreenSize(arenaWidth, arenaHeight);
+		if (terrainPrefetchDepth > 0)
+		{
+			terrainPrefetcher = new TerrainPrefetcher(terrainPrefetchDepth);
+			terrainPrefetcher->Start(surfGenerationParams, nextTerrainSeed);
+		}
+	}
+	GenerateTerrain();
+
+	landerParams = {
+		5.f,					//angularDamping
+		.01f,					//linearDamping
+		1.f, 					//density
+		.1f, 					//friction
+		.1f,					//bounce
+		ofVec2f(200.f, 100.f),	//startingPos
+		3.f						//startVelocity
+	};
+	for (int i = 0; i < playerCount; i++)
+	{
+		LanderParams playerParams = landerParams;
+		playerParams.startingPos.x += i * PlayerSpacing;
+		Lander* player = new Lander(&world, &contactManager, playerParams, "lander");
+		player->SetScale(20);
+		landers.push_back(player);
+	}
+	lander = landers[0];
+
+	landingListener = new LandingSpotContactListener(this);
+	contactManager.SetCallback(landingListener, ContactCallbackFlag::BeginContact | ContactCallbackFlag::EndContact);
+
+	for (Lander* player : landers)
+	{
+		player->Sleep();
+	}
+	gameState = GameState::Landed;
+}
+
+void Simulation::Step(const LanderControls& controls)
+{
+	Step(&controls, 1);
+}
+
+void Simulation::Step(const LanderControls* controls, int count)
+{
+	if (CheckWin())
+	{
+		ofLogNotice() << "CHICKEN DINNER";
+		for (Lander* player : landers)
+		{
+			player->Sleep();
+		}
+		gameState = GameState::Landed;
+	}
+	if (gameState == GameState::Flying || gameState == GameState::Landing)
+	{
+		for (int i = 0; i < (int)landers.size(); i++)
+		{
+			LanderControls playerControls = i < count ? controls[i] : LanderControls();
+			landers[i]->AddThrusterStrength(playerControls.thrustDelta);
+			landers[i]->SetRotationRate(playerControls.rotationRate);
+			landers[i]->Update();
+		}
+	}
+
+	world.update();
+	//Contact handlers run here, outside the solver, where they may change the world
+	contactManager.Flush();
+	for (Lander* player : landers)
+	{
+		player->Sync();
+	}
+	//Terrain streams around the first player
+	if (chunkedSurf)
+		chunkedSurf->Update(lander->GetPosition().x);
+	simulationTime += timeStep;
+	stepCount++;
+
+	if (gameState == GameState::Flying || gameState == GameState::Landing)
+	{
+		//The round is lost once nobody is left flying
+		bool anyFlying = false;
+		for (Lander* player : landers)
+		{
+			fuelUsed += player->GetThrusterStrength() * timeStep;
+			if (player->IsCrashed() && player->IsActive())
+				player->Sleep();
+			anyFlying |= !player->IsCrashed();
+		}
+		if (!anyFlying)
+			gameState = GameState::Crashed;
+	}
+	if (inputRecorder)
+		inputRecorder->AddTick(count > 0 ? controls[0] : LanderControls(), HashState());
+}
+
+int Simulation::Advance(float frameTime, const LanderControls& controls)
+{
+	accumulator += frameTime;
+	int steps = 0;
+	while (accumulator >= timeStep)
+	{
+		//Drop the backlog instead of spiralling when frames are too slow to catch up
+		if (steps >= maxCatchUpSteps)
+		{
+			accumulator = std::fmod(accumulator, timeStep);
+			break;
+		}
+		Step(controls);
+		accumulator -= timeStep;
+		steps++;
+	}
+	return steps;
+}
+
+void Simulation::SetTimeStep(float seconds)
+{
+	timeStep = seconds;
+	world.setFPS(1.f / timeStep);
+}
+
+void Simulation::SetMaxCatchUpSteps(int steps)
+{
+	maxCatchUpSteps = steps;
+}
+
+float Simulation::GetTimeStep()
+{
+	return timeStep;
+}
+
+float Simulation::GetInterpolationAlpha()
+{
+	return accumulator / timeStep;
+}
+
+void Simulation::StartRound()
+{
+	if (inputRecorder)
+		inputRecorder->AddEvent(InputEvent::StartRound);
+	if (gameState == GameState::Landed || gameState == GameState::Crashed)
+	{
+		GenerateTerrain();
+		for (int i = 0; i < (int)landers.size(); i++)
+		{
+			LanderParams playerParams = landerParams;
+			playerParams.startingPos.x += i * PlayerSpacing;
+			landers[i]->Start(playerParams);
+		}
+		gameState = GameState::Flying;
+		roundStartTime = simulationTime;
+		fuelUsed = 0.f;
+		Checkpoint(roundStart);
+	}
+}
+
+void Simulation::ResetRound()
+{
+	if (inputRecorder)
+		inputRecorder->AddEvent(InputEvent::ResetRound);
+	GenerateTerrain();
+	for (Lander* player : landers)
+	{
+		player->Reset();
+	}
+	roundStartTime = simulationTime;
+	fuelUsed = 0.f;
+	Checkpoint(roundStart);
+}
+
+void Simulation::RetryRound()
+{
+	if (!roundStart.valid)
+	{
+		ResetRound();
+		return;
+	}
+	if (inputRecorder)
+		inputRecorder->AddEvent(InputEvent::RetryRound);
+	//The clock keeps running, only the round starts over
+	uint64_t steps = stepCount;
+	float time = simulationTime;
+	Restore(roundStart);
+	stepCount = steps;
+	simulationTime = time;
+	roundStartTime = time;
+}
+
+void Simulation::AbortRound()
+{
+	if (inputRecorder)
+		inputRecorder->AddEvent(InputEvent::AbortRound);
+	for (Lander* player : landers)
+	{
+		player->Sleep();
+	}
+	if (gameState != GameState::Crashed)
+		gameState = GameState::Landed;
+}
+
+void Simulation::SpawnCircle(float x, float y, float radius)
+{
+	if (inputRecorder)
+		inputRecorder->AddEvent(InputEvent::SpawnCircle, x, y, radius);
+	CreateCircle(x, y, radius);
+}
+
+void Simulation::SpawnBox(float x, float y, float width, float height)
+{
+	if (inputRecorder)
+		inputRecorder->AddEvent(InputEvent::SpawnBox, x, y, width, height);
+	CreateBox(x, y, width, height);
+}
+
+void Simulation::CreateCircle(float x, float y, float radius)
+{
+	circles.push_back(shared_ptr<ofxBox2dCircle>(new ofxBox2dCircle));
+	circles.back().get()->setPhysics(3.0, 0.53, 0.1);
+	circles.back().get()->setup(world.getWorld(), x, y, radius);
+}
+
+void Simulation::CreateBox(float x, float y, float width, float height)
+{
+	boxes.push_back(shared_ptr<ofxBox2dRect>(new ofxBox2dRect));
+	boxes.back().get()->setPhysics(3.0, 0.53, 0.1);
+	boxes.back().get()->setup(world.getWorld(), x, y, width, height);
+}
+
+void Simulation::SetArenaSize(int width, int height)
+{
+	if (inputRecorder)
+		inputRecorder->AddEvent(InputEvent::SetArenaSize, width, height);
+	arenaWidth = width;
+	arenaHeight = height;
+	if (chunkedSurf)
+		chunkedSurf->SetScreenSize(width, height);
+	else
+		surf->SetScreenSize(width, height);
+}
+
+void Simulation::SetTerrainSeed(uint32_t seed)
+{
+	nextTerrainSeed = seed;
+	if (terrainPrefetcher)
+		terrainPrefetcher->Restart(seed);
+}
+
+void Simulation::SetStreamingTerrain(bool streaming)
+{
+	//Only read by Setup
+	streamingTerrain = streaming;
+}
+
+void Simulation::SetTerrainPrefetch(int depth)
+{
+	//Only read by Setup
+	terrainPrefetchDepth = depth;
+}
+
+void Simulation::SetPlayerCount(int count)
+{
+	//Only read by Setup
+	playerCount = std::max(count, 1);
+}
+
+void Simulation::SetLanderParams(const LanderParams& params)
+{
+	landerParams = params;
+}
+
+void Simulation::SetInputRecorder(InputRecorder* recorder)
+{
+	inputRecorder = recorder;
+}
+
+void Simulation::GenerateTerrain()
+{
+	if (chunkedSurf)
+		chunkedSurf->GenerateSurface(nextTerrainSeed);
+	else if (terrainPrefetcher)
+	{
+		//Only the fixture swap runs here when the level is ready, on a miss it is generated in place
+		//and the prefetcher restarts from the level after it
+		bool prefetched = terrainPrefetcher->Take(nextTerrainSeed, pendingTerrain);
+		if (!prefetched)
+			Surface::GenerateTerrain(surfGenerationParams, nextTerrainSeed, pendingTerrain);
+		surf->SwapTerrain(pendingTerrain);
+		if (!prefetched)
+			terrainPrefetcher->Restart(TerrainPrefetcher::NextSeed(nextTerrainSeed));
+	}
+	else
+		surf->GenerateSurface(surfGenerationParams, nextTerrainSeed);
+	ofLogVerbose("Surface") << "Terrain from seed " << nextTerrainSeed;
+	//Derive the following level's seed, so a session replays from its first seed
+	nextTerrainSeed = TerrainPrefetcher::NextSeed(nextTerrainSeed);
+}
+
+uint32_t Simulation::GetTerrainSeed()
+{
+	return chunkedSurf ? chunkedSurf->GetSeed() : surf->GetSeed();
+}
+
+uint32_t Simulation::GetNextTerrainSeed()
+{
+	return nextTerrainSeed;
+}
+
+int Simulation::GetArenaWidth()
+{
+	return arenaWidth;
+}
+
+int Simulation::GetArenaHeight()
+{
+	return arenaHeight;
+}
+
+LanderParams Simulation::GetLanderParams()
+{
+	return landerParams;
+}
+
+static void HashFloat(uint32_t& hash, float value)
+{
+	Fnv1a(hash, &value, sizeof(value));
+}
+
+uint32_t Simulation::HashState()
+{
+	uint32_t hash = Fnv1aOffset32;
+	Fnv1a(hash, &stepCount, sizeof(stepCount));
+	uint8_t state = (uint8_t)gameState;
+	Fnv1a(hash, &state, 1);
+	HashFloat(hash, fuelUsed);
+	for (Lander* player : landers)
+	{
+		HashFloat(hash, player->GetThrusterStrength());
+	}
+	//Bit-exact: the same inputs on the same build give the same floats
+	for (b2Body* body = world.getWorld()->GetBodyList(); body; body = body->GetNext())
+	{
+		const b2Vec2& position = body->GetPosition();
+		const b2Vec2& velocity = body->GetLinearVelocity();
+		HashFloat(hash, position.x);
+		HashFloat(hash, position.y);
+		HashFloat(hash, body->GetAngle());
+		HashFloat(hash, velocity.x);
+		HashFloat(hash, velocity.y);
+		HashFloat(hash, body->GetAngularVelocity());
+		uint8_t flags = (body->IsActive() ? 1 : 0) | (body->IsAwake() ? 2 : 0);
+		Fnv1a(hash, &flags, 1);
+	}
+	return hash;
+}
+
+void Simulation::Capture(SimulationSnapshot& snapshot)
+{
+	snapshot.valid = true;
+	snapshot.stepCount = stepCount;
+	snapshot.simulationTime = simulationTime;
+	snapshot.roundStartTime = roundStartTime;
+	snapshot.fuelUsed = fuelUsed;
+	snapshot.landingTimer = LandingTimer;
+	snapshot.gameState = gameState;
+	snapshot.terrainSeed = GetTerrainSeed();
+	snapshot.nextTerrainSeed = nextTerrainSeed;
+	snapshot.landers.resize(landers.size());
+	for (size_t i = 0; i < landers.size(); i++)
+	{
+		landers[i]->Capture(snapshot.landers[i]);
+	}
+	snapshot.circles.resize(circles.size());
+	for (size_t i = 0; i < circles.size(); i++)
+	{
+		snapshot.circles[i].body.Capture(circles[i]->body);
+		snapshot.circles[i].width = circles[i]->getRadius();
+		snapshot.circles[i].height = 0.f;
+	}
+	snapshot.boxes.resize(boxes.size());
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		snapshot.boxes[i].body.Capture(boxes[i]->body);
+		snapshot.boxes[i].width = boxes[i]->getWidth();
+		snapshot.boxes[i].height = boxes[i]->getHeight();
+	}
+}
+
+void Simulation::Restore(const SimulationSnapshot& snapshot)
+{
+	if (!snapshot.valid)
+		return;
+	if (snapshot.terrainSeed != GetTerrainSeed())
+	{
+		ofLogVerbose("Simulation") << "Restoring into another level, generating terrain " << snapshot.terrainSeed;
+		nextTerrainSeed = snapshot.terrainSeed;
+		GenerateTerrain();
+	}
+	nextTerrainSeed = snapshot.nextTerrainSeed;
+	stepCount = snapshot.stepCount;
+	simulationTime = snapshot.simulationTime;
+	roundStartTime = snapshot.roundStartTime;
+	fuelUsed = snapshot.fuelUsed;
+	LandingTimer = snapshot.landingTimer;
+	gameState = (GameState)snapshot.gameState;
+	//The contacts dropped here would reach the listeners as separations, the ones found again begin anew
+	//on the next step
+	world.getWorld()->SetContactListener(nullptr);
+	for (size_t i = 0; i < landers.size() && i < snapshot.landers.size(); i++)
+	{
+		landers[i]->Restore(snapshot.landers[i]);
+	}
+	RestoreDebris(circles, snapshot.circles);
+	RestoreDebris(boxes, snapshot.boxes);
+	world.getWorld()->SetContactListener(&contactManager);
+	landingListener->ResetContacts();
+	if (chunkedSurf)
+		chunkedSurf->Update(lander->GetPosition().x);
+}
+
+void Simulation::Checkpoint(SimulationSnapshot& snapshot)
+{
+	Capture(snapshot);
+	Restore(snapshot);
+}
+
+void Simulation::RestoreDebris(std::vector<shared_ptr<ofxBox2dCircle> >& shapes, const std::vector<DebrisSnapshot>& snapshots)
+{
+	while (shapes.size() > snapshots.size())
+	{
+		shapes.back()->destroy();
+		shapes.pop_back();
+	}
+	for (size_t i = shapes.size(); i < snapshots.size(); i++)
+	{
+		CreateCircle(0.f, 0.f, snapshots[i].width);
+	}
+	for (size_t i = 0; i < snapshots.size(); i++)
+	{
+		snapshots[i].body.Restore(shapes[i]->body);
+	}
+}
+
+void Simulation::RestoreDebris(std::vector<shared_ptr<ofxBox2dRect> >& shapes, const std::vector<DebrisSnapshot>& snapshots)
+{
+	while (shapes.size() > snapshots.size())
+	{
+		shapes.back()->destroy();
+		shapes.pop_back();
+	}
+	for (size_t i = shapes.size(); i < snapshots.size(); i++)
+	{
+		CreateBox(0.f, 0.f, snapshots[i].width, snapshots[i].height);
+	}
+	for (size_t i = 0; i < snapshots.size(); i++)
+	{
+		snapshots[i].body.Restore(shapes[i]->body);
+	}
+}
+
+bool Simulation::CheckWin()
+{
+	if (gameState == GameState::Landing)
+	{
+		//Everyone still flying has to come to rest
+		bool stationary = true;
+		for (Lander* player : landers)
+		{
+			stationary &= !player->IsActive() || player->IsStationary();
+		}
+		if (stationary)
+		{
+			if ((simulationTime - LandingTimer) > 3.f)
+				return true;
+		}
+		else
+		{
+			LandingTimer = simulationTime;
+		}
+	}
+	return false;
+}
+
+void Simulation::StartLanding()
+{
+	//Events are dispatched after the step, the round may have ended in between
+	if (gameState != GameState::Flying)
+		return;
+	gameState = GameState::Landing;
+	LandingTimer = simulationTime;
+	ofLogNotice("Landing") << "Started";
+}
+
+void Simulation::EndLanding()
+{
+	if (gameState != GameState::Landing)
+		return;
+	gameState = GameState::Flying;
+	ofLogNotice("Landing") << "Ended";
+}
+
+Simulation::GameState Simulation::GetGameState()
+{
+	return gameState;
+}
+
+float Simulation::GetSimulationTime()
+{
+	return simulationTime;
+}
+
+uint64_t Simulation::GetStepCount()
+{
+	return stepCount;
+}
+
+float Simulation::GetRoundTime()
+{
+	return simulationTime - roundStartTime;
+}
+
+float Simulation::GetFuelUsed()
+{
+	return fuelUsed;
+}
+
+LunarLanderConatactManager* Simulation::GetContactManager()
+{
+	return &contactManager;
+}
+
+ofxBox2d* Simulation::GetWorld()
+{
+	return &world;
+}
+
+Surface* Simulation::GetSurface()
+{
+	return surf;
+}
+
+ChunkedSurface* Simulation::GetChunkedSurface()
+{
+	return chunkedSurf;
+}
+
+Lander* Simulation::GetLander()
+{
+	return lander;
+}
+
+Lander* Simulation::GetLander(int player)
+{
+	return landers[player];
+}
+
+int Simulation::GetPlayerCount()
+{
+	return landers.size();
+}
+
+const vector<shared_ptr<ofxBox2dCircle> >& Simulation::GetCircles()
+{
+	return circles;
+}
+
+const vector<shared_ptr<ofxBox2dRect> >& Simulation::GetBoxes()
+{
+	return boxes;
+}
+
+Simulation::~Simulation()
+{
+	contactManager.RemoveCallback(landingListener);
+	delete landingListener;
+	delete terrainPrefetcher;
+	for (Lander* player : landers)
+	{
+		delete player;
+	}
+	delete surf;
+	delete chunkedSurf;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "ofxBox2d.h"
+#include "Surface.h"
+#include "ChunkedSurface.h"
+#include "TerrainPrefetcher.h"
+#include "Lander.h"
+#include "ContactListeners.h"
+#include "SimulationSnapshot.h"
+
+class InputRecorder;
+
+//The control input applied to the lander for one simulation step
+struct LanderControls {
+	float thrustDelta = 0.f;	//Added to the current thruster strength
+	float rotationRate = 0.f;	//Torque applied for the step
+};
+
+//Owns the physics world and all game logic, without any window or draw calls
+class Simulation
+{
+public:
+
+	enum GameState { Flying, Landing, Landed, Crashed };
+
+	static constexpr float PlayerSpacing = 60.f;	//Between the starting positions of two players
+
+private:
+
+	ofxBox2d world;
+	float timeStep = 1.f / 60.f;	//Fixed length of one physics tick
+	float accumulator = 0.f;	//Frame time not yet consumed by ticks
+	int maxCatchUpSteps = 5;	//Ticks allowed per frame before dropping time
+
+	LunarLanderConatactManager contactManager;
+
+	Surface* surf = nullptr;
+	SurfaceGenerationParams surfGenerationParams;
+	ChunkedSurface* chunkedSurf = nullptr;	//Replaces surf when streaming terrain is on
+	ChunkedSurfaceParams chunkedSurfParams;
+	bool streamingTerrain = false;
+	uint32_t nextTerrainSeed = 1;
+	TerrainPrefetcher* terrainPrefetcher = nullptr;
+	int terrainPrefetchDepth = 0;	//Levels generated ahead on a worker thread, 0 generates on demand
+	TerrainData pendingTerrain;	//Receives the next level, then holds the previous level's buffers
+
+	Lander* lander;	//The first player
+	std::vector<Lander*> landers;
+	int playerCount = 1;
+	LanderParams landerParams;
+
+	LandingSpotContactListener* landingListener;
+
+	vector   <shared_ptr<ofxBox2dCircle> > circles; // default box2d circles
+	vector   <shared_ptr<ofxBox2dRect> >   boxes;   // defalut box2d rects
+
+	GameState gameState;
+
+	float LandingTimer;	//Simulated time when the lander last moved while on a landing spot
+	float simulationTime = 0.f;	//Simulated seconds since setup
+	uint64_t stepCount = 0;
+	float roundStartTime = 0.f;
+	float fuelUsed = 0.f;	//Thrust integrated over the current round
+	int arenaWidth = 0;
+	int arenaHeight = 0;
+
+	InputRecorder* inputRecorder = nullptr;
+	SimulationSnapshot roundStart;	//Checkpoint of the first tick of the round, for retrying it
+
+public:
+
+	void Setup(int arenaWidth, int arenaHeight);
+	//Controls the first player, the others get none
+	void Step(const LanderControls& controls);
+	//One set of controls per player, players past count get none
+	void Step(const LanderControls* controls, int count);
+	int Advance(float frameTime, const LanderControls& controls);
+
+	void SetTimeStep(float seconds);
+	void SetMaxCatchUpSteps(int steps);
+	float GetTimeStep();
+	float GetInterpolationAlpha();
+
+	void StartRound();
+	void ResetRound();
+	void AbortRound();
+	//Restarts the current round on the same level from its first tick, a new round without one
+	void RetryRound();
+
+	void SpawnCircle(float x, float y, float radius);
+	void SpawnBox(float x, float y, float width, float height);
+
+	void SetArenaSize(int width, int height);
+	void SetTerrainSeed(uint32_t seed);
+	void SetStreamingTerrain(bool streaming);
+	void SetTerrainPrefetch(int depth);
+	//Landers sharing the level, side by side
+	void SetPlayerCount(int count);
+	//Used from the next round on
+	void SetLanderParams(const LanderParams& params);
+	//Every tick and world change is logged to the recorder until it is set to nullptr
+	void SetInputRecorder(InputRecorder* recorder);
+
+	bool CheckWin();
+	void StartLanding();
+	void EndLanding();
+
+	uint32_t GetTerrainSeed();
+	uint32_t GetNextTerrainSeed();
+	int GetArenaWidth();
+	int GetArenaHeight();
+	LanderParams GetLanderParams();
+	//Hash of the state of every body and of the round, equal on two runs only as long as they haven't diverged
+	uint32_t HashState();
+
+	//Copies the state of the round, reusing the snapshot's storage
+	void Capture(SimulationSnapshot& snapshot);
+	//Moves every body back to where the snapshot has it without recreating fixtures; debris spawned since is
+	//removed, debris removed since is spawned again. Box2D's contacts, warm starting impulses and sleep timers
+	//are not part of the snapshot: each body's proxies and contacts are destroyed and created again, its sleep
+	//timer zeroed, so the ticks after a restore are the same every time the snapshot is restored.
+	void Restore(const SimulationSnapshot& snapshot);
+	//Capture followed by a restore in place, for a run that has to match the ones branching off the snapshot
+	//later; a world that simply went on from a Capture still has the contacts Restore drops
+	void Checkpoint(SimulationSnapshot& snapshot);
+
+	GameState GetGameState();
+	float GetSimulationTime();
+	uint64_t GetStepCount();
+	float GetRoundTime();
+	float GetFuelUsed();
+
+	LunarLanderConatactManager* GetContactManager();
+	ofxBox2d* GetWorld();
+	Surface* GetSurface();
+	ChunkedSurface* GetChunkedSurface();
+	Lander* GetLander();
+	Lander* GetLander(int player);
+	int GetPlayerCount();
+	const vector<shared_ptr<ofxBox2dCircle> >& GetCircles();
+	const vector<shared_ptr<ofxBox2dRect> >& GetBoxes();
+
+	~Simulation();
+
+private:
+
+	void GenerateTerrain();
+	void CreateCircle(float x, float y, float radius);
+	void CreateBox(float x, float y, float width, float height);
+	void RestoreDebris(std::vector<shared_ptr<ofxBox2dCircle> >& shapes, const std::vector<DebrisSnapshot>& snapshots);
+	void RestoreDebris(std::vector<shared_ptr<ofxBox2dRect> >& shapes, const std::vector<DebrisSnapshot>& snapshots);
+};
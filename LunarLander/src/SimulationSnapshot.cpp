@@ -0,0 +1,95 @@
+#include "SimulationSnapshot.h"
+#include "Fnv1a.h"
+
+void BodySnapshot::Capture(b2Body* body)
+{
+	position = body->GetPosition();
+	angle = body->GetAngle();
+	linearVelocity = body->GetLinearVelocity();
+	angularVelocity = body->GetAngularVelocity();
+	awake = body->IsAwake();
+	active = body->IsActive();
+}
+
+void BodySnapshot::Restore(b2Body* body) const
+{
+	//Deactivating destroys the body's proxies and its contacts with their warm starting impulses; activating
+	//creates the proxies again, and the transform set after that finds the contacts from the restored
+	//position right away. Nothing Box2D kept of the contacts is left, only the order of the restores matters.
+	if (body->IsActive())
+		body->SetActive(false);
+	if (active)
+		body->SetActive(true);
+	body->SetTransform(position, angle);
+	//Putting a body to sleep zeroes its sleep timer and clears its velocity, setting a velocity wakes it
+	body->SetAwake(false);
+	if (awake)
+	{
+		body->SetAwake(true);
+		body->SetLinearVelocity(linearVelocity);
+		body->SetAngularVelocity(angularVelocity);
+	}
+}
+
+static void HashBody(uint32_t& hash, const BodySnapshot& body)
+{
+	float values[6] = { body.position.x, body.position.y, body.angle, body.linearVelocity.x, body.linearVelocity.y, body.angularVelocity };
+	Fnv1a(hash, values, sizeof(values));
+	uint8_t flags = (body.awake ? 1 : 0) | (body.active ? 2 : 0);
+	Fnv1a(hash, &flags, 1);
+}
+
+uint32_t SimulationSnapshot::Hash() const
+{
+	uint32_t hash = Fnv1aOffset32;
+	Fnv1a(hash, &stepCount, sizeof(stepCount));
+	Fnv1a(hash, &gameState, sizeof(gameState));
+	Fnv1a(hash, &fuelUsed, sizeof(fuelUsed));
+	Fnv1a(hash, &terrainSeed, sizeof(terrainSeed));
+	for (const LanderSnapshot& lander : landers)
+	{
+		HashBody(hash, lander.body);
+		Fnv1a(hash, &lander.thrusterStrength, sizeof(float));
+		uint8_t flags = (lander.active ? 1 : 0) | (lander.crashed ? 2 : 0);
+		Fnv1a(hash, &flags, 1);
+	}
+	for (const DebrisSnapshot& circle : circles)
+	{
+		HashBody(hash, circle.body);
+	}
+	for (const DebrisSnapshot& box : boxes)
+	{
+		HashBody(hash, box.body);
+	}
+	return hash;
+}
+
+void SnapshotArena::Setup(int slotCount, int debrisCapacity, int playerCapacity)
+{
+	slots.resize(slotCount);
+	for (SimulationSnapshot& slot : slots)
+	{
+		slot.valid = false;
+		slot.landers.reserve(playerCapacity);
+		slot.circles.reserve(debrisCapacity);
+		slot.boxes.reserve(debrisCapacity);
+	}
+}
+
+int SnapshotArena::GetSlotCount()
+{
+	return slots.size();
+}
+
+SimulationSnapshot& SnapshotArena::Get(int slot)
+{
+	return slots[slot];
+}
+
+void SnapshotArena::Invalidate()
+{
+	for (SimulationSnapshot& slot : slots)
+	{
+		slot.valid = false;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "ofxBox2d.h"
+
+struct BodySnapshot {
+	b2Vec2 position;
+	float angle;
+	b2Vec2 linearVelocity;
+	float angularVelocity;
+	bool awake;
+	bool active;
+
+	void Capture(b2Body* body);
+	//Moves the body in place, its fixtures stay as they are and its contacts are rebuilt from scratch
+	void Restore(b2Body* body) const;
+};
+
+struct LanderSnapshot {
+	BodySnapshot body;
+	float thrusterStrength;
+	float rotationRate;
+	bool active;
+	bool crashed;
+};
+
+struct DebrisSnapshot {
+	BodySnapshot body;
+	float width;	//Radius of a circle
+	float height;
+};
+
+//Everything that changes while a round is played. The terrain is only kept as its seed, restoring into
+//another level generates it again, which is the one slow path.
+struct SimulationSnapshot {
+	bool valid = false;
+	uint64_t stepCount;
+	float simulationTime;
+	float roundStartTime;
+	float fuelUsed;
+	float landingTimer;
+	int gameState;
+	uint32_t terrainSeed;
+	uint32_t nextTerrainSeed;
+	std::vector<LanderSnapshot> landers;	//One per player
+	std::vector<DebrisSnapshot> circles;
+	std::vector<DebrisSnapshot> boxes;
+
+	//Of everything that moves, for comparing snapshots of the same tick taken on different machines
+	uint32_t Hash() const;
+};
+
+//Snapshots allocated up front, so capturing one costs copying the state and nothing else as long as the
+//debris fits in the capacity given to Setup
+class SnapshotArena
+{
+	std::vector<SimulationSnapshot> slots;
+
+public:
+
+	void Setup(int slotCount, int debrisCapacity, int playerCapacity = 4);
+	int GetSlotCount();
+	SimulationSnapshot& Get(int slot);
+	void Invalidate();
+};
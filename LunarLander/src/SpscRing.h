@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+//Lock-free ring for one producer thread and one consumer thread. The capacity is rounded up to a power
+//of two; head and tail only ever grow, their difference is the fill level.
+template<class T>
+class SpscRing
+{
+	std::vector<T> items;
+	size_t mask = 0;
+	//Padding keeps the two ends on separate cache lines, so the threads don't fight over one
+	char padHead[64];
+	std::atomic<size_t> head{ 0 };	//Next slot to read, only written by the consumer
+	char padTail[64];
+	std::atomic<size_t> tail{ 0 };	//Next slot to write, only written by the producer
+
+public:
+
+	SpscRing(size_t capacity = 1024)
+	{
+		Reset(capacity);
+	}
+
+	//Only while neither end is in use
+	void Reset(size_t capacity)
+	{
+		size_t size = 1;
+		while (size < capacity)
+			size <<= 1;
+		items.resize(size);
+		mask = size - 1;
+		head = 0;
+		tail = 0;
+	}
+
+	//Writes all count items or none of them
+	bool Push(const T* values, size_t count)
+	{
+		size_t t = tail.load(std::memory_order_relaxed);
+		size_t h = head.load(std::memory_order_acquire);
+		if (items.size() - (t - h) < count)
+			return false;
+		for (size_t i = 0; i < count; i++)
+		{
+			items[(t + i) & mask] = values[i];
+		}
+		tail.store(t + count, std::memory_order_release);
+		return true;
+	}
+
+	//Reads up to maxCount items, returns how many were read
+	size_t Pop(T* values, size_t maxCount)
+	{
+		size_t h = head.load(std::memory_order_relaxed);
+		size_t t = tail.load(std::memory_order_acquire);
+		size_t count = std::min(maxCount, t - h);
+		for (size_t i = 0; i < count; i++)
+		{
+			values[i] = items[(h + i) & mask];
+		}
+		head.store(h + count, std::memory_order_release);
+		return count;
+	}
+
+	//Approximate from any other thread than the two ends
+	size_t Size()
+	{
+		return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+	}
+
+	size_t Capacity()
+	{
+		return items.size();
+	}
+};
@@ -0,0 +1,161 @@
+#include "StateClient.h"
+
+#include <algorithm>
+#include <cstring>
+
+StateClient::~StateClient()
+{
+	Close();
+}
+
+bool StateClient::Setup(const StateClientParams& params)
+{
+	Close();
+	this->params = params;
+	auto hostPort = ofSplitString(params.server, ":");
+	if (hostPort.size() != 2)
+	{
+		ofLogError("StateClient") << "Server " << params.server << " is not host:port";
+		return false;
+	}
+	receiver.Create();
+	if (!receiver.Bind(params.port))
+	{
+		ofLogError("StateClient") << "Couldn't bind port " << params.port;
+		receiver.Close();
+		return false;
+	}
+	receiver.SetNonBlocking(true);
+	sender.Create();
+	sender.Connect(hostPort[0].c_str(), ofToInt(hostPort[1]));
+	sender.SetNonBlocking(true);
+
+	history.assign(HistorySize, NetWorldState());
+	buffer.resize(NetStateCodec::MaxPacketSize);
+	assembly.resize(NetStateCodec::MaxFragments * NetStateCodec::FragmentBytes);
+	assembled.assign(NetStateCodec::MaxFragments, false);
+	assemblySequence = 0;
+	assemblyReceived = 0;
+	latest = 0;
+	lastAckTime = -1.f;
+	stats = StateClientStats();
+	SendAck();
+	return true;
+}
+
+void StateClient::Close()
+{
+	sender.Close();
+	receiver.Close();
+}
+
+bool StateClient::Update()
+{
+	uint32_t previous = latest;
+	int size;
+	while ((size = receiver.Receive((char*)buffer.data(), buffer.size())) > 0)
+	{
+		stats.packetsReceived++;
+		stats.bytesReceived += size;
+		uint32_t sequence;
+		int index, count, length;
+		const uint8_t* data;
+		if (!NetStateCodec::DecodeFragment(buffer.data(), size, sequence, index, count, data, length))
+			continue;
+		if (sequence <= latest)
+		{
+			stats.stale++;
+			continue;
+		}
+		if (sequence != assemblySequence)
+		{
+			//Fragments of an older state are late, a newer state replaces the one being put together
+			if (sequence < assemblySequence)
+			{
+				stats.stale++;
+				continue;
+			}
+			if (assemblyReceived > 0)
+				stats.incomplete++;
+			assemblySequence = sequence;
+			assemblyReceived = 0;
+			assemblySize = 0;
+			std::fill(assembled.begin(), assembled.end(), false);
+		}
+		if (assembled[index])
+			continue;
+		assembled[index] = true;
+		memcpy(assembly.data() + index * NetStateCodec::FragmentBytes, data, length);
+		assemblySize += length;
+		if (++assemblyReceived == count)
+		{
+			assemblyReceived = 0;
+			ApplyState(assembly.data(), assemblySize);
+		}
+	}
+
+	if (latest != previous || ofGetElapsedTimef() - lastAckTime >= params.helloInterval)
+		SendAck();
+	return latest != previous;
+}
+
+const NetWorldState* StateClient::GetState()
+{
+	return latest != 0 ? &history[latest % HistorySize] : nullptr;
+}
+
+void StateClient::Apply(Simulation& simulation)
+{
+	const NetWorldState* state = GetState();
+	if (!state)
+		return;
+	if (state->GetArenaWidth() != simulation.GetArenaWidth() || state->GetArenaHeight() != simulation.GetArenaHeight())
+		simulation.SetArenaSize(state->GetArenaWidth(), state->GetArenaHeight());
+	if ((int)state->landers.size() != simulation.GetPlayerCount() && !warnedPlayerCount)
+	{
+		warnedPlayerCount = true;
+		ofLogWarning("StateClient") << "The server has " << state->landers.size() << " players, this simulation " << simulation.GetPlayerCount();
+	}
+	state->Dequantize(snapshot, simulation.GetTimeStep());
+	simulation.Restore(snapshot);
+}
+
+StateClientStats StateClient::GetStats()
+{
+	return stats;
+}
+
+void StateClient::ApplyState(const uint8_t* data, int size)
+{
+	uint32_t sequence, baselineSequence;
+	if (!NetStateCodec::ReadHeader(data, size, sequence, baselineSequence))
+		return;
+	const NetWorldState* baseline = nullptr;
+	if (baselineSequence != 0)
+	{
+		baseline = &history[baselineSequence % HistorySize];
+		if (baseline->sequence != baselineSequence || sequence - baselineSequence >= HistorySize)
+		{
+			stats.missingBaseline++;
+			return;
+		}
+	}
+	NetWorldState& state = history[sequence % HistorySize];
+	if (!NetStateCodec::Decode(data, size, baseline, state))
+	{
+		//The slot may hold half a state now
+		state.sequence = 0;
+		return;
+	}
+	latest = sequence;
+	stats.states++;
+	if (!baseline)
+		stats.fullStates++;
+}
+
+void StateClient::SendAck()
+{
+	uint8_t data[NetStateCodec::AckSize];
+	sender.Send((const char*)data, NetStateCodec::EncodeAck(params.port, latest, data));
+	lastAckTime = ofGetElapsedTimef();
+}
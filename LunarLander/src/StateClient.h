@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ofxNetwork.h"
+#include "NetState.h"
+#include "Simulation.h"
+
+struct StateClientParams {
+	std::string server = "127.0.0.1:47900";
+	int port = 47901;	//Where this client receives states
+	float helloInterval = 1.f;	//Seconds between acknowledgements while nothing arrives, to join or rejoin
+};
+
+struct StateClientStats {
+	uint64_t packetsReceived = 0;
+	uint64_t bytesReceived = 0;
+	uint64_t states = 0;	//Decoded and kept
+	uint64_t fullStates = 0;
+	uint64_t stale = 0;	//Older than a state already kept
+	uint64_t missingBaseline = 0;	//Coded against a state this client doesn't have
+	uint64_t incomplete = 0;	//Given up on for a newer state before every fragment arrived
+};
+
+//Receives the state broadcast of a StateServer and keeps the states it acknowledged, as they are the
+//baselines the next packets are coded against
+class StateClient
+{
+	static const int HistorySize = 64;	//The same as the server's
+
+	StateClientParams params;
+	ofxUDPManager receiver;
+	ofxUDPManager sender;
+	std::vector<NetWorldState> history;	//By sequence % HistorySize
+	std::vector<uint8_t> buffer;	//One fragment
+	//The state being put together from its fragments
+	std::vector<uint8_t> assembly;
+	std::vector<bool> assembled;
+	uint32_t assemblySequence = 0;
+	int assemblyReceived = 0;
+	int assemblySize = 0;
+	uint32_t latest = 0;
+	float lastAckTime = -1.f;
+	SimulationSnapshot snapshot;
+	bool warnedPlayerCount = false;
+	StateClientStats stats;
+
+	void SendAck();
+	void ApplyState(const uint8_t* data, int size);
+
+public:
+
+	~StateClient();
+
+	bool Setup(const StateClientParams& params);
+	void Close();
+	//Takes every state that arrived and acknowledges the newest; true when there is a newer one than before
+	bool Update();
+	//The newest state, nullptr before the first one
+	const NetWorldState* GetState();
+	//Moves the simulation's bodies to the newest state, generating the terrain from its seed when the level
+	//changed. The simulation needs as many players as the server's.
+	void Apply(Simulation& simulation);
+	StateClientStats GetStats();
+};
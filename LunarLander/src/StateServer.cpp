@@ -0,0 +1,250 @@
+#include "StateServer.h"
+
+#include <algorithm>
+#include <chrono>
+
+StateServer::~StateServer()
+{
+	Stop();
+}
+
+bool StateServer::Start(const StateServerParams& params)
+{
+	Stop();
+	this->params = params;
+	receiver.Create();
+	if (!receiver.Bind(params.port))
+	{
+		ofLogError("StateServer") << "Couldn't bind port " << params.port;
+		receiver.Close();
+		return false;
+	}
+	receiver.SetNonBlocking(true);
+
+	//Everything the threads use is allocated here, a broadcast only reuses it
+	capture.landers.reserve(4);
+	capture.circles.reserve(64);
+	capture.boxes.reserve(64);
+	history.assign(HistorySize, NetWorldState());
+	codings.assign(MaxCodings + 1, Coding());
+	for (Coding& coding : codings)
+	{
+		coding.data.resize(NetStateCodec::MaxStateSize);
+	}
+	fragment.resize(NetStateCodec::MaxPacketSize);
+	warnedOversized = false;
+	clients.reserve(params.maxClients);
+	sequence = 0;
+	pendingReady = false;
+	stats = StateServerStats();
+	ioStats = StateServerStats();
+	running = true;
+	thread = std::thread(&StateServer::Worker, this);
+	ofLogNotice("StateServer") << "Broadcasting on port " << params.port;
+	return true;
+}
+
+void StateServer::Stop()
+{
+	if (!thread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+		wake.notify_one();
+	}
+	thread.join();
+	while (!clients.empty())
+	{
+		RemoveClient(clients.size() - 1);
+	}
+	receiver.Close();
+}
+
+void StateServer::Publish(Simulation& simulation)
+{
+	if (!thread.joinable())
+		return;
+	simulation.Capture(capture);
+	publishing.Quantize(capture, simulation.GetArenaWidth(), simulation.GetArenaHeight());
+	std::lock_guard<std::mutex> lock(mutex);
+	//The thread gets the buffers of the state and hands back the ones of the state it replaces
+	std::swap(pending, publishing);
+	if (pendingReady)
+		stats.replaced++;
+	pendingReady = true;
+	stats.published++;
+	wake.notify_one();
+}
+
+StateServerStats StateServer::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void StateServer::Worker()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		//Wakes for every published state, and now and then without one to take acknowledgements
+		wake.wait_for(lock, std::chrono::milliseconds(10), [this] { return !running || pendingReady; });
+		if (!running)
+			return;
+
+		NetWorldState* state = nullptr;
+		if (pendingReady)
+		{
+			sequence++;
+			state = &history[sequence % HistorySize];
+			std::swap(*state, pending);
+			state->sequence = sequence;
+			pendingReady = false;
+		}
+
+		//Only this thread touches the history and the clients
+		lock.unlock();
+		ReceiveAcks();
+		if (state)
+			Broadcast(*state);
+		DropSilentClients();
+		lock.lock();
+
+		ioStats.clients = clients.size();
+		ioStats.published = stats.published;
+		ioStats.replaced = stats.replaced;
+		stats = ioStats;
+	}
+}
+
+void StateServer::ReceiveAcks()
+{
+	uint8_t data[NetStateCodec::AckSize];
+	int size;
+	while ((size = receiver.Receive((char*)data, sizeof(data))) > 0)
+	{
+		uint16_t port;
+		uint32_t acked;
+		if (!NetStateCodec::DecodeAck(data, size, port, acked))
+			continue;
+		std::string host;
+		int remotePort;
+		receiver.GetRemoteAddr(host, remotePort);
+
+		Client* client = nullptr;
+		for (Client& c : clients)
+		{
+			if (c.port == port && c.host == host)
+			{
+				client = &c;
+				break;
+			}
+		}
+		if (!client)
+		{
+			if ((int)clients.size() >= params.maxClients)
+				continue;
+			Client added;
+			added.host = host;
+			added.port = port;
+			added.socket = new ofxUDPManager();
+			added.socket->Create();
+			added.socket->Connect(host.c_str(), port);
+			added.socket->SetNonBlocking(true);
+			clients.push_back(added);
+			client = &clients.back();
+			ofLogNotice("StateServer") << "Spectator " << host << ":" << port << " joined";
+		}
+		//Acknowledgements can come out of order, and never for something not sent yet
+		if (acked > client->acked && acked <= sequence)
+			client->acked = acked;
+		client->lastHeardMicros = GetMicros();
+	}
+}
+
+void StateServer::Broadcast(const NetWorldState& state)
+{
+	int codingCount = 0;
+	for (Client& client : clients)
+	{
+		//The baseline has to be the very state the client acknowledged, still in the history
+		const NetWorldState* baseline = nullptr;
+		if (client.acked != 0 && state.sequence - client.acked < HistorySize)
+		{
+			const NetWorldState& candidate = history[client.acked % HistorySize];
+			if (candidate.sequence == client.acked)
+				baseline = &candidate;
+		}
+		uint32_t baselineSequence = baseline ? baseline->sequence : 0;
+
+		Coding* coding = nullptr;
+		for (int i = 0; i < codingCount; i++)
+		{
+			if (codings[i].baseline == baselineSequence)
+			{
+				coding = &codings[i];
+				break;
+			}
+		}
+		if (!coding)
+		{
+			//Past MaxCodings baselines the last slot is recoded per client
+			coding = &codings[std::min(codingCount, (int)MaxCodings)];
+			if (codingCount < MaxCodings)
+				codingCount++;
+			coding->baseline = baselineSequence;
+			coding->size = NetStateCodec::Encode(state, baseline, coding->data.data(), coding->data.size());
+			ioStats.encodes++;
+			if (!baseline)
+				ioStats.fullStates++;
+		}
+		if (coding->size == 0)
+		{
+			if (!warnedOversized)
+			{
+				warnedOversized = true;
+				ofLogError("StateServer") << "More than " << (int)NetStateCodec::MaxEntities << " bodies of a kind, spectators get no states until there are fewer";
+			}
+			ioStats.oversized++;
+			continue;
+		}
+		int count = (coding->size + NetStateCodec::FragmentBytes - 1) / NetStateCodec::FragmentBytes;
+		for (int i = 0; i < count; i++)
+		{
+			int offset = i * NetStateCodec::FragmentBytes;
+			int length = std::min(coding->size - offset, (int)NetStateCodec::FragmentBytes);
+			int size = NetStateCodec::EncodeFragment(state.sequence, i, count, coding->data.data() + offset, length, fragment.data());
+			client.socket->Send((const char*)fragment.data(), size);
+			ioStats.packetsSent++;
+			ioStats.bytesSent += size;
+		}
+	}
+	ioStats.broadcasts++;
+}
+
+void StateServer::DropSilentClients()
+{
+	uint64_t now = GetMicros();
+	uint64_t timeout = (uint64_t)(params.clientTimeout * 1000000.0);
+	for (int i = clients.size() - 1; i >= 0; i--)
+	{
+		if (now - clients[i].lastHeardMicros > timeout)
+		{
+			ofLogNotice("StateServer") << "Spectator " << clients[i].host << ":" << clients[i].port << " timed out";
+			RemoveClient(i);
+		}
+	}
+}
+
+void StateServer::RemoveClient(int idx)
+{
+	clients[idx].socket->Close();
+	delete clients[idx].socket;
+	clients.erase(clients.begin() + idx);
+}
+
+uint64_t StateServer::GetMicros()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ofxNetwork.h"
+#include "NetState.h"
+#include "Simulation.h"
+
+struct StateServerParams {
+	int port = 47900;	//Where acknowledgements come in
+	int maxClients = 64;
+	float clientTimeout = 5.f;	//Seconds without an acknowledgement before a client is dropped
+};
+
+struct StateServerStats {
+	uint64_t published = 0;
+	uint64_t replaced = 0;	//Published states the I/O thread never got to, a newer one took their place
+	uint64_t broadcasts = 0;
+	uint64_t encodes = 0;	//At most one per distinct baseline and broadcast, however many clients share it
+	uint64_t packetsSent = 0;	//Fragments, a state takes one or more
+	uint64_t bytesSent = 0;
+	uint64_t fullStates = 0;	//Sent without a baseline, to new clients or ones that fell too far behind
+	uint64_t oversized = 0;	//States with more entities than the codec takes, not sent
+	int clients = 0;
+};
+
+//Broadcasts the world of an authoritative simulation to spectators: displays and laser projectors that
+//don't simulate anything themselves. The step loop only quantizes the state and hands it over; a separate
+//I/O thread registers clients by their acknowledgements, codes each state against the newest one a client
+//acknowledged and sends it. Clients acknowledging the same state share one coding, so the cost per client
+//stays a send and the bytes per client don't grow with the number of spectators.
+class StateServer
+{
+	static const int HistorySize = 64;	//States kept as baselines, a client further behind gets a full state
+	static const int MaxCodings = 8;	//Distinct baselines coded per broadcast, more are coded into a scratch buffer
+
+	struct Client {
+		std::string host;
+		int port;
+		ofxUDPManager* socket;
+		uint32_t acked = 0;	//Newest state the client has, 0 for none
+		uint64_t lastHeardMicros;
+	};
+
+	struct Coding {
+		uint32_t baseline;
+		int size;
+		std::vector<uint8_t> data;
+	};
+
+	StateServerParams params;
+	ofxUDPManager receiver;
+	std::vector<Client> clients;	//I/O thread only
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool running = false;
+	NetWorldState pending;	//Handed from the step loop to the I/O thread by swapping
+	bool pendingReady = false;
+	StateServerStats stats;
+
+	//Step loop only
+	SimulationSnapshot capture;
+	NetWorldState publishing;
+
+	//I/O thread only
+	std::vector<NetWorldState> history;	//By sequence % HistorySize
+	uint32_t sequence = 0;
+	std::vector<Coding> codings;
+	std::vector<uint8_t> fragment;
+	StateServerStats ioStats;
+	bool warnedOversized = false;
+
+	void Worker();
+	void ReceiveAcks();
+	void Broadcast(const NetWorldState& state);
+	void DropSilentClients();
+	void RemoveClient(int idx);
+	static uint64_t GetMicros();
+
+public:
+
+	~StateServer();
+
+	bool Start(const StateServerParams& params);
+	void Stop();
+	//Hands the current state of the world to the I/O thread, called from the step loop after stepping.
+	//Never waits for the network; a state the thread hasn't taken yet is replaced.
+	void Publish(Simulation& simulation);
+	StateServerStats GetStats();
+};
@@ -0,0 +1,153 @@
+#include "StrokeFont.h"
+
+//One string per character from ' ' to '_': strokes separated by spaces, each a run of x,y digit pairs on
+//the grid, y down
+static const char* const GlyphStrokes[] = {
+	"",	//' '
+	"2024 2526",	//!
+	"1011 3031",	//"
+	"1016 3036 0242 0444",	//#
+	"400003434606 2026",	//$
+	"0640 0001 4546",	//%
+	"",	//&
+	"2021",	//'
+	"30212536",	//(
+	"10212516",	//)
+	"1234 3214 0333",	//*
+	"1333 2224",	//+
+	"2516",	//,
+	"1333",	//-
+	"2526",	//.
+	"0640",	///
+	"0040460600 0640",	//0
+	"112026 1636",	//1
+	"004043030646",	//2
+	"00404606 0343",	//3
+	"000343 4046",	//4
+	"400003434606",	//5
+	"400006464303",	//6
+	"004016",	//7
+	"0040460600 0343",	//8
+	"430300404606",	//9
+	"2122 2425",	//:
+	"2122 2516",	//;
+	"301336",	//<
+	"1232 1434",	//=
+	"103316",	//>
+	"0040422223 2526",	//?
+	"",	//@
+	"0602204246 0343",	//A
+	"06003041423303 3344453606",	//B
+	"40000646",	//C
+	"00304244360600",	//D
+	"40000646 0333",	//E
+	"400006 0333",	//F
+	"400006464323",	//G
+	"0006 4046 0343",	//H
+	"0040 2026 0646",	//I
+	"4045361605",	//J
+	"0006 400346",	//K
+	"000646",	//L
+	"0600234046",	//M
+	"06004640",	//N
+	"0040460600",	//O
+	"0600404303",	//P
+	"0040460600 2346",	//Q
+	"0600404303 1346",	//R
+	"400003434606",	//S
+	"0040 2026",	//T
+	"00064640",	//U
+	"002640",	//V
+	"0006234640",	//W
+	"0046 4006",	//X
+	"002340 2326",	//Y
+	"00400646",	//Z
+	"30000636",	//[
+	"0046",	//backslash
+	"10303616",	//]
+	"022042",	//^
+	"0646",	//_
+};
+
+static const int GridHeight = 6;
+static const int Advance = 6;	//Grid units from one character to the next
+static const int LineAdvance = 10;
+
+StrokeFont::StrokeFont()
+{
+	int glyphCount = sizeof(GlyphStrokes) / sizeof(GlyphStrokes[0]);
+	for (int c = 0; c < 128; c++)
+	{
+		glyphs[c] = { 0, 0 };
+	}
+	for (int g = 0; g < glyphCount; g++)
+	{
+		StrokeSpan& glyph = glyphs[' ' + g];
+		glyph.first = strokes.size();
+		const char* in = GlyphStrokes[g];
+		while (*in)
+		{
+			if (*in == ' ')
+			{
+				in++;
+				continue;
+			}
+			StrokeSpan stroke = { (int)points.size(), 0 };
+			while (in[0] >= '0' && in[0] <= '9' && in[1] >= '0' && in[1] <= '9')
+			{
+				points.push_back(ofVec2f((float)(in[0] - '0'), (float)(in[1] - '0')));
+				stroke.count++;
+				in += 2;
+			}
+			if (stroke.count == 0)
+			{
+				ofLogError("StrokeFont") << "Bad stroke in glyph " << (char)(' ' + g);
+				break;
+			}
+			strokes.push_back(stroke);
+		}
+		glyph.count = strokes.size() - glyph.first;
+	}
+	for (int c = 'a'; c <= 'z'; c++)
+	{
+		glyphs[c] = glyphs[c - 'a' + 'A'];
+	}
+}
+
+const StrokeFont& StrokeFont::Get()
+{
+	static StrokeFont font;
+	return font;
+}
+
+void StrokeFont::Layout(const char* text, int length, ofVec2f origin, float size, std::vector<ofVec2f>& points, std::vector<StrokeSpan>& strokes) const
+{
+	float unit = size / GridHeight;
+	ofVec2f cursor = origin;
+	for (int i = 0; i < length; i++)
+	{
+		unsigned char c = text[i];
+		if (c == '\n')
+		{
+			cursor.x = origin.x;
+			cursor.y += LineAdvance * unit;
+			continue;
+		}
+		const StrokeSpan& glyph = glyphs[c & 127];
+		for (int s = glyph.first; s < glyph.first + glyph.count; s++)
+		{
+			const StrokeSpan& stroke = this->strokes[s];
+			strokes.push_back({ (int)points.size(), stroke.count });
+			for (int p = stroke.first; p < stroke.first + stroke.count; p++)
+			{
+				points.push_back(cursor + this->points[p] * unit);
+			}
+		}
+		cursor.x += Advance * unit;
+	}
+}
+
+float StrokeFont::GetLineHeight(float size)
+{
+	return size / GridHeight * LineAdvance;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include "ofMain.h"
+
+struct StrokeSpan {
+	int first;	//First point of the stroke
+	int count;
+};
+
+//Vector font every output can draw, the laser included: a glyph is a few open polylines on a 4 by 6 grid,
+//parsed once per process. Lower case is drawn as upper case, characters without a glyph as a space.
+class StrokeFont
+{
+	std::vector<ofVec2f> points;
+	std::vector<StrokeSpan> strokes;
+	StrokeSpan glyphs[128];	//Strokes of each character
+
+	StrokeFont();
+
+public:
+
+	static const int MaxPointsPerGlyph = 16;
+	static const int MaxStrokesPerGlyph = 4;
+
+	static const StrokeFont& Get();
+
+	//Appends the strokes of text with its top left corner at origin, size is the height of a capital.
+	//Allocates nothing when points and strokes have room for MaxPointsPerGlyph and MaxStrokesPerGlyph per character.
+	void Layout(const char* text, int length, ofVec2f origin, float size, std::vector<ofVec2f>& points, std::vector<StrokeSpan>& strokes) const;
+	static float GetLineHeight(float size);
+};
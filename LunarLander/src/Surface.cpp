@@ -16,36 +16,31 @@ Surface::Surface(ofxBox2d* world)
 	goalTriggerBody = world->getWorld()->CreateBody(&goalTriggerBodyDef);
 }
 
-void Surface::GenerateSurface(SurfaceGenerationParams params)
+void Surface::GenerateSurface(const SurfaceGenerationParams& params, uint32_t seed)
 {
+	GenerateTerrain(params, seed, terrain);
+	ApplyTerrain(terrain);
+}
 
-	//Clear bprevious surface
-	if (graphics.size() > 0)
-	{
-		graphics.clear();
-		physics->Clear();
-		physicsBody->DestroyFixture(fixture);
-		for (auto f : goalTriggerFixtures)
-		{
-			goalTriggerBody->DestroyFixture(f);
-		}
-		goalTriggerFixtures.clear();
-	}
-
-	b2Vec2* physVerts = new b2Vec2 [params.numPoints];
+void Surface::GenerateTerrain(const SurfaceGenerationParams& params, uint32_t seed, TerrainData& out, const TerrainEdges* edges)
+{
+	//A local generator, the terrain depends on nothing but the seed
+	FastRandom random(seed);
+	out.seed = seed;
+	out.params = params;
+	out.heights.resize(params.numPoints);
+	out.plateaus.clear();
 
 	//Calculate initial params for surface creation
-	float pointSeparation = 1.f / params.numPoints * ScreenWidth; //The distance between two points on the x axis
-	float lastHeight = ofRandom(params.minHeight, params.maxHeight); //The height of the last vertex (for plateau and even terrain)
-	graphics.setClosed(false);	//our polyline should stay open
+	float lastHeight = edges ? edges->start : random.Range(params.minHeight, params.maxHeight); //The height of the last vertex (for plateau and even terrain)
 	float currentHeight;	//The y axis of the current vertex
 
 	//Calculate initial params for plateau generation
 	bool generatePlateau = false;	//flag true if we are generating a plateau
-	int plateauSpacing = params.numPoints / params.plateauCount;	//The maximum even spacing of plateaus
+	int plateauSpacing = params.numPoints / std::max(params.plateauCount, 1);	//The maximum even spacing of plateaus
 	int nextPlateauIdx = 0;	//The index of the next (and current) plateau we are doing
-	int nextPlateauStartIdx = rand() % plateauSpacing; //The index of the vertex where the next plateau will start (or the current plateau started)
-	int plateauSegmentRemain = (rand() % (params.maxPlateauSize - params.minPlateauSize)) + params.minPlateauSize; //The amount of vertexes the next plateau will have (or the current plateau has left)
+	int nextPlateauStartIdx = random.Range(plateauSpacing); //The index of the vertex where the next plateau will start (or the current plateau started)
+	int plateauSegmentRemain = random.Range(params.maxPlateauSize - params.minPlateauSize) + params.minPlateauSize; //The amount of vertexes the next plateau will have (or the current plateau has left)
 
 	//Main generation loop
 	for (int i = 0; i < params.numPoints; i++)
@@ -60,42 +55,89 @@ void Surface::GenerateSurface(SurfaceGenerationParams params)
 				generatePlateau = false;
 				//calculate params for the next plateau
 				nextPlateauIdx++;
-				nextPlateauStartIdx = (rand() % ((nextPlateauIdx + 1) * plateauSpacing - i)) + i;
-				plateauSegmentRemain = (rand() % (params.maxPlateauSize - params.minPlateauSize)) + params.minPlateauSize;
+				nextPlateauStartIdx = random.Range((nextPlateauIdx + 1) * plateauSpacing - i) + i;
+				plateauSegmentRemain = random.Range(params.maxPlateauSize - params.minPlateauSize) + params.minPlateauSize;
 			}
 			currentHeight = lastHeight;
 		}
 		//mountain generation
 		else 
 		{
-			currentHeight = ofRandom(std::max(lastHeight - params.maxHeightDiff, params.minHeight), std::min(lastHeight + params.maxHeightDiff, params.maxHeight));
-			if (nextPlateauIdx < params.plateauCount && i >= nextPlateauStartIdx)
+			float low = std::max(lastHeight - params.maxHeightDiff, params.minHeight);
+			float high = std::min(lastHeight + params.maxHeightDiff, params.maxHeight);
+			bool canPlateau = true;
+			if (edges)
+			{
+				//Never wander further from the end height than the remaining vertices can climb back
+				float reach = params.maxHeightDiff * (params.numPoints - 1 - i);
+				low = std::max(low, edges->end - reach);
+				high = std::min(high, edges->end + reach);
+			}
+			currentHeight = edges && i == 0 ? edges->start : random.Range(low, high);
+			if (edges)
+			{
+				//A plateau keeps its height, it has to end early enough to still reach the end height
+				canPlateau = std::abs(edges->end - currentHeight) <= params.maxHeightDiff * (params.numPoints - 1 - i - plateauSegmentRemain);
+			}
+			if (nextPlateauIdx < params.plateauCount && i >= nextPlateauStartIdx && canPlateau)
 			{
 				generatePlateau = true;
-				b2Fixture* triggerBox = CreateTriggerBox(
-					ofVec2f(pointSeparation * plateauSegmentRemain, params.maxHeightDiff * 200.f), 
-					ofVec2f(pointSeparation * (plateauSegmentRemain / 2.f + i), currentHeight * ScreenHeight - params.maxHeightDiff * 100.f)
-				);
-				goalTriggerFixtures.push_back(triggerBox);
+				out.plateaus.push_back({ i, plateauSegmentRemain, currentHeight });
 			}
 		}
 
-		graphics.addVertex(pointSeparation * i, currentHeight * ScreenHeight, 0.f);
-		physVerts[i] = screenPtToWorldPt(ofVec2f(pointSeparation * i, currentHeight * ScreenHeight));
+		out.heights[i] = currentHeight;
 		lastHeight = currentHeight;
 	}
+}
 
-	//Create physical body
-	physics = new b2ChainShape();
-	physics->CreateChain(physVerts, params.numPoints);
-	fixtureDef.isSensor = false;
-	fixtureDef.shape = physics;
-	fixtureDef.friction = friction;
-	fixtureDef.restitution = bounce;
+void Surface::ApplyTerrain(const TerrainData& data)
+{
+	if (&data != &terrain)
+		terrain = data;	//Vector assignment reuses the capacity we already have
 
-	fixture = physicsBody->CreateFixture(&fixtureDef);
+	int numPoints = terrain.heights.size();
+	float pointSeparation = 1.f / numPoints * ScreenWidth; //The distance between two points on the x axis
+
+	graphics.clear();
+	graphics.setClosed(false);	//our polyline should stay open
+	physVerts.resize(numPoints);
+	for (int i = 0; i < numPoints; i++)
+	{
+		float y = terrain.heights[i] * ScreenHeight;
+		graphics.addVertex(pointSeparation * i, y, 0.f);
+		physVerts[i] = screenPtToWorldPt(ofVec2f(pointSeparation * i, y));
+	}
+	ApplyChain();
+
+	float padHeight = terrain.params.maxHeightDiff * 200.f;
+	for (int i = 0; i < (int)terrain.plateaus.size(); i++)
+	{
+		const TerrainPlateau& plateau = terrain.plateaus[i];
+		ApplyTriggerBox(i,
+			ofVec2f(pointSeparation * plateau.length, padHeight),
+			ofVec2f(pointSeparation * (plateau.length / 2.f + plateau.startIdx), plateau.height * ScreenHeight - padHeight / 2.f)
+		);
+	}
+	//Drop the trigger boxes of a previous level with more plateaus
+	while (goalTriggerFixtures.size() > terrain.plateaus.size())
+	{
+		goalTriggerBody->DestroyFixture(goalTriggerFixtures.back());
+		goalTriggerFixtures.pop_back();
+	}
 
-	delete[] physVerts;
+	laserTolerance = -1.f;
+
+	//Shapes rewritten in place need their broadphase proxies refreshed
+	physicsBody->SetTransform(physicsBody->GetPosition(), physicsBody->GetAngle());
+	goalTriggerBody->SetTransform(goalTriggerBody->GetPosition(), goalTriggerBody->GetAngle());
+}
+
+void Surface::SwapTerrain(TerrainData& data)
+{
+	//The caller gets the previous level's buffers back to generate into
+	std::swap(terrain, data);
+	ApplyTerrain(terrain);
 }
 
 void Surface::SetScreenSize(int screenWidth, int screenHeight)
@@ -114,6 +156,7 @@ void Surface::SetScreenSize(int screenWidth, int screenHeight)
 
 	ScreenWidth = screenWidth;
 	ScreenHeight = screenHeight;
+	laserTolerance = -1.f;
 }
 
 void Surface::SetPhysicalParams(float friction, float bounce)
@@ -122,28 +165,83 @@ void Surface::SetPhysicalParams(float friction, float bounce)
 	this->bounce = bounce;
 }
 
+uint32_t Surface::GetSeed()
+{
+	return terrain.seed;
+}
+
+const TerrainData& Surface::GetTerrain()
+{
+	return terrain;
+}
 
-void Surface::Draw()
+void Surface::Record(DrawList& list, float tolerance)
 {
-	graphics.draw();
+	if (tolerance != laserTolerance)
+	{
+		padVertices.clear();
+		for (const TerrainPlateau& plateau : terrain.plateaus)
+		{
+			padVertices.push_back(plateau.startIdx);
+			padVertices.push_back(plateau.startIdx + plateau.length);
+		}
+		simplifier.Simplify(graphics, tolerance, padVertices, laserGraphics);
+		laserTolerance = tolerance;
+	}
+	list.AddPolyline(graphics, laserGraphics, ofColor::white, 0, DrawStatic);
 }
 
 Surface::~Surface()
 {
 }
 
-b2Fixture* Surface::CreateTriggerBox(ofVec2f size, ofVec2f center)
+void Surface::ApplyChain()
 {
-	b2PolygonShape triggerBox;
-	b2Vec2 b2size = screenPtToWorldPt(size / 2.f);//b2Vec2(size.x / 2.f, size.y / 2.f);
+	int count = physVerts.size();
+	if (fixture)
+	{
+		b2ChainShape* chain = (b2ChainShape*)fixture->GetShape();
+		if (chain->m_count == count)
+		{
+			//Same vertex count: rewrite the fixture's own chain instead of reallocating it
+			std::copy(physVerts.begin(), physVerts.end(), chain->m_vertices);
+			fixture->SetFriction(friction);
+			fixture->SetRestitution(bounce);
+			return;
+		}
+		physicsBody->DestroyFixture(fixture);
+	}
+
+	//Create physical body
+	physics.CreateChain(physVerts.data(), count);
+	fixtureDef.isSensor = false;
+	fixtureDef.filter.categoryBits = ContactTag::TagTerrain;
+	fixtureDef.shape = &physics;
+	fixtureDef.friction = friction;
+	fixtureDef.restitution = bounce;
+
+	fixture = physicsBody->CreateFixture(&fixtureDef);
+	physics.Clear();
+}
+
+void Surface::ApplyTriggerBox(int idx, ofVec2f size, ofVec2f center)
+{
+	b2Vec2 b2size = screenPtToWorldPt(size / 2.f);
 	b2Vec2 b2center = screenPtToWorldPt(center);
+	if (idx < (int)goalTriggerFixtures.size())
+	{
+		//Reuse the box of the previous level
+		((b2PolygonShape*)goalTriggerFixtures[idx]->GetShape())->SetAsBox(b2size.x, b2size.y, b2center, 0.f);
+		return;
+	}
+
+	b2PolygonShape triggerBox;
 	triggerBox.SetAsBox(b2size.x, b2size.y, b2center, 0.f);
 	b2FixtureDef def;
 	def.isSensor = true;
+	def.filter.categoryBits = ContactTag::TagLandingPad;
 	def.shape = &triggerBox;
-	b2Fixture* fixture = goalTriggerBody->CreateFixture(&def);
-	ofLogNotice("Surface") << "Creating trigger box \n\tfrom\tS:" << ofToString(size) << "\tC:" << ofToString(center) << "\n\tto:\tS:(" << ofToString(b2size.x) << "," << ofToString(b2size.y) << ")\tC:(" << ofToString(b2center.x) << "," << ofToString(b2center.y) << ")\n";
-	return fixture;
+	goalTriggerFixtures.push_back(goalTriggerBody->CreateFixture(&def));
 }
 
 b2Body* Surface::GetBody()
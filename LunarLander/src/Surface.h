@@ -2,6 +2,9 @@
 
 #include "ofPolyline.h"
 #include "ofxBox2d.h"
+#include "Random.h"
+#include "LaserLod.h"
+#include "DrawList.h"
 
 struct SurfaceGenerationParams {
 	float minHeight;
@@ -13,40 +16,79 @@ struct SurfaceGenerationParams {
 	int plateauCount;
 };
 
+struct TerrainPlateau {
+	int startIdx;	//First vertex of the plateau
+	int length;	//Vertex count of the plateau
+	float height;	//Normalized height, like the vertices
+};
+
+//Screen independent result of a terrain generation, the same seed and params always give the same data
+struct TerrainData {
+	uint32_t seed = 0;
+	SurfaceGenerationParams params;
+	std::vector<float> heights;	//Normalized vertex heights, evenly spaced over the screen width
+	std::vector<TerrainPlateau> plateaus;
+};
+
+//Fixed heights for the first and last vertex, so separately generated pieces of terrain line up.
+//The generator needs (maxHeight - minHeight) / maxHeightDiff vertices to get from one to the other.
+struct TerrainEdges {
+	float start;
+	float end;
+};
+
 class Surface
 {
 private:
 
 	ofxBox2d* world;
-	b2ChainShape* physics;
+	b2ChainShape physics;	//Only used to create the fixture, which keeps its own copy
 	b2Body* physicsBody;
 	b2BodyDef physicsBodyDef;
-	b2Fixture* fixture;
+	b2Fixture* fixture = nullptr;
 	b2FixtureDef fixtureDef;
 
 	b2BodyDef goalTriggerBodyDef;
 	b2Body* goalTriggerBody;
 	std::vector<b2Fixture*> goalTriggerFixtures;
 
+	//Persistent buffers, regenerating a level of the same size does not allocate
+	TerrainData terrain;
+	std::vector<b2Vec2> physVerts;
+
 	ofPolyline graphics;
 	int ScreenWidth, ScreenHeight;
 
+	//Simplified copy of graphics for the laser outline, rebuilt when the tolerance or the terrain changes
+	PolylineSimplifier simplifier;
+	ofPolyline laserGraphics;
+	float laserTolerance = -1.f;
+	std::vector<int> padVertices;	//Plateau edges, never simplified away
+
 	float friction = .5f;
 	float bounce = .5f;
 
 public:
 
 	Surface(ofxBox2d* world);
-	void GenerateSurface(SurfaceGenerationParams params);
+	void GenerateSurface(const SurfaceGenerationParams& params, uint32_t seed);
+	void ApplyTerrain(const TerrainData& data);
+	void SwapTerrain(TerrainData& data);
 	void SetScreenSize(int screenWidth, int screenHeight);
 	void SetPhysicalParams(float friction, float bounce);
+	uint32_t GetSeed();
+	const TerrainData& GetTerrain();
 	b2Body* GetBody();
 	b2Body* GetLandingSpotBody();
-	void Draw();
+	//Records the terrain, the laser outline is simplified to the tolerance in screen units
+	void Record(DrawList& list, float tolerance = 0.f);
 	~Surface();
 
+	static void GenerateTerrain(const SurfaceGenerationParams& params, uint32_t seed, TerrainData& out, const TerrainEdges* edges = nullptr);
+
 private:
 
-	b2Fixture* CreateTriggerBox(ofVec2f size, ofVec2f center);
+	void ApplyChain();
+	void ApplyTriggerBox(int idx, ofVec2f size, ofVec2f center);
 };
 
@@ -0,0 +1,100 @@
+#include "SvgDrawBackend.h"
+
+#include <cstdio>
+
+static std::string ToSvgColor(const ofColor& color)
+{
+	char buffer[8];
+	snprintf(buffer, sizeof(buffer), "#%02x%02x%02x", color.r, color.g, color.b);
+	return buffer;
+}
+
+void SvgDrawBackend::SetSize(int width, int height)
+{
+	this->width = width;
+	this->height = height;
+}
+
+void SvgDrawBackend::Draw(const DrawList& list)
+{
+	document.clear();
+	document += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	document += "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" + ofToString(width) + "\" height=\"" + ofToString(height) + "\">\n";
+	document += "<rect width=\"100%\" height=\"100%\" fill=\"black\"/>\n";
+	for (const DrawCommand& command : list.GetCommands())
+	{
+		if (command.flags & DrawRasterOnly)
+			continue;
+		if (command.type == DrawCommandType::Polyline)
+			AddPolyline(list, command);
+		else if (command.type == DrawCommandType::Text)
+			AddText(list, command);
+	}
+	document += "</svg>\n";
+}
+
+const std::string& SvgDrawBackend::GetDocument()
+{
+	return document;
+}
+
+bool SvgDrawBackend::Save(const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		ofLogError("SvgDrawBackend") << "Couldn't open " << path << " for writing";
+		return false;
+	}
+	bool written = fwrite(document.data(), 1, document.size(), file) == document.size();
+	fclose(file);
+	return written;
+}
+
+void SvgDrawBackend::AddPolyline(const DrawList& list, const DrawCommand& command)
+{
+	if (command.count == 0)
+		return;
+	DrawTransform transform = list.GetFullTransform(command);
+	bool closed = (command.flags & DrawClosed) != 0;
+	bool filled = (command.flags & DrawFilled) != 0;
+	document += closed ? "<polygon points=\"" : "<polyline points=\"";
+	char buffer[32];
+	for (uint32_t i = 0; i < command.count; i++)
+	{
+		ofVec2f point = DrawList::Apply(transform, list.GetVertices()[command.first + i]);
+		snprintf(buffer, sizeof(buffer), "%.2f,%.2f ", point.x, point.y);
+		document += buffer;
+	}
+	std::string color = ToSvgColor(command.color);
+	document += "\" fill=\"" + (filled ? color : std::string("none")) + "\" stroke=\"" + color + "\"/>\n";
+}
+
+void SvgDrawBackend::AddText(const DrawList& list, const DrawCommand& command)
+{
+	DrawTransform transform = list.GetFullTransform(command);
+	document += "<text x=\"" + ofToString(transform.translation.x) + "\" y=\"" + ofToString(transform.translation.y) + "\" fill=\"" + ToSvgColor(command.color) + "\" font-family=\"monospace\" font-size=\"11\" xml:space=\"preserve\">";
+	//One tspan per line, SVG text doesn't break on newlines
+	std::string text(list.GetText() + command.first, command.count);
+	bool firstLine = true;
+	for (const std::string& line : ofSplitString(text, "\n", false, false))
+	{
+		if (line.empty())
+			continue;
+		document += "<tspan x=\"" + ofToString(transform.translation.x) + "\"" + (firstLine ? "" : " dy=\"13\"") + ">";
+		for (char c : line)
+		{
+			if (c == '<')
+				document += "&lt;";
+			else if (c == '>')
+				document += "&gt;";
+			else if (c == '&')
+				document += "&amp;";
+			else
+				document += c;
+		}
+		document += "</tspan>";
+		firstLine = false;
+	}
+	document += "</text>\n";
+}
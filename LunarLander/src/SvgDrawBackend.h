@@ -0,0 +1,22 @@
+#pragma once
+
+#include "DrawList.h"
+
+//Writes a list as an SVG document, at full detail, for comparing frames outside the app.
+//Like the laser it only sees vector geometry: raster only commands are skipped, text is kept.
+class SvgDrawBackend : public DrawBackend
+{
+	int width = 1024;
+	int height = 768;
+	std::string document;
+
+	void AddPolyline(const DrawList& list, const DrawCommand& command);
+	void AddText(const DrawList& list, const DrawCommand& command);
+
+public:
+
+	void SetSize(int width, int height);
+	void Draw(const DrawList& list) override;
+	const std::string& GetDocument();
+	bool Save(const std::string& path);
+};
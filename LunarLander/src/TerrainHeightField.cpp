@@ -0,0 +1,43 @@
+#include "TerrainHeightField.h"
+
+void TerrainHeightField::Setup(const TerrainData& terrain, int screenWidth, int screenHeight)
+{
+	//The same mapping as Surface::ApplyTerrain, in world units
+	int numPoints = terrain.heights.size();
+	spacing = screenWidth / (float)std::max(numPoints, 1) / OFX_BOX2D_SCALE;
+	invSpacing = 1.f / spacing;
+	width = screenWidth / OFX_BOX2D_SCALE;
+	height = screenHeight / OFX_BOX2D_SCALE;
+	heights.resize(std::max(numPoints, 1));
+	heights[0] = height;
+	top = height;
+	for (int i = 0; i < numPoints; i++)
+	{
+		heights[i] = terrain.heights[i] * screenHeight / OFX_BOX2D_SCALE;
+		top = std::min(top, heights[i]);
+	}
+
+	pads.assign(heights.size(), 0);
+	for (const TerrainPlateau& plateau : terrain.plateaus)
+	{
+		for (int i = plateau.startIdx; i < plateau.startIdx + plateau.length && i < (int)pads.size(); i++)
+		{
+			pads[i] = 1;
+		}
+	}
+}
+
+float TerrainHeightField::GetTop() const
+{
+	return top;
+}
+
+float TerrainHeightField::GetWidth() const
+{
+	return width;
+}
+
+float TerrainHeightField::GetArenaHeight() const
+{
+	return height;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include "Surface.h"
+
+//Ground height over x of a generated level in world units, for testing against the terrain without Box2D.
+//The terrain is a polyline over evenly spaced vertices, so one sample per vertex and a linear blend
+//between two of them give exactly the height the chain shape has.
+class TerrainHeightField
+{
+	std::vector<float> heights;	//World y of every vertex, y grows downwards
+	std::vector<uint8_t> pads;	//Per segment, 1 where it belongs to a landing plateau
+	float spacing = 1.f;	//World units between two vertices
+	float invSpacing = 1.f;
+	float top = 0.f;	//Highest ground, the smallest y
+	float width = 0.f;
+	float height = 0.f;
+
+public:
+
+	//Screen size the terrain was applied with, as the Surface maps it
+	void Setup(const TerrainData& terrain, int screenWidth, int screenHeight);
+
+	//Ground under x, the end vertices continue flat past the terrain
+	float GetHeight(float x) const
+	{
+		float t = x * invSpacing;
+		if (t <= 0.f)
+			return heights.front();
+		int idx = (int)t;
+		if (idx >= (int)heights.size() - 1)
+			return heights.back();
+		return heights[idx] + (heights[idx + 1] - heights[idx]) * (t - idx);
+	}
+
+	bool IsPad(float x) const
+	{
+		int idx = (int)(x * invSpacing);
+		return idx >= 0 && idx < (int)pads.size() && pads[idx];
+	}
+
+	float GetTop() const;
+	float GetWidth() const;	//Of the arena the terrain spans
+	float GetArenaHeight() const;
+};
@@ -0,0 +1,91 @@
+#include "TerrainPrefetcher.h"
+
+TerrainPrefetcher::TerrainPrefetcher(int depth)
+{
+	slots.resize(std::max(depth, 1));
+}
+
+TerrainPrefetcher::~TerrainPrefetcher()
+{
+	Stop();
+}
+
+void TerrainPrefetcher::Start(const SurfaceGenerationParams& params, uint32_t firstSeed)
+{
+	Stop();
+	this->params = params;
+	Restart(firstSeed);
+	running = true;
+	thread = std::thread(&TerrainPrefetcher::Worker, this);
+}
+
+void TerrainPrefetcher::Restart(uint32_t firstSeed)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	generation++;
+	for (Slot& slot : slots)
+	{
+		slot.ready = false;
+	}
+	readIdx = 0;
+	writeIdx = 0;
+	nextSeed = firstSeed;
+	wake.notify_one();
+}
+
+void TerrainPrefetcher::Stop()
+{
+	if (!thread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+		wake.notify_one();
+	}
+	thread.join();
+}
+
+bool TerrainPrefetcher::Take(uint32_t seed, TerrainData& terrain)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Slot& slot = slots[readIdx];
+	if (!slot.ready || slot.terrain.seed != seed)
+		return false;
+
+	//Swapping hands the caller's old buffers to the worker for reuse, nothing is copied or allocated
+	std::swap(slot.terrain, terrain);
+	slot.ready = false;
+	readIdx = (readIdx + 1) % slots.size();
+	wake.notify_one();
+	return true;
+}
+
+uint32_t TerrainPrefetcher::NextSeed(uint32_t seed)
+{
+	return FastRandom(seed).Next();
+}
+
+void TerrainPrefetcher::Worker()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		wake.wait(lock, [this] { return !running || !slots[writeIdx].ready; });
+		if (!running)
+			return;
+
+		//Only the worker touches a slot that is not ready, so it is filled without holding the lock
+		Slot& slot = slots[writeIdx];
+		uint32_t seed = nextSeed;
+		uint64_t jobGeneration = generation;
+		lock.unlock();
+		Surface::GenerateTerrain(params, seed, slot.terrain);
+		lock.lock();
+
+		if (jobGeneration != generation)
+			continue;
+		slot.ready = true;
+		writeIdx = (writeIdx + 1) % slots.size();
+		nextSeed = NextSeed(seed);
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "Surface.h"
+
+//Generates the terrain of the next few levels on a worker thread, so starting a level only has to swap
+//the finished data in. Levels follow the seed chain of Simulation: each seed is derived from the previous one.
+class TerrainPrefetcher
+{
+	struct Slot {
+		TerrainData terrain;
+		bool ready = false;	//Filled by the worker and waiting to be taken
+	};
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+
+	std::vector<Slot> slots;	//Ring of upcoming levels, in seed chain order
+	int readIdx = 0;	//Next slot handed out by Take
+	int writeIdx = 0;	//Next slot the worker fills
+	uint32_t nextSeed = 1;	//Seed of the level going into writeIdx
+	uint64_t generation = 0;	//Bumped by Restart, so work on a stale chain is dropped
+
+	SurfaceGenerationParams params;
+	bool running = false;
+
+	void Worker();
+
+public:
+
+	TerrainPrefetcher(int depth = 2);
+	~TerrainPrefetcher();
+
+	void Start(const SurfaceGenerationParams& params, uint32_t firstSeed);
+	void Restart(uint32_t firstSeed);
+	void Stop();
+	bool Take(uint32_t seed, TerrainData& terrain);
+
+	static uint32_t NextSeed(uint32_t seed);
+};
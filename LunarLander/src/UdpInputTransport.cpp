@@ -0,0 +1,58 @@
+#include "UdpInputTransport.h"
+
+UdpInputTransport::~UdpInputTransport()
+{
+	Close();
+}
+
+bool UdpInputTransport::Setup(const UdpInputTransportParams& params)
+{
+	Close();
+	receiver.Create();
+	if (!receiver.Bind(params.port))
+	{
+		ofLogError("UdpInputTransport") << "Couldn't bind port " << params.port;
+		return false;
+	}
+	receiver.SetNonBlocking(true);
+	for (const std::string& peer : params.peers)
+	{
+		auto hostPort = ofSplitString(peer, ":");
+		if (hostPort.size() != 2)
+		{
+			ofLogError("UdpInputTransport") << "Peer " << peer << " is not host:port";
+			return false;
+		}
+		ofxUDPManager* sender = new ofxUDPManager();
+		sender->Create();
+		sender->Connect(hostPort[0].c_str(), ofToInt(hostPort[1]));
+		sender->SetNonBlocking(true);
+		senders.push_back(sender);
+	}
+	return true;
+}
+
+void UdpInputTransport::Close()
+{
+	for (ofxUDPManager* sender : senders)
+	{
+		sender->Close();
+		delete sender;
+	}
+	senders.clear();
+	receiver.Close();
+}
+
+void UdpInputTransport::Send(const uint8_t* data, int size)
+{
+	for (ofxUDPManager* sender : senders)
+	{
+		sender->Send((const char*)data, size);
+	}
+}
+
+int UdpInputTransport::Receive(uint8_t* data, int capacity)
+{
+	int size = receiver.Receive((char*)data, capacity);
+	return size > 0 ? size : 0;
+}
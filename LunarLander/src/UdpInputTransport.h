@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ofxNetwork.h"
+#include "InputTransport.h"
+
+struct UdpInputTransportParams {
+	int port = 47800;	//Where this peer receives
+	std::vector<std::string> peers;	//host:port of every other peer
+};
+
+//InputTransport over non-blocking UDP sockets: one bound socket receives from everyone, one connected
+//socket per peer sends
+class UdpInputTransport : public InputTransport
+{
+	ofxUDPManager receiver;
+	std::vector<ofxUDPManager*> senders;
+
+public:
+
+	~UdpInputTransport();
+
+	bool Setup(const UdpInputTransportParams& params);
+	void Close();
+
+	void Send(const uint8_t* data, int size) override;
+	int Receive(uint8_t* data, int capacity) override;
+};
@@ -1,13 +1,57 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include <cstdlib>
+#include <cstring>
+#ifdef LUNAR_HEADLESS
+#include "HeadlessRunner.h"
+#endif
 
 //========================================================================
 int main(int argc, char** argv){
+#ifdef LUNAR_HEADLESS
+	// headless build: no window, no GL context and no frame limiter,
+	// the simulation is stepped as fast as the cpu allows
+	HeadlessRunner runner;
+	return runner.Run(argc, argv);
+#else
 	ofSetupOpenGL(1024,768,OF_WINDOW);			// <-------- setup the GL context
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
 	// pass in width and height too:
-	ofRunApp(new ofApp());
+	bool streamingTerrain = false;
+	std::string dacAddress;
+	std::string ildaRecordPath;
+	std::string inputRecordPath;
+	NetPlayParams netPlay;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--streaming"))
+			streamingTerrain = true;
+		else if (!strcmp(argv[i], "--dac") && i + 1 < argc)
+			dacAddress = argv[++i];
+		else if (!strcmp(argv[i], "--ilda-record") && i + 1 < argc)
+			ildaRecordPath = argv[++i];
+		else if (!strcmp(argv[i], "--record-input") && i + 1 < argc)
+			inputRecordPath = argv[++i];
+		else if (!strcmp(argv[i], "--net-player") && i + 1 < argc)
+			netPlay.localPlayer = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--net-peers") && i + 1 < argc)
+			netPlay.peers = ofSplitString(argv[++i], ",", true, true);
+		else if (!strcmp(argv[i], "--net-seed") && i + 1 < argc)
+			netPlay.seed = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--net-rollback") && i + 1 < argc)
+			netPlay.maxRollbackTicks = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--serve") && i + 1 < argc)
+			netPlay.servePort = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--spectate") && i + 1 < argc)
+			netPlay.spectate = argv[++i];
+		else if (!strcmp(argv[i], "--spectate-port") && i + 1 < argc)
+			netPlay.spectatePort = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--players") && i + 1 < argc)
+			netPlay.spectatePlayers = atoi(argv[++i]);
+	}
+	ofRunApp(new ofApp(streamingTerrain, dacAddress, ildaRecordPath, inputRecordPath, netPlay));
+#endif
 
 }
@@ -1,129 +1,212 @@
 #include "ofApp.h"
-#include "ContactListeners.h"
+
+//--------------------------------------------------------------
+ofApp::ofApp(bool streamingTerrain, std::string dacAddress, std::string ildaRecordPath, std::string inputRecordPath, NetPlayParams netPlay){
+	this->streamingTerrain = streamingTerrain;
+	this->dacAddress = dacAddress;
+	this->ildaRecordPath = ildaRecordPath;
+	this->inputRecordPath = inputRecordPath;
+	this->netPlay = netPlay;
+}
 
 //--------------------------------------------------------------
 void ofApp::setup(){
 	ofSetFrameRate(60);
 	ofBackground(0);
-	
-	world.init();
-	world.setGravity(0, 1);
-	world.createBounds();
-	world.setFPS(60);
-	world.getWorld()->SetDebugDraw(&world.debugRender);
-	
-	world.getWorld()->SetContactListener(LunarLanderConatactManager::Get());
-
-	surf = new Surface(&world);
-	surfGenerationParams = { 
-		.5f,	//minHeight
-		.95f,	//maxHeight
-		200,	//numPoints
-		.05f, 	//maxHeightDiff
-		4, 		//minPlateauSize
-		8, 		//maxPlateauSize
-		3		//plateauCount
-	};
-	surf->SetScreenSize(ofGetWindowWidth(), ofGetWindowHeight());
-	surf->GenerateSurface(surfGenerationParams);
-
-	landerParams = { 
-		5.f,					//angularDamping
-		.01f,					//linearDamping
-		1.f, 					//density
-		.1f, 					//friction
-		.1f,					//bounce
-		ofVec2f(200.f, 100.f),	//startingPos
-		3.f						//startVelocity
-	};
-	lander = new Lander(&world, landerParams, ofVec2f(.65f, .6f), ofVec2f(.8f, .4f), "lander");
-	lander->SetScale(20);
-
-	LandingSpotContactListener* landingListener = new LandingSpotContactListener(this, lander->GetBody());
-	landingListener->SetBodyFilter(surf->GetLandingSpotBody());
-	LunarLanderConatactManager::Get()->SetCallback(landingListener, ContactCallbackFlag::BeginContact | ContactCallbackFlag::EndContact);
-	
-	lander->Sleep();
-	gameState = GameState::Landed;
+
+	simulation.SetStreamingTerrain(streamingTerrain);
+	//Keep level changes off the frame thread
+	simulation.SetTerrainPrefetch(2);
+	netPlaying = netPlay.localPlayer >= 0 && netPlay.localPlayer < (int)netPlay.peers.size();
+	spectating = !netPlaying && !netPlay.spectate.empty();
+	if (netPlaying)
+		simulation.SetPlayerCount(netPlay.peers.size());
+	else if (spectating)
+		simulation.SetPlayerCount(netPlay.spectatePlayers);
+	simulation.Setup(ofGetWindowWidth(), ofGetWindowHeight());
+	simulation.SetTerrainSeed(netPlaying ? netPlay.seed : ofGetUnixTime());
+	if (netPlaying)
+	{
+		UdpInputTransportParams transportParams;
+		for (int i = 0; i < (int)netPlay.peers.size(); i++)
+		{
+			if (i == netPlay.localPlayer)
+				transportParams.port = ofToInt(ofSplitString(netPlay.peers[i], ":").back());
+			else
+				transportParams.peers.push_back(netPlay.peers[i]);
+		}
+		netPlaying = netTransport.Setup(transportParams);
+	}
+	if (netPlaying)
+	{
+		RollbackParams rollbackParams;
+		rollbackParams.playerCount = netPlay.peers.size();
+		rollbackParams.localPlayer = netPlay.localPlayer;
+		rollbackParams.maxRollbackTicks = netPlay.maxRollbackTicks;
+		rollbackParams.timeStep = simulation.GetTimeStep();
+		netSession.Setup(&simulation, &netTransport, rollbackParams);
+		sceneRecorder.SetFocusPlayer(netPlay.localPlayer);
+	}
+	if (spectating)
+	{
+		StateClientParams clientParams;
+		clientParams.server = netPlay.spectate;
+		clientParams.port = netPlay.spectatePort;
+		spectating = stateClient.Setup(clientParams);
+	}
+	else if (netPlay.servePort > 0)
+	{
+		StateServerParams serverParams;
+		serverParams.port = netPlay.servePort;
+		stateServer.Start(serverParams);
+	}
+	//Before the first tick, the log starts from the world as it is now. A rollback session simulates ticks
+	//again and only knows the other players' inputs late, so it has nothing a replay could follow.
+	if (!inputRecordPath.empty() && netPlaying)
+		ofLogError("ofApp") << "--record-input doesn't work with --net-player, not recording";
+	else if (!inputRecordPath.empty() && inputRecorder.Open(inputRecordPath, simulation))
+		simulation.SetInputRecorder(&inputRecorder);
+
+	laserFrame.Setup(LaserFrameParams());
+	laserBackend.SetFrame(&laserFrame);
+	laserLod.Setup(LaserLodParams());
+
+	if (!dacAddress.empty())
+	{
+		NetworkLaserOutputParams outputParams;
+		NetworkLaserOutput::ParseAddress(dacAddress, outputParams);
+		outputParams.screenWidth = ofGetWidth();
+		outputParams.screenHeight = ofGetHeight();
+		NetworkLaserOutput* output = new NetworkLaserOutput();
+		output->Setup(outputParams);
+		laserOutputs.push_back(output);
+	}
+	if (!ildaRecordPath.empty())
+	{
+		IldaRecorderParams recorderParams;
+		recorderParams.path = ildaRecordPath;
+		recorderParams.screenWidth = ofGetWidth();
+		recorderParams.screenHeight = ofGetHeight();
+		IldaRecorder* recorder = new IldaRecorder();
+		if (recorder->Open(recorderParams))
+			laserOutputs.push_back(recorder);
+		else
+			delete recorder;
+	}
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
-	
-	if(CheckWin())
+	//Spectators only show what the server simulated
+	if (spectating)
 	{
-		ofLogNotice() << "CHICKEN DINNER";
-		lander->Sleep();
-		gameState = GameState::Landed;
+		if (stateClient.Update())
+			stateClient.Apply(simulation);
+		return;
 	}
-	if(gameState == GameState::Flying || gameState == GameState::Landing)
+
+	//Physics runs at a fixed tick regardless of the render rate
+	int steps;
+	if (netPlaying)
 	{
-		HandleControls();
-		lander->Update();
+		NetInput input;
+		input.controls = HandleControls();
+		input.flags = netStartRequested ? NetStartRound : 0;
+		steps = netSession.Advance(ofGetLastFrameTime(), input);
+		if (steps > 0)
+			netStartRequested = false;
 	}
-	
-	world.update();
+	else
+		steps = simulation.Advance(ofGetLastFrameTime(), HandleControls());
+	if (steps > 0)
+		stateServer.Publish(simulation);
 }
 
 //--------------------------------------------------------------
 void ofApp::draw(){
 	ofBackground(0);
 	ofSetColor(255);
-	//ofSetLineWidth(3);
-	surf->Draw();
-	lander->Draw();
 
-	float time = ofGetElapsedTimef();
-
-	for (int i = 0; i < circles.size(); i++) {
-		ofFill();
-		ofSetHexColor(0xf6c738);
-		circles[i].get()->draw();
+	if (simulation.GetChunkedSurface())
+	{
+		//Keep the lander centered while the terrain streams past
+		cameraX = simulation.GetLander(netPlaying ? netPlay.localPlayer : 0)->GetPosition().x - ofGetWidth() / 2.f;
 	}
 
-	for (int i = 0; i < boxes.size(); i++) {
-		ofFill();
-		ofSetHexColor(0xBF2545);
-		boxes[i].get()->draw();
+	sceneRecorder.Record(simulation, laserLod, cameraX, drawDebug, drawList);
+
+	//Detail follows the point demand of the previous frames
+	laserBackend.Draw(drawList);
+	laserLod.Update(laserFrame.GetStats(), laserFrame.GetBudget());
+	for (LaserOutput* output : laserOutputs)
+	{
+		if (output->IsReady())
+			output->SubmitFrame(laserFrame.GetPoints(), laserFrame.GetPointCount(), laserFrame.GetParams().pointsPerSecond);
+	}
+	if (drawLaserPreview)
+	{
+		laserFrame.DrawPreview();
+		return;
 	}
 
-	if(drawDebug)
-		world.getWorld()->DrawDebugData();
+	glBackend.Draw(drawList);
+}
 
+//--------------------------------------------------------------
+void ofApp::exit(){
+	simulation.SetInputRecorder(nullptr);
+	inputRecorder.Close();
+	netTransport.Close();
+	stateServer.Stop();
+	stateClient.Close();
+	//Stops the output threads before the app goes away, a recording gets its queued frames written first
+	for (LaserOutput* output : laserOutputs)
+	{
+		delete output;
+	}
+	laserOutputs.clear();
 }
 
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
 	float r = 0, h = 0, w = 0;
+	if ((netPlaying || spectating) && (key == 'r' || key == 'c' || key == 'b' || key == 'p'))
+	{
+		//Only inputs reach the other peers, anything else changing the world would split the game
+		if (key == 'p')
+			netStartRequested = true;
+		keyDownMap[key] = true;
+		return;
+	}
 	switch (key)
 	{
 	case 'r':
-		surf->GenerateSurface(surfGenerationParams);
-		lander->Reset();
+		//Same level from the start, without generating it again
+		simulation.RetryRound();
 		break;
 	case 'c':
 		r = ofRandom(4, 20);
-		circles.push_back(shared_ptr<ofxBox2dCircle>(new ofxBox2dCircle));
-		circles.back().get()->setPhysics(3.0, 0.53, 0.1);
-		circles.back().get()->setup(world.getWorld(), mouseX, mouseY, r);
+		simulation.SpawnCircle(mouseX + cameraX, mouseY, r);
 		break;
 	case 'b':
 		w = ofRandom(4, 20);
 		h = ofRandom(4, 20);
-		boxes.push_back(shared_ptr<ofxBox2dRect>(new ofxBox2dRect));
-		boxes.back().get()->setPhysics(3.0, 0.53, 0.1);
-		boxes.back().get()->setup(world.getWorld(), mouseX, mouseY, w, h);
+		simulation.SpawnBox(mouseX + cameraX, mouseY, w, h);
 		break;
 	case 'd':
 		drawDebug = !drawDebug;
 		break;
 	case 'p':
-		if(gameState == GameState::Landed)
-		{
-			surf->GenerateSurface(surfGenerationParams);
-			lander->Start(landerParams);
-			gameState = GameState::Flying;
-		}
+		simulation.StartRound();
+		break;
+	case 'l':
+		drawLaserPreview = !drawLaserPreview;
+		break;
+	case 's':
+		//Dump the current frame for comparing outside the app
+		svgBackend.SetSize(ofGetWidth(), ofGetHeight());
+		svgBackend.Draw(drawList);
+		svgBackend.Save(ofToDataPath("frame_" + ofGetTimestampString() + ".svg"));
 		break;
 	default:
 		break;
@@ -168,7 +251,9 @@ void ofApp::mouseExited(int x, int y){
 
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h){
-	surf->SetScreenSize(w, h);
+	//The arena shapes the terrain, peers keep the one they started with and spectators get the server's
+	if (!netPlaying && !spectating)
+		simulation.SetArenaSize(w, h);
 }
 
 //--------------------------------------------------------------
@@ -186,62 +271,34 @@ bool ofApp::isKeyDown(int key)
 	return keyDown->second;
 }
 
-void ofApp::HandleControls()
+LanderControls ofApp::HandleControls()
 {
+	LanderControls controls;
 	if (isKeyDown(OF_KEY_UP))
 	{
-		lander->AddThrusterStrength(0.005f);
+		controls.thrustDelta += 0.005f;
 	}
 	if (isKeyDown(OF_KEY_DOWN))
 	{
-		lander->AddThrusterStrength(-.005f);
+		controls.thrustDelta -= .005f;
 	}
 	bool right = isKeyDown(OF_KEY_RIGHT);
 	bool left = isKeyDown(OF_KEY_LEFT);
-	lander->SetRotationRate(0.f);
 	if (left) {
-		lander->SetRotationRate(-.05f);
+		controls.rotationRate = -.05f;
 		if (right)
 		{
-			lander->SetRotationRate(0.f);
+			controls.rotationRate = 0.f;
 		}
 	}
 	else if (right)
 	{
-		lander->SetRotationRate(.05f);
+		controls.rotationRate = .05f;
 	}
+	return controls;
 }
 
 //--------------------------------------------------------------
 void ofApp::dragEvent(ofDragInfo dragInfo){ 
 
 }
-
-bool ofApp::CheckWin()
-{
-	if(gameState == GameState::Landing)
-	{
-		if(lander->IsStationary())
-		{
-			if((ofGetSeconds() - LandingTimer) > 3.f)
-				return true;
-		}
-		else
-		{
-			LandingTimer = ofGetSeconds();
-		}
-	}
-	return false;
-}
-
-void ofApp::StartLanding()
-{
-	gameState = GameState::Landing;
-	ofLogNotice("Landing") << "Started";
-}
-
-void ofApp::EndLanding()
-{
-	gameState = GameState::Flying;
-	ofLogNotice("Landing") << "Ended";
-}
\ No newline at end of file
@@ -1,37 +1,72 @@
 #pragma once
 
 #include "ofMain.h"
-#include "Surface.h"
-#include "Lander.h"
-#include "ofxBox2d.h"
+#include "Simulation.h"
+#include "NetworkLaserOutput.h"
+#include "IldaRecorder.h"
+#include "SceneRecorder.h"
+#include "GlDrawBackend.h"
+#include "LaserDrawBackend.h"
+#include "SvgDrawBackend.h"
+#include "InputRecorder.h"
+#include "RollbackSession.h"
+#include "UdpInputTransport.h"
+#include "StateServer.h"
+#include "StateClient.h"
 
-class ofApp : public ofBaseApp{
-
-	Surface* surf;
-	SurfaceGenerationParams surfGenerationParams;
-
-	Lander* lander;
-	LanderParams landerParams;
+//Networked play, every peer runs the game with one lander per peer
+struct NetPlayParams {
+	int localPlayer = -1;	//-1 plays alone
+	std::vector<std::string> peers;	//host:port of every player in player order, the local entry gives the port to receive on
+	uint32_t seed = 1;	//Terrain seed, the same on every peer
+	int maxRollbackTicks = 8;
+	int servePort = 0;	//Broadcasts the world to spectators on this port, 0 doesn't
+	std::string spectate;	//host:port of a server to watch instead of playing
+	int spectatePort = 47901;	//Where states from the server come in
+	int spectatePlayers = 1;	//Has to match the server
+};
 
-	ofxBox2d world;
-	ofxBox2dRender physicsDebug;
+class ofApp : public ofBaseApp{
 
-	vector   <shared_ptr<ofxBox2dCircle> > circles; // default box2d circles
-	vector   <shared_ptr<ofxBox2dRect> >   boxes;   // defalut box2d rects
+	Simulation simulation;
+	std::string inputRecordPath;	//Input log of the session for replaying it headless, empty for none
+	InputRecorder inputRecorder;
+	NetPlayParams netPlay;
+	UdpInputTransport netTransport;
+	RollbackSession netSession;
+	bool netPlaying = false;
+	bool netStartRequested = false;	//Sent with the next tick's input, rounds start on every peer at the same tick
+	StateServer stateServer;
+	StateClient stateClient;
+	bool spectating = false;
 
 	std::map<int, bool> keyDownMap;
 
-	bool drawDebug = false;
+	//Recorded once per frame, then drawn by every backend
+	DrawList drawList;
+	SceneRecorder sceneRecorder;
+	GlDrawBackend glBackend;
+	LaserDrawBackend laserBackend;
+	SvgDrawBackend svgBackend;
 
-	enum GameState{ Flying, Landing, Landed };
-	GameState gameState;
+	LaserFrameBuilder laserFrame;
+	LaserLodController laserLod;
+	std::string dacAddress;	//host[:port] of a network DAC, empty for none
+	std::string ildaRecordPath;	//ILDA file every laser frame is recorded to, empty for none
+	std::vector<LaserOutput*> laserOutputs;
 
-	float LandingTimer;
+	bool drawDebug = false;
+	bool drawLaserPreview = false;	//Show the laser frame instead of the OpenGL scene
+	bool streamingTerrain = false;
+	float cameraX = 0.f;	//Horizontal scroll of the view, only moves with streaming terrain
 
 	public:
+		ofApp(bool streamingTerrain = false, std::string dacAddress = "", std::string ildaRecordPath = "", std::string inputRecordPath = "", NetPlayParams netPlay = NetPlayParams());
+
 		void setup();
 		void update();
 		void draw();
+		void exit();
 
 		void keyPressed(int key);
 		void keyReleased(int key);
@@ -46,10 +81,5 @@ class ofApp : public ofBaseApp{
 		void gotMessage(ofMessage msg);
 		
 		bool isKeyDown(int key);
-		void HandleControls();
-
-
-		bool CheckWin();
-		void StartLanding();
-		void EndLanding();
+		LanderControls HandleControls();
 };